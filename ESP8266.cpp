@@ -1,784 +1,2584 @@
 ///
 /// @file ESP8266.cpp
-/// @brief The implementation of class ESP8266. 
-/// @author bl_ackrain 
+/// @brief The implementation of class ESP8266.
+/// @author bl_ackrain
 /// @date 2019
 ///
- 
+
 #include "ESP8266.h"
-#include <Pokitto.h>
+#include "ESP8266Upload.h"
+#include "ESP8266Download.h"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#ifndef ESP8266_POSIX
+#include "ESP8266MbedTransport.h"
+#endif
+
+// an empty string is 0.0.0.0, any other text must be an address
+static bool toAddress(const std::string &text, IPv4Address &address)
+{
+    if(!text.empty() && !IPv4Address::isValid(text.c_str()))
+        return false;
 
+    address = IPv4Address::parse(text.c_str());
+    return true;
+}
 
+#ifndef ESP8266_POSIX
 ESP8266::ESP8266( std::uint32_t baud)
-: pinEnable(P0_21), pinReset(P0_20), pinProg(P1_1)
+: ESP8266(*new ESP8266MbedTransport(baud), *new ESP8266PokittoClock())
+{
+    this->ownsTransport = true;
+}
+#endif
+
+ESP8266::ESP8266(ESP8266Transport &transport, ESP8266Clock &clock)
+{
+    this->transport = &transport;
+    this->clock = &clock;
+    this->ownsTransport = false;
+
+    this->linkMode = LinkMode::Legacy;
+    this->compression = false;
+    this->nextSeq = 0;
+    this->inFlight = 0;
+    this->head = nullptr;
+    this->tail = nullptr;
+    this->txRequest = nullptr;
+    this->waitStrategy = WaitStrategy::Spin;
+    this->idling = false;
+    this->resetWaitStats();
+    this->resetRx();
+}
+
+ESP8266::~ESP8266()
 {
-    this->uart=new Serial(USBTX, USBRX);
-    this->uart->baud(baud);
+    while(this->head != nullptr)
+        this->cancel(*this->head);
+
+    if(this->ownsTransport)
+    {
+        delete this->transport;
+        delete this->clock;
+    }
 }
 
 bool ESP8266::begin(void)
 {
-    pinEnable = 1;
-	pinProg = 1;
-	pinReset = 1;
-	
-	return true;
+	return this->transport->begin();
 }
 
 bool ESP8266::isPresent(void)
 {
-	this->sendCommand(Commands::nop);
-	return this->receiveOk(100);
+	ESP8266Request request;
+	this->isPresentAsync(request);
+	return this->wait(request);
 }
 
-bool ESP8266::restart(void)
+void ESP8266::isPresentAsync(ESP8266Request &request)
 {
-	this->sendCommand(Commands::restart);
-	return this->receiveOk(100);
+	this->issue<Commands::nop>(request);
 }
 
-bool ESP8266::checkVersion(const std::string &version)
+bool ESP8266::restart(void)
 {
-    this->sendCommand(Commands::checkVersion);
-    this->sendString(version);
-    
-    return this->receiveOk(100);
+	ESP8266Request request;
+	this->restartAsync(request);
+	return this->wait(request);
 }
 
-std::uint16_t ESP8266::getVersion(void)
+void ESP8266::restartAsync(ESP8266Request &request)
 {
-    this->sendCommand(Commands::getVersion);
+	this->issue<Commands::restart>(request);
+}
 
-	if(this->getResponse(100) == Response::Data)
-		if(this->read16() == 2)
-			return this->read16();
+bool ESP8266::checkVersion(const std::string &version)
+{
+    ESP8266Request request;
+    this->checkVersionAsync(request, version);
+    return this->wait(request);
+}
 
-	return 0;
+void ESP8266::checkVersionAsync(ESP8266Request &request, const std::string &version)
+{
+    this->issue<Commands::checkVersion>(request, version);
 }
 
-std::string ESP8266::getVersionString(void)
+std::uint16_t ESP8266::getVersion(void)
 {
-	this->sendCommand(Commands::getVersionString);
-	return this->receiveString(200);
+    ESP8266Request request;
+    this->getVersionAsync(request);
+    this->wait(request);
+	return request.getValue16();
 }
 
-bool ESP8266::setBaudRate(const std::uint32_t baud)
+void ESP8266::getVersionAsync(ESP8266Request &request)
 {
-	this->sendCommand(Commands::setBaudRate);
-    this->sendData(reinterpret_cast<const std::uint8_t*>(&baud), sizeof(baud));
-    this->receiveOk(1000);
-    this->uart->baud(baud);
-    
-    return this->receiveOk(1000);
+    this->issue<Commands::getVersion>(request);
 }
 
-bool ESP8266::eraseConfig(void)
+std::string ESP8266::getVersionString(void)
 {
-    this->sendCommand(Commands::eraseConfig);
-    return this->receiveOk(2000);
+	std::string version;
+	ESP8266Request request;
+	this->getVersionStringAsync(request, version);
+	this->wait(request);
+	return version;
 }
 
-//
-// WiFi
-//
+void ESP8266::getVersionStringAsync(ESP8266Request &request, std::string &version)
+{
+	this->issue<Commands::getVersionString>(request, version);
+}
 
-bool ESP8266::setWifiMode(const WiFiMode mode)
+bool ESP8266::getVersionString(const CharSpan version)
 {
-    this->sendCommand(Commands::setWifiMode);
-    this->write16(static_cast<std::uint16_t>(mode));
-    return this->receiveOk(200);
+    ESP8266Request request;
+    this->getVersionStringAsync(request, version);
+    return this->wait(request);
 }
 
-WiFiMode ESP8266::getWifiMode()
+void ESP8266::getVersionStringAsync(ESP8266Request &request, const CharSpan version)
 {
-    this->sendCommand(Commands::getWifiMode);
-    if(this->getResponse(200)==Response::Data)
-    {
-        if(this->read16()==2)
-            return static_cast<WiFiMode>(this->read16());
-    }
-    return WiFiMode::Off;
+    this->issue<Commands::getVersionString>(request, version);
 }
 
-bool ESP8266::joinAP(const std::string &ssid, const std::string &passwod)
+bool ESP8266::setBaudRate(const std::uint32_t baud)
 {
-    this->sendCommand(Commands::joinAP);
+    this->waitIdle();
+
+    // the ESP8266 keeps the new rate for good, the local side must be able to follow
+    if(!this->transport->isBaudRateSupported(baud))
+        return false;
+
+    ESP8266Request request;
+    this->issue<Commands::setBaudRate>(request, baud);
 
-    this->sendString(ssid);
-    this->sendString(passwod);
+    // the first Ok comes at the old rate, the second one at the new rate
+    while(!request.isReady() && request.frameIndex == 0)
+        this->waitStep(this->waitStrategy);
+    const bool switched = this->transport->setBaudRate(baud);
 
-    return receiveOk(1000);
+    return this->wait(request) && switched;
 }
 
-WifiStatus ESP8266::getStatus(void)
+std::uint32_t ESP8266::negotiateBaudRate(const std::uint32_t* rates, const std::size_t count, std::vector<BaudRateTrial>* trials)
 {
-    this->sendCommand(Commands::getStatus);
-    if(this->getResponse(100)==Response::Data)
+    this->waitIdle();
+
+    std::uint32_t current = this->transport->getBaudRate();
+    for(std::size_t i = 0; i < count; i++)
     {
-        if(this->read16()==2)
-            return static_cast<WifiStatus>(this->read16());
+        const std::uint32_t baud = rates[i];
+
+        // a rate the local side cannot run at is never sent, the search goes on
+        if(!this->transport->isBaudRateSupported(baud))
+        {
+            const BaudRateTrial trial = { baud, 0, 1 };
+            if(trials != nullptr)
+                trials->push_back(trial);
+            continue;
+        }
+
+        // time enough for the echoes twice over, then the ESP8266 goes back by itself
+        const std::uint32_t expected = static_cast<std::uint32_t>(20000ull * ESP8266_BAUD_PROBES * (ESP8266_BAUD_PROBE_SIZE + 16) / baud);
+        const std::uint16_t hold = static_cast<std::uint16_t>(std::min<std::uint32_t>(0xFFFF, 2 * expected + 250));
+
+        const bool switched = (baud != current);
+        BaudRateTrial trial = { baud, 0, 1 };
+        if(!switched || this->probeBaudRate(baud, hold))
+            trial = this->qualify(baud);
+
+        // kept for good once the echoes passed
+        const bool passed = (trial.errors == 0) && (!switched || this->setBaudRate(baud));
+        if(!passed)
+        {
+            trial.goodput = 0;
+            trial.errors = std::max<std::uint8_t>(trial.errors, 1);
+        }
+        if(trials != nullptr)
+            trials->push_back(trial);
+
+        if(passed)
+        {
+            current = baud;
+            continue;
+        }
+
+        // the link is unreliable, wait for the ESP8266 to return and drop whatever came garbled
+        if(current != 0)
+            this->transport->setBaudRate(current);
+        const std::uint32_t start = this->clock->getTime();
+        while(this->clock->getTime() - start < static_cast<std::uint32_t>(hold) + ESP8266_LINK_GAP)
+            this->waitStep(this->waitStrategy);
+        this->transport->flushRx();
+        this->resetRx();
+        this->isPresent();
+        break;
     }
-    return WifiStatus::Idle;
-}
 
-bool ESP8266::leaveAP(void)
-{
-    this->sendCommand(Commands::leaveAP);
-    return this->receiveOk(1000);
+    return current;
 }
 
-std::string ESP8266::getSSID(void)
+bool ESP8266::probeBaudRate(const std::uint32_t baud, const std::uint16_t hold)
 {
-    this->sendCommand(Commands::getLocalIP);
-    return this->receiveString(200);
+    ESP8266Request request;
+    this->issue<Commands::probeBaudRate>(request, baud, hold);
+
+    // acknowledged at the old rate, kept by setBaudRate() before hold ms are over
+    if(!this->wait(request))
+        return false;
+
+    return this->transport->setBaudRate(baud);
 }
 
-std::int32_t ESP8266::getRSSI(void)
+BaudRateTrial ESP8266::qualify(const std::uint32_t baud)
 {
-    this->sendCommand(Commands::getRSSI);
+    BaudRateTrial trial = { baud, 0, 0 };
 
-    if(this->getResponse(200) == Response::Data)
-		if(this->read16() == 4)
-		{
-			const std::uint32_t low = this->read16();
-			const std::uint32_t high = this->read16();
-			return ((high << 16) | (low << 0));
-		}
+    // random looking, compression must not flatter the rate
+    std::uint8_t pattern[ESP8266_BAUD_PROBE_SIZE];
+    std::uint32_t seed = 0x2545F491;
+    for(std::size_t i = 0; i < sizeof(pattern); i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        pattern[i] = static_cast<std::uint8_t>(seed);
+    }
+    const std::uint16_t crc = Crc16::update(Crc16::initial, pattern, sizeof(pattern));
 
-    return 0;
-}
+    const std::uint32_t timeout = static_cast<std::uint32_t>(20000ull * (sizeof(pattern) + 16) / (baud != 0 ? baud : 1)) + 100;
+    const std::uint32_t start = this->clock->getTime();
+    for(std::size_t i = 0; i < ESP8266_BAUD_PROBES; i++)
+    {
+        std::uint8_t reply[ESP8266_BAUD_PROBE_SIZE];
+        ESP8266Request request;
+        this->echoAsync(request, pattern, sizeof(pattern), reply, timeout);
+
+        // an error burst, there is no point going on
+        if(!this->wait(request) || request.getSize() != sizeof(reply) || Crc16::update(Crc16::initial, reply, sizeof(reply)) != crc)
+        {
+            trial.errors++;
+            return trial;
+        }
+    }
 
-std::string ESP8266::getLocalIP(void)
-{
-    this->sendCommand(Commands::getLocalIP);
-    return this->receiveString(200);
+    const std::uint32_t elapsed = std::max<std::uint32_t>(1, this->clock->getTime() - start);
+    trial.goodput = static_cast<std::uint32_t>(2000ull * ESP8266_BAUD_PROBES * ESP8266_BAUD_PROBE_SIZE / elapsed);
+    return trial;
 }
 
-std::string ESP8266::getGatewayIP(void)
+bool ESP8266::echo(const std::uint8_t* data, const std::uint16_t size)
 {
-    this->sendCommand(Commands::getGatewayIP);
-    return this->receiveString(200);
+    std::vector<std::uint8_t> reply(size);
+    ESP8266Request request;
+    this->echoAsync(request, data, size, reply.data());
+    return this->wait(request) && request.getSize() == size && std::equal(reply.begin(), reply.end(), data);
 }
 
-std::string ESP8266::getSubnetMask(void)
+void ESP8266::echoAsync(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size, std::uint8_t* reply, const std::uint32_t timeout)
 {
-    this->sendCommand(Commands::getSubnetMask);
-    return this->receiveString(200);
+    this->issueWithin<Commands::echo>(request, timeout, Wire::Span{data, size}, Wire::Buffer{reply, size});
 }
 
-std::string ESP8266::getMac(void)
+bool ESP8266::eraseConfig(void)
 {
-    this->sendCommand(Commands::getMac);
-    return this->receiveString(200);
+    ESP8266Request request;
+    this->eraseConfigAsync(request);
+    return this->wait(request);
 }
 
-bool ESP8266::setStationIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet, const std::string &dns1, const std::string &dns2)
+void ESP8266::eraseConfigAsync(ESP8266Request &request)
 {
-    this->sendCommand(Commands::setStationIP);
-
-    this->sendString(local_ip);
-    this->sendString(gateway);
-    this->sendString(subnet);
-    this->sendString(dns1);
-    this->sendString(dns2);
-    
-    return this->receiveOk(1000);
+    this->issue<Commands::eraseConfig>(request);
 }
 
-bool ESP8266::scanNetworks(const bool async, const bool show_hidden, const std::uint8_t channel, const std::string &ssid)
+bool ESP8266::setLinkMode(const LinkMode mode)
 {
-    this->sendCommand(Commands::scanNetworks);
-    this->uart->putc(async?1:0);
-    this->uart->putc(show_hidden?1:0);
-    this->uart->putc(channel);
+    this->waitIdle();
 
-    this->sendString(ssid);
+    ESP8266Request request;
+    this->issue<Commands::setLinkMode>(request, static_cast<std::uint8_t>(mode));
 
-    return this->receiveOk(5000);
-}
+    // acknowledged in the old mode, the next command uses the new one
+    if(!this->wait(request))
+        return false;
 
+    this->linkMode = mode;
+    this->nextSeq = 0;
+    this->resetRx();
+    return true;
+}
 
-std::int16_t ESP8266::scanComplete(void)
+LinkMode ESP8266::getLinkMode(void) const
 {
-    this->sendCommand(Commands::scanComplete);
-    if(this->getResponse(200)!=Response::Data)
-        return -1;
-
-    if(this->read16()==2)
-        return this->read16();
-    
-    return -1;
+    return this->linkMode;
 }
 
-bool ESP8266::getNetworkInfo(const std::uint16_t id, NetworkInfo &info)
+bool ESP8266::setCompression(const bool enabled)
 {
-    this->sendCommand(Commands::getNetworkInfo);
-    this->write16(id);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return false;
+    this->waitIdle();
+
+    ESP8266Request request;
+    this->issue<Commands::setCompression>(request, enabled);
 
-    const std::uint16_t size=this->read16();
-    if(size!=sizeof(info))
+    // acknowledged as it was, the next command uses the new setting
+    if(!this->wait(request))
         return false;
-        
-    std::uint8_t* infoBytes = reinterpret_cast<std::uint8_t*>(&info);
-    for(std::size_t i = 0; i < sizeof(info); i++)
-        infoBytes[i] = this->uart->getc();
-    
+
+    this->compression = enabled;
     return true;
 }
 
-//
-// Wifi SoftAccessPoint
-//
-
-bool ESP8266::setSoftAPConfig(const std::string &ssid, const std::string &passphrase, const std::uint16_t channel)
+bool ESP8266::getCompression(void) const
 {
-    this->sendCommand(Commands::setSoftAPConfig);
-    this->write16(channel);
-    this->sendString(ssid);
-    
-    this->sendString(passphrase);
-    
-    return this->receiveOk(2000);
+    return this->compression;
 }
 
-bool ESP8266::getSoftAPConfig(std::string &ssid, std::string &passphrase)
+std::uint32_t ESP8266::getRxOverrunCount(void) const
 {
-    this->sendCommand(Commands::getSoftAPConfig);
-    
-    ssid=this->receiveString(200);
-    passphrase=this->receiveString(200);
-    return true;
+    return this->transport->getRxOverrunCount();
 }
 
-bool ESP8266::setSoftAPIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet)
+std::size_t ESP8266::getRxHighWater(void) const
 {
-    this->sendCommand(Commands::setSoftAPIP);
-
-    this->sendString(local_ip);
-    this->sendString(gateway);
-    this->sendString(subnet);
-    
-    return this->receiveOk(5000);
+    return this->transport->getRxHighWater();
 }
 
-
-bool ESP8266::getSoftAPIP(std::string &ip_address, std::string &mac)
+void ESP8266::resetRxStats(void)
 {
-    this->sendCommand(Commands::getSoftAPIP);
-    
-    ip_address=this->receiveString(200);
-    mac=this->receiveString(200);
-    return true;
+    this->transport->resetRxStats();
 }
 
-bool ESP8266::softAPdisconnect(const bool wifioff)
+#ifdef ESP8266_STATS
+const ESP8266Stats& ESP8266::getStats(void) const
 {
-    this->sendCommand(Commands::softAPdisconnect);
-    this->write16(wifioff?1:0);
-    
-    return this->receiveOk(500);
+    return this->stats;
 }
 
-std::uint16_t ESP8266::softAPgetStationNum(void)
+void ESP8266::resetStats(void)
 {
-    this->sendCommand(Commands::softAPgetStationNum);
-    if(this->getResponse(200)!=Response::Data)
-        return 0;
+    this->stats.reset();
+}
+#endif
 
-    if(this->read16()==2)
-        return this->read16();
-    
-    return 0;
+bool ESP8266::isTxIdle(void) const
+{
+    return this->transport->isTxIdle();
 }
 
-bool ESP8266::getSoftAPClient(const std::uint16_t id, std::string &ip_address, std::string &mac)
+void ESP8266::flushTx(void)
 {
-    this->sendCommand(Commands::getSoftAPClient);
-    this->write16(id);
-    
-    ip_address = this->receiveString(200);
-    mac = this->receiveString(200);
-    return (ip_address.length()!=0);
+    this->transport->flushTx();
 }
 
-// 
-//TCP
+//
+// WiFi
 //
 
-bool ESP8266::createTCP(const std::uint8_t id, const std::string &address, const std::uint16_t port)
+bool ESP8266::setWifiMode(const WiFiMode mode)
 {
-    this->sendCommand(Commands::createTCP);
-    this->uart->putc(id);
-    this->write16(port);
-    this->sendString(address);
-    
-    return this->receiveOk(3000);
+    ESP8266Request request;
+    this->setWifiModeAsync(request, mode);
+    return this->wait(request);
 }
 
-bool ESP8266::closeTCP(const std::uint8_t id)
+void ESP8266::setWifiModeAsync(ESP8266Request &request, const WiFiMode mode)
 {
-    this->sendCommand(Commands::closeTCP);
-    this->uart->putc(id);
+    this->issue<Commands::setWifiMode>(request, static_cast<std::uint16_t>(mode));
+}
 
-    return this->receiveOk(1000);
+WiFiMode ESP8266::getWifiMode()
+{
+    ESP8266Request request;
+    this->getWifiModeAsync(request);
+    this->wait(request);
+    return static_cast<WiFiMode>(request.getValue16());
 }
 
-bool ESP8266::sendTCP(const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+void ESP8266::getWifiModeAsync(ESP8266Request &request)
 {
+    this->issue<Commands::getWifiMode>(request);
+}
 
-    this->sendCommand(Commands::sendTCP);
-    this->uart->putc(id);
-    this->write16(size);
-    
-    for(std::size_t i=0; i<size;i++)
-        this->uart->putc(buffer[i]);
-    return this->receiveOk(3000);
+bool ESP8266::joinAP(const std::string &ssid, const std::string &passwod)
+{
+    ESP8266Request request;
+    this->joinAPAsync(request, ssid, passwod);
+    return this->wait(request);
 }
 
-std::uint16_t ESP8266::readTCP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+void ESP8266::joinAPAsync(ESP8266Request &request, const std::string &ssid, const std::string &passwod)
 {
-    this->sendCommand(Commands::readTCP);
-    this->uart->putc(id);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return 0;
+    this->issue<Commands::joinAP>(request, ssid, passwod);
+}
 
-    return this->readBuffer(buffer, buffer_size, timeout);
+WifiStatus ESP8266::getStatus(void)
+{
+    ESP8266Request request;
+    this->getStatusAsync(request);
+    this->wait(request);
+    return static_cast<WifiStatus>(request.getValue16());
 }
 
-bool ESP8266::availableTCP(const std::uint8_t id)
+void ESP8266::getStatusAsync(ESP8266Request &request)
 {
-    this->sendCommand(Commands::availableTCP);
-    this->uart->putc(id);
+    this->issue<Commands::getStatus>(request);
+}
 
-    return this->receiveOk(1000);
+bool ESP8266::leaveAP(void)
+{
+    ESP8266Request request;
+    this->leaveAPAsync(request);
+    return this->wait(request);
 }
 
-//
-// UDP
-//
+void ESP8266::leaveAPAsync(ESP8266Request &request)
+{
+    this->issue<Commands::leaveAP>(request);
+}
 
-bool ESP8266::createUDP(const std::uint8_t id, const std::string &address, const std::uint16_t port)
+std::string ESP8266::getSSID(void)
 {
-    this->sendCommand(Commands::createUDP);
-    this->uart->putc(id);
-    this->write16(port);
-    this->sendString(address);
-    
-    return this->receiveOk(3000);
+    std::string ssid;
+    ESP8266Request request;
+    this->getSSIDAsync(request, ssid);
+    this->wait(request);
+    return ssid;
 }
 
-bool ESP8266::closeUDP(const std::uint8_t id)
+void ESP8266::getSSIDAsync(ESP8266Request &request, std::string &ssid)
 {
-    this->sendCommand(Commands::closeUDP);
-    this->uart->putc(id);
+    this->issue<Commands::getSSID>(request, ssid);
+}
 
-    return this->receiveOk(500);
+bool ESP8266::getSSID(const CharSpan ssid)
+{
+    ESP8266Request request;
+    this->getSSIDAsync(request, ssid);
+    return this->wait(request);
 }
 
-bool ESP8266::sendUDP(const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+void ESP8266::getSSIDAsync(ESP8266Request &request, const CharSpan ssid)
 {
-    this->sendCommand(Commands::sendUDP);
-    this->uart->putc(id);
-    this->write16(size);
-    
-    for(std::size_t i=0; i<size;i++)
-        this->uart->putc(buffer[i]);
-    return this->receiveOk(1000);
+    this->issue<Commands::getSSID>(request, ssid);
 }
 
-std::uint16_t ESP8266::readUDP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+std::int32_t ESP8266::getRSSI(void)
 {
-    this->sendCommand(Commands::readUDP);
-    this->uart->putc(id);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return 0;
+    ESP8266Request request;
+    this->getRSSIAsync(request);
+    this->wait(request);
+    return static_cast<std::int32_t>(request.getValue32());
+}
 
-    return this->readBuffer(buffer, buffer_size, timeout);
+void ESP8266::getRSSIAsync(ESP8266Request &request)
+{
+    this->issue<Commands::getRSSI>(request);
 }
 
-bool ESP8266::availableUDP(const std::uint8_t id)
+std::string ESP8266::getLocalIP(void)
 {
-    this->sendCommand(Commands::availableUDP);
-    this->uart->putc(id);
+    IPv4Address address;
+    if(!this->getLocalIP(address))
+        return std::string();
 
-    return this->receiveOk(20);
+    return address.toString();
 }
 
-bool ESP8266::listenUDP(const std::uint8_t id, const std::uint16_t port)
+bool ESP8266::getLocalIP(const CharSpan ip)
 {
-    this->sendCommand(Commands::listenUDP);
-    this->uart->putc(id);
-    this->write16(port);
-    return this->receiveOk(2000);
+    IPv4Address address;
+    const bool done = this->getLocalIP(address);
+    if(done)
+        address.format(ip);
+    else if(ip.size != 0)
+        ip.data[0] = '\0';
+    return done;
 }
 
-bool ESP8266::getRemoteInfoUDP(const std::uint8_t id, std::string &address, std::uint16_t &port)
+bool ESP8266::getLocalIP(IPv4Address &ip)
 {
-    this->sendCommand(Commands::getRemoteInfoUDP);
-    this->uart->putc(id);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return false;
-
-    std::uint16_t size=this->read16();
-    if(size==2)
-        port=this->read16();
-    else
-        return false;
-        
-    address=this->receiveString(500);
-    return(address.length()!=0);
-    
+    ESP8266Request request;
+    this->getLocalIPAsync(request, ip);
+    return this->wait(request) && request.frames[0].length == sizeof(ip.octets);
 }
 
-//
-// HTTP
-//
+void ESP8266::getLocalIPAsync(ESP8266Request &request, IPv4Address &ip)
+{
+    this->issue<Commands::getLocalIPBinary>(request, ip);
+}
 
-bool ESP8266::createHTTP(const std::string &host, const std::uint16_t port, const std::string &uri, const bool is_https)
+std::string ESP8266::getGatewayIP(void)
 {
-    this->sendCommand(Commands::createHTTP);
+    IPv4Address address;
+    if(!this->getGatewayIP(address))
+        return std::string();
 
-    this->write16(is_https?1:0);
-    this->write16(port);
-    this->sendString(host);
-    this->sendString(uri);
-    
-    return this->receiveOk(3000);
+    return address.toString();
 }
 
-std::int32_t ESP8266::sendGetHTTP(const std::uint32_t timeout)
+bool ESP8266::getGatewayIP(const CharSpan ip)
 {
-    this->sendCommand(Commands::sendGetHTTP); 
- 
-    if(this->getResponse(timeout)!=Response::Data)
-        return -1;
-    if(this->read16()==4)
-    {
-        std::uint16_t low=this->read16();
-        return ((this->read16()<<16)|low);
-    }
-    return -1;
+    IPv4Address address;
+    const bool done = this->getGatewayIP(address);
+    if(done)
+        address.format(ip);
+    else if(ip.size != 0)
+        ip.data[0] = '\0';
+    return done;
 }
 
-std::string ESP8266::getStringHTTP(void)
+bool ESP8266::getGatewayIP(IPv4Address &ip)
 {
-    this->sendCommand(Commands::getStringHTTP);
-    return this->receiveString(2000);
+    ESP8266Request request;
+    this->getGatewayIPAsync(request, ip);
+    return this->wait(request) && request.frames[0].length == sizeof(ip.octets);
 }
 
-std::uint32_t ESP8266::readDataHTTP(std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+void ESP8266::getGatewayIPAsync(ESP8266Request &request, IPv4Address &ip)
 {
-    this->sendCommand(Commands::readDataHTTP);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return 0;
+    this->issue<Commands::getGatewayIPBinary>(request, ip);
+}
+
+std::string ESP8266::getSubnetMask(void)
+{
+    IPv4Address address;
+    if(!this->getSubnetMask(address))
+        return std::string();
 
-    return this->readBuffer(buffer, buffer_size, timeout);
+    return address.toString();
 }
 
-std::uint32_t ESP8266::getSizeHTTP(void)
+bool ESP8266::getSubnetMask(const CharSpan mask)
 {
-    this->sendCommand(Commands::getSizeHTTP); 
-    
-    if(this->getResponse(300)!=Response::Data)
-        return 0;
-    
-    if(this->read16()==4)
-    {
-        std::uint16_t low=this->read16();
-        return((this->read16()<<16)|low);
-    }
-    
-    return 0;
+    IPv4Address address;
+    const bool done = this->getSubnetMask(address);
+    if(done)
+        address.format(mask);
+    else if(mask.size != 0)
+        mask.data[0] = '\0';
+    return done;
 }
 
-bool ESP8266::closeHTTP(void)
+bool ESP8266::getSubnetMask(IPv4Address &mask)
 {
-    this->sendCommand(Commands::closeHTTP);
-    return this->receiveOk(200);
+    ESP8266Request request;
+    this->getSubnetMaskAsync(request, mask);
+    return this->wait(request) && request.frames[0].length == sizeof(mask.octets);
 }
 
-bool ESP8266::setFingerPrintHTTP(const std::uint8_t fingerprint[])
+void ESP8266::getSubnetMaskAsync(ESP8266Request &request, IPv4Address &mask)
 {
-    this->sendCommand(Commands::setFingerPrintHTTP); 
-    for(std::size_t i=0;i<20;i++)
-        this->uart->putc(fingerprint[i]);
-        
-    return this->receiveOk(200);
+    this->issue<Commands::getSubnetMaskBinary>(request, mask);
 }
 
-bool ESP8266::setInSecureHTTP()
+std::string ESP8266::getMac(void)
 {
-    this->sendCommand(Commands::setInSecureHTTP); 
+    MacAddress address;
+    if(!this->getMac(address))
+        return std::string();
 
-    return this->receiveOk(200);
+    return address.toString();
 }
 
-bool ESP8266::addHeaderHTTP(const std::string &name, const std::string &value)
+bool ESP8266::getMac(const CharSpan mac)
 {
-    this->sendCommand(Commands::addHeaderHTTP); 
-    this->sendString(name);
-    this->sendString(value);
-    
-    return this->receiveOk(200);
+    MacAddress address;
+    const bool done = this->getMac(address);
+    if(done)
+        address.format(mac);
+    else if(mac.size != 0)
+        mac.data[0] = '\0';
+    return done;
 }
 
-std::size_t ESP8266::getResponseHeaderCountHTTP(void)
+bool ESP8266::getMac(MacAddress &mac)
 {
-    this->sendCommand(Commands::addHeaderHTTP);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return 0;
-    
-    if(this->read16()==4)
-    {
-        std::uint16_t low=this->read16();
-        return((this->read16()<<16)|low);
-    }
-    
-    return 0;
+    ESP8266Request request;
+    this->getMacAsync(request, mac);
+    return this->wait(request) && request.frames[0].length == sizeof(mac.bytes);
 }
 
-bool ESP8266::getResponseHeaderHTTP(std::size_t id, std::string &name, std::string &value)
+void ESP8266::getMacAsync(ESP8266Request &request, MacAddress &mac)
 {
-    this->sendCommand(Commands::getResponseHeaderHTTP);
-    
-    this->sendData(reinterpret_cast<const std::uint8_t*>(&value), sizeof(value));
-    name = receiveString(200);
-    value = receiveString(200);
-    
-    return true;
+    this->issue<Commands::getMacBinary>(request, mac);
 }
 
-std::int32_t ESP8266::sendPostHttp(const std::uint8_t* payload, std::uint16_t size, std::uint32_t timeout)
+bool ESP8266::setStationIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet, const std::string &dns1, const std::string &dns2)
 {
-    this->sendCommand(Commands::sendPostHttp);
-    
-    this->write16(size);
-    
-    for(std::size_t i=0;i<size;i++)
-        this->uart->putc(payload[i]);
- 
-    if(this->getResponse(timeout)!=Response::Data)
-        return -1;
-    if(this->read16()==4)
-    {
-        std::uint16_t low=this->read16();
-        return ((this->read16()<<16)|low);
-    }
-    return -1;
+    ESP8266Request request;
+    this->setStationIPAsync(request, local_ip, gateway, subnet, dns1, dns2);
+    return this->wait(request);
 }
 
-//
-// ESP_NOW
-//
+void ESP8266::setStationIPAsync(ESP8266Request &request, const std::string &local_ip, const std::string &gateway, const std::string &subnet, const std::string &dns1, const std::string &dns2)
+{
+    IPv4Address addresses[5];
+    if(!toAddress(local_ip, addresses[0]) || !toAddress(gateway, addresses[1]) || !toAddress(subnet, addresses[2])
+        || !toAddress(dns1, addresses[3]) || !toAddress(dns2, addresses[4]))
+    {
+        this->reject(request);
+        return;
+    }
 
+    this->setStationIPAsync(request, addresses[0], addresses[1], addresses[2], addresses[3], addresses[4]);
+}
 
-bool ESP8266::espNowInit(void)
+bool ESP8266::setStationIP(const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet, const IPv4Address &dns1, const IPv4Address &dns2)
 {
-    this->sendCommand(Commands::espNowInit); 
+    ESP8266Request request;
+    this->setStationIPAsync(request, local_ip, gateway, subnet, dns1, dns2);
+    return this->wait(request);
+}
 
-    return this->receiveOk(200);
+void ESP8266::setStationIPAsync(ESP8266Request &request, const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet, const IPv4Address &dns1, const IPv4Address &dns2)
+{
+    this->issue<Commands::setStationIPBinary>(request, local_ip, gateway, subnet, dns1, dns2);
 }
 
-bool ESP8266::espNowAddPeer(const std::string &mac, std::uint8_t channel)
+bool ESP8266::scanNetworks(const bool async, const bool show_hidden, const std::uint8_t channel, const std::string &ssid)
 {
-    this->sendCommand(Commands::espNowAddPeer);
-    this->uart->putc(channel);
-    this->sendString(mac);
+    ESP8266Request request;
+    this->scanNetworksAsync(request, async, show_hidden, channel, ssid);
+    return this->wait(request);
+}
 
-    return this->receiveOk(200);
+void ESP8266::scanNetworksAsync(ESP8266Request &request, const bool async, const bool show_hidden, const std::uint8_t channel, const std::string &ssid)
+{
+    this->issue<Commands::scanNetworks>(request, async, show_hidden, channel, ssid);
 }
 
-bool ESP8266::espNowRemovePeer(const std::string &mac)
+
+std::int16_t ESP8266::scanComplete(void)
 {
-    this->sendCommand(Commands::espNowRemovePeer);
-    this->sendString(mac);
+    ESP8266Request request;
+    this->scanCompleteAsync(request);
+    if(!this->wait(request) || request.frames[0].length != 2)
+        return -1;
 
-    return this->receiveOk(200);
+    return static_cast<std::int16_t>(request.getValue16());
 }
 
-bool ESP8266::espNowSend(const std::string &mac, std::uint8_t* buffer, const std::size_t size)
+void ESP8266::scanCompleteAsync(ESP8266Request &request)
 {
-    this->sendCommand(Commands::espNowSend);
-    this->sendString(mac);
-    this->write16(size);
-    
-    for(std::size_t i=0; i<size;i++)
-        this->uart->putc(buffer[i]);
-    return this->receiveOk(1000);
+    this->issue<Commands::scanComplete>(request);
 }
 
-bool ESP8266::espNowReceive(EspNowReceiveInfo &info)
+bool ESP8266::getNetworkInfo(const std::uint16_t id, NetworkInfo &info)
 {
-    this->sendCommand(Commands::espNowReceive);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return false;
-
-    return this->readBuffer(reinterpret_cast<uint8_t*>(&info), sizeof(EspNowReceiveInfo), 200);
+    ESP8266Request request;
+    this->getNetworkInfoAsync(request, id, info);
+    return this->wait(request) && request.frames[0].length == sizeof(info);
 }
 
-bool ESP8266::espNowDeInit()
+void ESP8266::getNetworkInfoAsync(ESP8266Request &request, const std::uint16_t id, NetworkInfo &info)
 {
-    this->sendCommand(Commands::espNowDeInit); 
-
-    return this->receiveOk(200);
+    this->issue<Commands::getNetworkInfo>(request, id, Wire::Buffer{reinterpret_cast<std::uint8_t*>(&info), sizeof(info)});
 }
 
 //
-// crypto
+// Wifi SoftAccessPoint
 //
 
-
-bool ESP8266::sha1(const std::uint8_t data[], const std::uint16_t size, std::uint8_t hash[20])
+bool ESP8266::setSoftAPConfig(const std::string &ssid, const std::string &passphrase, const std::uint16_t channel)
 {
-    this->sendCommand(Commands::sha1);
-    
-    this->write16(size);
-
-    for(std::size_t i=0; i<size;i++)
-        this->uart->putc(data[i]);
-    
-    if(this->getResponse(300)!=Response::Data)
-        return false;
-
-    return this->readBuffer(hash, 20, 200);
+    ESP8266Request request;
+    this->setSoftAPConfigAsync(request, ssid, passphrase, channel);
+    return this->wait(request);
 }
 
-
-Response ESP8266::getResponse(const std::uint32_t timeout)
+void ESP8266::setSoftAPConfigAsync(ESP8266Request &request, const std::string &ssid, const std::string &passphrase, const std::uint16_t channel)
 {
-    const std::uint32_t start = Pokitto::Core::getTime();
-	while(true)
-	{
-		const std::uint32_t now = Pokitto::Core::getTime();
-		const std::uint32_t elapsed = (now - start);
-
-		if(elapsed >= timeout)
-			break;
-
-		if(this->uart->readable() > 0)
-			return static_cast<Response>(this->read16());
-	}
-
-	return Response::Error;
+    this->issue<Commands::setSoftAPConfig>(request, channel, ssid, passphrase);
 }
 
-
-bool ESP8266::receiveOk(const uint32_t timeout)
+bool ESP8266::getSoftAPConfig(std::string &ssid, std::string &passphrase)
 {
-    return this->getResponse(timeout)==Response::Ok;
+    ESP8266Request request;
+    this->getSoftAPConfigAsync(request, ssid, passphrase);
+    return this->wait(request);
 }
 
-std::string ESP8266::receiveString(const std::uint32_t timeout)
+void ESP8266::getSoftAPConfigAsync(ESP8266Request &request, std::string &ssid, std::string &passphrase)
 {
-	if(this->getResponse(timeout) != Response::String)
-		return "";
-
-	const std::size_t size = this->read16();
-
-	if(size == 0)
-		return "";
-
-	std::string result;
-	result.reserve(size);
-
-	const std::uint32_t start = Pokitto::Core::getTime();
-
-	while(true)
-	{
-		const std::uint32_t now = Pokitto::Core::getTime();
-		const std::uint32_t elapsed = (now - start);
+    this->issue<Commands::getSoftAPConfig>(request, ssid, passphrase);
+}
 
-		if(elapsed >= timeout)
-			break;
+bool ESP8266::setSoftAPIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet)
+{
+    ESP8266Request request;
+    this->setSoftAPIPAsync(request, local_ip, gateway, subnet);
+    return this->wait(request);
+}
 
-		while(this->uart->readable() > 0)
-		{
-			const char c = static_cast<char>(this->uart->getc());
+void ESP8266::setSoftAPIPAsync(ESP8266Request &request, const std::string &local_ip, const std::string &gateway, const std::string &subnet)
+{
+    IPv4Address addresses[3];
+    if(!toAddress(local_ip, addresses[0]) || !toAddress(gateway, addresses[1]) || !toAddress(subnet, addresses[2]))
+    {
+        this->reject(request);
+        return;
+    }
 
-			if(c == '\0')
-				continue;
+    this->setSoftAPIPAsync(request, addresses[0], addresses[1], addresses[2]);
+}
 
-			result += c;
+bool ESP8266::setSoftAPIP(const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet)
+{
+    ESP8266Request request;
+    this->setSoftAPIPAsync(request, local_ip, gateway, subnet);
+    return this->wait(request);
+}
 
-			if(result.size() == size)
-            {
-                result.shrink_to_fit();
-				return result;
-            }
-		}
-	}
+void ESP8266::setSoftAPIPAsync(ESP8266Request &request, const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet)
+{
+    this->issue<Commands::setSoftAPIPBinary>(request, local_ip, gateway, subnet);
+}
 
-	result.shrink_to_fit();
 
-	return result;
+bool ESP8266::getSoftAPIP(std::string &ip_address, std::string &mac)
+{
+    IPv4Address ip;
+    MacAddress address;
+    const bool done = this->getSoftAPIP(ip, address);
+    ip_address = done ? ip.toString() : std::string();
+    mac = done ? address.toString() : std::string();
+    return done;
 }
 
-void ESP8266::sendData(const std::uint8_t* data, const std::uint16_t size)
+bool ESP8266::getSoftAPIP(IPv4Address &ip_address, MacAddress &mac)
 {
-    for(std::size_t i = 0; i < size; ++i)
-		this->uart->putc(data[i]);
+    ESP8266Request request;
+    this->getSoftAPIPAsync(request, ip_address, mac);
+    return this->wait(request) && request.frames[0].length == sizeof(ip_address.octets) && request.frames[1].length == sizeof(mac.bytes);
 }
 
-std::uint16_t ESP8266::read16(void)
+void ESP8266::getSoftAPIPAsync(ESP8266Request &request, IPv4Address &ip_address, MacAddress &mac)
 {
-    const std::uint16_t low = static_cast<std::uint8_t>(this->uart->getc());
-	const std::uint16_t high = static_cast<std::uint8_t>(this->uart->getc());
-
-	return ((high << 8) | low) ;
+    this->issue<Commands::getSoftAPIPBinary>(request, ip_address, mac);
 }
 
-void ESP8266::write16(const std::uint16_t value)
+bool ESP8266::softAPdisconnect(const bool wifioff)
 {
-    const std::uint8_t low = (value & 0xFF);
-	const std::uint8_t high = ((value >> 8) & 0xFF);
-
-	this->uart->putc(low);
-	this->uart->putc(high);
+    ESP8266Request request;
+    this->softAPdisconnectAsync(request, wifioff);
+    return this->wait(request);
 }
 
-
-void ESP8266::sendCommand(const Commands command)
+void ESP8266::softAPdisconnectAsync(ESP8266Request &request, const bool wifioff)
 {
-    //flush  uart
-    while(this->uart->readable())
-        this->uart->getc();
-    this->write16(static_cast<std::uint16_t>(command));
+    this->issue<Commands::softAPdisconnect>(request, wifioff);
 }
 
-void ESP8266::sendString(const std::string &String)
+std::uint16_t ESP8266::softAPgetStationNum(void)
 {
-    this->uart->printf(String.c_str());
-    this->uart->putc('\n');
+    ESP8266Request request;
+    this->softAPgetStationNumAsync(request);
+    this->wait(request);
+    return request.getValue16();
 }
 
-std::size_t ESP8266::readBuffer(uint8_t* buffer, const std::size_t bufferSize, const std::uint32_t timeout)
+void ESP8266::softAPgetStationNumAsync(ESP8266Request &request)
 {
-    const std::size_t size = this->read16();
-    const std::size_t limit = std::min(size, bufferSize);
-    const std::uint32_t start = Pokitto::Core::getTime();
+    this->issue<Commands::softAPgetStationNum>(request);
+}
+
+bool ESP8266::getSoftAPClient(const std::uint16_t id, std::string &ip_address, std::string &mac)
+{
+    IPv4Address ip;
+    MacAddress address;
+    const bool done = this->getSoftAPClient(id, ip, address);
+    ip_address = done ? ip.toString() : std::string();
+    mac = done ? address.toString() : std::string();
+    return done;
+}
+
+bool ESP8266::getSoftAPClient(const std::uint16_t id, const CharSpan ip_address, const CharSpan mac)
+{
+    IPv4Address ip;
+    MacAddress address;
+    if(!this->getSoftAPClient(id, ip, address))
+    {
+        if(ip_address.size != 0)
+            ip_address.data[0] = '\0';
+        if(mac.size != 0)
+            mac.data[0] = '\0';
+        return false;
+    }
+
+    ip.format(ip_address);
+    address.format(mac);
+    return true;
+}
+
+bool ESP8266::getSoftAPClient(const std::uint16_t id, IPv4Address &ip_address, MacAddress &mac)
+{
+    ESP8266Request request;
+    this->getSoftAPClientAsync(request, id, ip_address, mac);
+    return this->wait(request) && request.frames[0].length == sizeof(ip_address.octets) && request.frames[1].length == sizeof(mac.bytes);
+}
+
+void ESP8266::getSoftAPClientAsync(ESP8266Request &request, const std::uint16_t id, IPv4Address &ip_address, MacAddress &mac)
+{
+    this->issue<Commands::getSoftAPClientBinary>(request, id, ip_address, mac);
+}
+
+//
+//TCP
+//
+
+bool ESP8266::createTCP(const std::uint8_t id, const std::string &address, const std::uint16_t port)
+{
+    ESP8266Request request;
+    this->createTCPAsync(request, id, address, port);
+    return this->wait(request);
+}
+
+void ESP8266::createTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::string &address, const std::uint16_t port)
+{
+    this->issue<Commands::createTCP>(request, id, port, address);
+}
+
+bool ESP8266::closeTCP(const std::uint8_t id)
+{
+    ESP8266Request request;
+    this->closeTCPAsync(request, id);
+    return this->wait(request);
+}
+
+void ESP8266::closeTCPAsync(ESP8266Request &request, const std::uint8_t id)
+{
+    this->issue<Commands::closeTCP>(request, id);
+}
+
+bool ESP8266::sendTCP(const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    ESP8266Request request;
+    this->sendTCPAsync(request, id, buffer, size);
+    return this->wait(request);
+}
+
+void ESP8266::sendTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    this->issue<Commands::sendTCP>(request, id, Wire::Span{buffer, size});
+}
+
+bool ESP8266::streamTCP(const std::uint8_t id, const std::uint8_t* buffer, const std::size_t size)
+{
+    ESP8266Upload upload(*this);
+    upload.beginTCP(id, buffer, size);
+    while(!upload.isDone())
+    {
+        this->waitStep(this->waitStrategy);
+        upload.update();
+    }
+    return !upload.isFailed();
+}
+
+void ESP8266::sendChunkTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    this->issue<Commands::sendChunkTCP>(request, id, Wire::Span{buffer, size});
+}
+
+std::uint16_t ESP8266::readTCP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->readTCPAsync(request, id, buffer, buffer_size, timeout);
+    this->wait(request);
+    return request.getSize();
+}
+
+void ESP8266::readTCPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::readTCP>(request, CommandTraits<Commands::readTCP>::timeout + timeout, id, Wire::Buffer{buffer, buffer_size});
+}
+
+std::uint16_t ESP8266::readSomeTCP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size)
+{
+    ESP8266Request request;
+    this->readSomeTCPAsync(request, id, buffer, buffer_size);
+    this->wait(request);
+    return request.getSize();
+}
+
+void ESP8266::readSomeTCPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size)
+{
+    this->issue<Commands::readSomeTCP>(request, id, buffer_size, Wire::Buffer{buffer, buffer_size});
+}
+
+bool ESP8266::availableTCP(const std::uint8_t id)
+{
+    ESP8266Request request;
+    this->availableTCPAsync(request, id);
+    return this->wait(request);
+}
+
+void ESP8266::availableTCPAsync(ESP8266Request &request, const std::uint8_t id)
+{
+    this->issue<Commands::availableTCP>(request, id);
+}
+
+bool ESP8266::isConnectedTCP(const std::uint8_t id)
+{
+    ESP8266Request request;
+    this->isConnectedTCPAsync(request, id);
+    return this->wait(request);
+}
+
+void ESP8266::isConnectedTCPAsync(ESP8266Request &request, const std::uint8_t id)
+{
+    this->issue<Commands::isConnectedTCP>(request, id);
+}
+
+//
+// UDP
+//
+
+bool ESP8266::createUDP(const std::uint8_t id, const std::string &address, const std::uint16_t port)
+{
+    ESP8266Request request;
+    this->createUDPAsync(request, id, address, port);
+    return this->wait(request);
+}
+
+void ESP8266::createUDPAsync(ESP8266Request &request, const std::uint8_t id, const std::string &address, const std::uint16_t port)
+{
+    this->issue<Commands::createUDP>(request, id, port, address);
+}
+
+bool ESP8266::closeUDP(const std::uint8_t id)
+{
+    ESP8266Request request;
+    this->closeUDPAsync(request, id);
+    return this->wait(request);
+}
+
+void ESP8266::closeUDPAsync(ESP8266Request &request, const std::uint8_t id)
+{
+    this->issue<Commands::closeUDP>(request, id);
+}
+
+bool ESP8266::sendUDP(const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    ESP8266Request request;
+    this->sendUDPAsync(request, id, buffer, size);
+    return this->wait(request);
+}
+
+void ESP8266::sendUDPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    this->issue<Commands::sendUDP>(request, id, Wire::Span{buffer, size});
+}
+
+std::uint16_t ESP8266::readUDP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->readUDPAsync(request, id, buffer, buffer_size, timeout);
+    this->wait(request);
+    return request.getSize();
+}
+
+void ESP8266::readUDPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::readUDP>(request, CommandTraits<Commands::readUDP>::timeout + timeout, id, Wire::Buffer{buffer, buffer_size});
+}
+
+bool ESP8266::availableUDP(const std::uint8_t id)
+{
+    ESP8266Request request;
+    this->availableUDPAsync(request, id);
+    return this->wait(request);
+}
+
+void ESP8266::availableUDPAsync(ESP8266Request &request, const std::uint8_t id)
+{
+    this->issue<Commands::availableUDP>(request, id);
+}
+
+bool ESP8266::listenUDP(const std::uint8_t id, const std::uint16_t port)
+{
+    ESP8266Request request;
+    this->listenUDPAsync(request, id, port);
+    return this->wait(request);
+}
+
+void ESP8266::listenUDPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint16_t port)
+{
+    this->issue<Commands::listenUDP>(request, id, port);
+}
+
+bool ESP8266::getRemoteInfoUDP(const std::uint8_t id, std::string &address, std::uint16_t &port)
+{
+    ESP8266Request request;
+    this->getRemoteInfoUDPAsync(request, id, address);
+    this->wait(request);
+
+    if(request.frames[0].length != 2 || request.frameIndex == 0)
+        return false;
+
+    port = static_cast<std::uint16_t>(request.value[0] | (request.value[1] << 8));
+    return(address.length()!=0);
+
+}
+
+void ESP8266::getRemoteInfoUDPAsync(ESP8266Request &request, const std::uint8_t id, std::string &address)
+{
+    this->issue<Commands::getRemoteInfoUDP>(request, id, address);
+}
+
+//
+// sockets
+//
+
+bool ESP8266::getSocketStatus(SocketStatus &status)
+{
+    ESP8266Request request;
+    this->getSocketStatusAsync(request, status);
+    return this->wait(request) && request.frames[0].length == sizeof(status);
+}
+
+void ESP8266::getSocketStatusAsync(ESP8266Request &request, SocketStatus &status)
+{
+    this->issue<Commands::getSocketStatus>(request, Wire::Buffer{reinterpret_cast<std::uint8_t*>(&status), sizeof(status)});
+}
+
+//
+// HTTP
+//
+
+bool ESP8266::createHTTP(const std::string &host, const std::uint16_t port, const std::string &uri, const bool is_https)
+{
+    ESP8266Request request;
+    this->createHTTPAsync(request, host, port, uri, is_https);
+    return this->wait(request);
+}
+
+void ESP8266::createHTTPAsync(ESP8266Request &request, const std::string &host, const std::uint16_t port, const std::string &uri, const bool is_https)
+{
+    this->issue<Commands::createHTTP>(request, is_https, port, host, uri);
+}
+
+std::int32_t ESP8266::sendGetHTTP(const std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->sendGetHTTPAsync(request, timeout);
+    if(!this->wait(request) || request.frames[0].length != 4)
+        return -1;
+
+    return static_cast<std::int32_t>(request.getValue32());
+}
+
+void ESP8266::sendGetHTTPAsync(ESP8266Request &request, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::sendGetHTTP>(request, timeout);
+}
+
+std::string ESP8266::getStringHTTP(void)
+{
+    std::string body;
+    ESP8266Request request;
+    this->getStringHTTPAsync(request, body);
+    this->wait(request);
+    return body;
+}
+
+void ESP8266::getStringHTTPAsync(ESP8266Request &request, std::string &body)
+{
+    this->issue<Commands::getStringHTTP>(request, body);
+}
+
+std::uint32_t ESP8266::readDataHTTP(std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->readDataHTTPAsync(request, buffer, buffer_size, timeout);
+    this->wait(request);
+    return request.getSize();
+}
+
+void ESP8266::readDataHTTPAsync(ESP8266Request &request, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::readDataHTTP>(request, CommandTraits<Commands::readDataHTTP>::timeout + timeout, Wire::Buffer{buffer, buffer_size});
+}
+
+void ESP8266::readChunkHTTPAsync(ESP8266Request &request, std::uint8_t* buffer, const std::uint16_t buffer_size)
+{
+    this->issue<Commands::readChunkHTTP>(request, buffer_size, Wire::Buffer{buffer, buffer_size});
+}
+
+bool ESP8266::downloadHTTP(const std::function<bool(const std::uint8_t* data, std::uint16_t size)> &handler, const std::uint16_t chunk_size)
+{
+    ESP8266Download download(*this, chunk_size);
+    download.beginHTTP(handler);
+    while(!download.isDone())
+    {
+        this->waitStep(this->waitStrategy);
+        download.update();
+    }
+    return !download.isFailed();
+}
+
+std::uint32_t ESP8266::getSizeHTTP(void)
+{
+    ESP8266Request request;
+    this->getSizeHTTPAsync(request);
+    this->wait(request);
+    return request.getValue32();
+}
+
+void ESP8266::getSizeHTTPAsync(ESP8266Request &request)
+{
+    this->issue<Commands::getSizeHTTP>(request);
+}
+
+bool ESP8266::closeHTTP(void)
+{
+    ESP8266Request request;
+    this->closeHTTPAsync(request);
+    return this->wait(request);
+}
+
+void ESP8266::closeHTTPAsync(ESP8266Request &request)
+{
+    this->issue<Commands::closeHTTP>(request);
+}
+
+bool ESP8266::setReuseHTTP(const bool reuse)
+{
+    ESP8266Request request;
+    this->setReuseHTTPAsync(request, reuse);
+    return this->wait(request);
+}
+
+void ESP8266::setReuseHTTPAsync(ESP8266Request &request, const bool reuse)
+{
+    this->issue<Commands::setReuseHTTP>(request, reuse);
+}
+
+bool ESP8266::setFingerPrintHTTP(const std::uint8_t fingerprint[])
+{
+    ESP8266Request request;
+    this->setFingerPrintHTTPAsync(request, fingerprint);
+    return this->wait(request);
+}
+
+void ESP8266::setFingerPrintHTTPAsync(ESP8266Request &request, const std::uint8_t fingerprint[])
+{
+    this->issue<Commands::setFingerPrintHTTP>(request, fingerprint);
+}
+
+bool ESP8266::setInSecureHTTP()
+{
+    ESP8266Request request;
+    this->setInSecureHTTPAsync(request);
+    return this->wait(request);
+}
+
+void ESP8266::setInSecureHTTPAsync(ESP8266Request &request)
+{
+    this->issue<Commands::setInSecureHTTP>(request);
+}
+
+bool ESP8266::addHeaderHTTP(const std::string &name, const std::string &value)
+{
+    ESP8266Request request;
+    this->addHeaderHTTPAsync(request, name, value);
+    return this->wait(request);
+}
+
+void ESP8266::addHeaderHTTPAsync(ESP8266Request &request, const std::string &name, const std::string &value)
+{
+    this->issue<Commands::addHeaderHTTP>(request, name, value);
+}
+
+std::size_t ESP8266::getResponseHeaderCountHTTP(void)
+{
+    ESP8266Request request;
+    this->getResponseHeaderCountHTTPAsync(request);
+    this->wait(request);
+    return request.getValue32();
+}
+
+void ESP8266::getResponseHeaderCountHTTPAsync(ESP8266Request &request)
+{
+    this->issue<Commands::getResponseHeaderCountHTTP>(request);
+}
+
+bool ESP8266::getResponseHeaderHTTP(std::size_t id, std::string &name, std::string &value)
+{
+    ESP8266Request request;
+    this->getResponseHeaderHTTPAsync(request, id, name, value);
+    this->wait(request);
+
+    return true;
+}
+
+void ESP8266::getResponseHeaderHTTPAsync(ESP8266Request &request, std::size_t id, std::string &name, std::string &value)
+{
+    this->issue<Commands::getResponseHeaderHTTP>(request, static_cast<std::uint32_t>(id), name, value);
+}
+
+std::int32_t ESP8266::sendPostHttp(const std::uint8_t* payload, std::uint16_t size, std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->sendPostHttpAsync(request, payload, size, timeout);
+    if(!this->wait(request) || request.frames[0].length != 4)
+        return -1;
+
+    return static_cast<std::int32_t>(request.getValue32());
+}
+
+void ESP8266::sendPostHttpAsync(ESP8266Request &request, const std::uint8_t* payload, std::uint16_t size, std::uint32_t timeout)
+{
+    this->issueWithin<Commands::sendPostHttp>(request, timeout, Wire::Span{payload, size});
+}
+
+std::int32_t ESP8266::requestHTTP(const HttpRequest &http, HttpResponse &response, const std::uint32_t timeout)
+{
+    ESP8266Request request;
+    this->requestHTTPAsync(request, http, response, timeout);
+    this->wait(request);
+    return response.getCode();
+}
+
+void ESP8266::requestHTTPAsync(ESP8266Request &request, const HttpRequest &http, HttpResponse &response, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::requestHTTP>(request, timeout, http, Wire::Span{http.body, http.bodySize}, response.raw);
+}
+
+std::int32_t ESP8266::streamHTTP(const HttpRequest &http, const std::function<std::size_t(std::uint8_t* buffer, std::size_t size)> &producer, HttpResponse &response, const std::uint32_t length, const std::uint16_t chunk_size)
+{
+    ESP8266Request request;
+    this->beginStreamHTTPAsync(request, http, length);
+    if(!this->wait(request))
+    {
+        response.raw.clear();
+        return response.getCode();
+    }
+
+    // the buffer is reused once the ESP8266 took the previous chunk
+    std::vector<std::uint8_t> buffer(chunk_size != 0 ? chunk_size : 1);
+    while(true)
+    {
+        const std::size_t size = std::min(producer(buffer.data(), buffer.size()), buffer.size());
+        if(size == 0)
+            break;
+
+        this->sendStreamHTTPAsync(request, buffer.data(), static_cast<std::uint16_t>(size));
+        if(!this->wait(request))
+        {
+            // ending the stream would send the last chunk, and the server
+            // could accept the truncated body, so the connection is dropped
+            this->closeHTTP();
+            response.raw.clear();
+            return httpErrorSendPayloadFailed;
+        }
+    }
+
+    this->endStreamHTTPAsync(request, response);
+    this->wait(request);
+    return response.getCode();
+}
+
+std::int32_t ESP8266::streamHTTP(const HttpRequest &http, std::FILE* file, HttpResponse &response, const std::uint16_t chunk_size)
+{
+    // a known length when the file can seek, chunked otherwise
+    std::uint32_t length = 0xFFFFFFFF;
+    const long position = std::ftell(file);
+    if(position >= 0 && std::fseek(file, 0, SEEK_END) == 0)
+    {
+        const long end = std::ftell(file);
+        if(std::fseek(file, position, SEEK_SET) == 0 && end >= position)
+            length = static_cast<std::uint32_t>(end - position);
+    }
+
+    return this->streamHTTP(http, [file](std::uint8_t* buffer, std::size_t size)
+    {
+        return std::fread(buffer, 1, size, file);
+    }, response, length, chunk_size);
+}
+
+void ESP8266::beginStreamHTTPAsync(ESP8266Request &request, const HttpRequest &http, const std::uint32_t length)
+{
+    this->issue<Commands::beginStreamHTTP>(request, http, length);
+}
+
+void ESP8266::sendStreamHTTPAsync(ESP8266Request &request, const std::uint8_t* buffer, const std::uint16_t size)
+{
+    this->issue<Commands::sendStreamHTTP>(request, Wire::Span{buffer, size});
+}
+
+void ESP8266::endStreamHTTPAsync(ESP8266Request &request, HttpResponse &response, const std::uint32_t timeout)
+{
+    this->issueWithin<Commands::endStreamHTTP>(request, timeout, response.raw);
+}
+
+void ESP8266::sendHttpRequest(const HttpRequest &http)
+{
+    this->writeByte(http.https ? 1 : 0);
+    this->write16(http.port);
+    this->sendString(http.host);
+    this->sendString(http.uri);
+    this->sendString(http.method);
+
+    const std::uint8_t headerCount = static_cast<std::uint8_t>(std::min<std::size_t>(http.headers.size(), 0xFF));
+    this->writeByte(headerCount);
+    for(std::size_t i = 0; i < headerCount; i++)
+    {
+        this->sendString(http.headers[i].first);
+        this->sendString(http.headers[i].second);
+    }
+
+    const std::uint8_t collectCount = static_cast<std::uint8_t>(std::min<std::size_t>(http.responseHeaders.size(), 0xFF));
+    this->writeByte(collectCount);
+    for(std::size_t i = 0; i < collectCount; i++)
+        this->sendString(http.responseHeaders[i]);
+}
+
+//
+// ESP_NOW
+//
+
+
+bool ESP8266::espNowInit(void)
+{
+    ESP8266Request request;
+    this->espNowInitAsync(request);
+    return this->wait(request);
+}
+
+void ESP8266::espNowInitAsync(ESP8266Request &request)
+{
+    this->issue<Commands::espNowInit>(request);
+}
+
+bool ESP8266::espNowAddPeer(const std::string &mac, std::uint8_t channel)
+{
+    ESP8266Request request;
+    this->espNowAddPeerAsync(request, mac, channel);
+    return this->wait(request);
+}
+
+void ESP8266::espNowAddPeerAsync(ESP8266Request &request, const std::string &mac, std::uint8_t channel)
+{
+    if(!MacAddress::isValid(mac.c_str()))
+    {
+        this->reject(request);
+        return;
+    }
+
+    this->espNowAddPeerAsync(request, MacAddress::parse(mac.c_str()), channel);
+}
+
+bool ESP8266::espNowAddPeer(const MacAddress &mac, std::uint8_t channel)
+{
+    ESP8266Request request;
+    this->espNowAddPeerAsync(request, mac, channel);
+    return this->wait(request);
+}
+
+void ESP8266::espNowAddPeerAsync(ESP8266Request &request, const MacAddress &mac, std::uint8_t channel)
+{
+    this->issue<Commands::espNowAddPeerBinary>(request, channel, mac);
+}
+
+bool ESP8266::espNowRemovePeer(const std::string &mac)
+{
+    ESP8266Request request;
+    this->espNowRemovePeerAsync(request, mac);
+    return this->wait(request);
+}
+
+void ESP8266::espNowRemovePeerAsync(ESP8266Request &request, const std::string &mac)
+{
+    if(!MacAddress::isValid(mac.c_str()))
+    {
+        this->reject(request);
+        return;
+    }
+
+    this->espNowRemovePeerAsync(request, MacAddress::parse(mac.c_str()));
+}
+
+bool ESP8266::espNowRemovePeer(const MacAddress &mac)
+{
+    ESP8266Request request;
+    this->espNowRemovePeerAsync(request, mac);
+    return this->wait(request);
+}
+
+void ESP8266::espNowRemovePeerAsync(ESP8266Request &request, const MacAddress &mac)
+{
+    this->issue<Commands::espNowRemovePeerBinary>(request, mac);
+}
+
+bool ESP8266::espNowSend(const std::string &mac, std::uint8_t* buffer, const std::size_t size)
+{
+    ESP8266Request request;
+    this->espNowSendAsync(request, mac, buffer, size);
+    return this->wait(request);
+}
+
+void ESP8266::espNowSendAsync(ESP8266Request &request, const std::string &mac, const std::uint8_t* buffer, const std::size_t size)
+{
+    // an empty string sends to all peers, as the zero address does
+    if(!mac.empty() && !MacAddress::isValid(mac.c_str()))
+    {
+        this->reject(request);
+        return;
+    }
+
+    this->espNowSendAsync(request, MacAddress::parse(mac.c_str()), buffer, size);
+}
+
+bool ESP8266::espNowSend(const MacAddress &mac, const std::uint8_t* buffer, const std::size_t size)
+{
+    ESP8266Request request;
+    this->espNowSendAsync(request, mac, buffer, size);
+    return this->wait(request);
+}
+
+void ESP8266::espNowSendAsync(ESP8266Request &request, const MacAddress &mac, const std::uint8_t* buffer, const std::size_t size)
+{
+    this->issue<Commands::espNowSendBinary>(request, mac, Wire::Span{buffer, static_cast<std::uint16_t>(size)});
+}
+
+bool ESP8266::espNowReceive(EspNowReceiveInfo &info)
+{
+    ESP8266Request request;
+    this->espNowReceiveAsync(request, info);
+    this->wait(request);
+    return request.getSize() != 0;
+}
+
+void ESP8266::espNowReceiveAsync(ESP8266Request &request, EspNowReceiveInfo &info)
+{
+    this->issue<Commands::espNowReceive>(request, Wire::Buffer{reinterpret_cast<std::uint8_t*>(&info), sizeof(EspNowReceiveInfo)});
+}
+
+bool ESP8266::espNowDeInit()
+{
+    ESP8266Request request;
+    this->espNowDeInitAsync(request);
+    return this->wait(request);
+}
+
+void ESP8266::espNowDeInitAsync(ESP8266Request &request)
+{
+    this->issue<Commands::espNowDeInit>(request);
+}
+
+//
+// crypto
+//
+
+
+bool ESP8266::sha1(const std::uint8_t data[], const std::uint16_t size, std::uint8_t hash[20])
+{
+    ESP8266Request request;
+    this->sha1Async(request, data, size, hash);
+    this->wait(request);
+    return request.getSize() != 0;
+}
+
+void ESP8266::sha1Async(ESP8266Request &request, const std::uint8_t data[], const std::uint16_t size, std::uint8_t hash[20])
+{
+    this->issue<Commands::sha1>(request, Wire::Span{data, size}, Wire::Buffer{hash, 20});
+}
+
+//
+// events
+//
+
+bool ESP8266::setEventMask(const std::uint16_t mask)
+{
+    ESP8266Request request;
+    this->setEventMaskAsync(request, mask);
+    return this->wait(request);
+}
+
+void ESP8266::setEventMaskAsync(ESP8266Request &request, const std::uint16_t mask)
+{
+    this->issue<Commands::setEventMask>(request, mask);
+}
+
+void ESP8266::onEvent(const EventType type, const std::function<void(const Event&)> &handler)
+{
+    const std::size_t index = static_cast<std::size_t>(type);
+    if(index < eventTypeCount)
+        this->eventHandlers[index] = handler;
+}
+
+void ESP8266::dispatchEvent(void)
+{
+    Event event;
+    event.type = static_cast<EventType>(this->rxEvent[0]);
+    event.id = this->rxEvent[1];
+    event.value = static_cast<std::uint16_t>(this->rxEvent[2] | (this->rxEvent[3] << 8));
+
+    const std::size_t index = static_cast<std::size_t>(event.type);
+    if(index < eventTypeCount && this->eventHandlers[index])
+        this->eventHandlers[index](event);
+}
+
+//
+// Command marshalling, generated from the CommandTraits descriptors
+//
+
+template<Commands command, typename... Arguments>
+void ESP8266::issue(ESP8266Request &request, Arguments&&... arguments)
+{
+    this->issueWithin<command>(request, CommandTraits<command>::timeout, std::forward<Arguments>(arguments)...);
+}
+
+template<Commands command, typename... Arguments>
+void ESP8266::issueWithin(ESP8266Request &request, const std::uint32_t timeout, Arguments&&... arguments)
+{
+    typedef CommandTraits<command> Traits;
+
+    this->beginCommand(request, command, timeout);
+    this->marshal(request, typename Traits::Fields(), typename Traits::Replies(), std::forward<Arguments>(arguments)...);
+    this->endCommand(request);
+}
+
+template<typename Field, typename... Fields, typename... Replies, typename Argument, typename... Arguments>
+void ESP8266::marshal(ESP8266Request &request, WireList<Field, Fields...>, WireList<Replies...> replies, Argument &&argument, Arguments&&... arguments)
+{
+    // no silent conversion, a field gets exactly the type of its descriptor
+    static_assert(std::is_same<typename std::decay<Argument>::type, typename Field::Type>::value,
+        "the argument does not match the field of the command descriptor");
+
+    this->put(request, Field(), argument);
+    this->marshal(request, WireList<Fields...>(), replies, std::forward<Arguments>(arguments)...);
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::marshal(ESP8266Request &request, WireList<>, WireList<Replies...> replies, Targets&&... targets)
+{
+    this->expectReplies(request, replies, std::forward<Targets>(targets)...);
+}
+
+void ESP8266::expectReplies(ESP8266Request &request, WireList<>)
+{
+    (void)request;
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::Ok, Replies...>, Targets&&... targets)
+{
+    request.expectOk();
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::Value, Replies...>, Targets&&... targets)
+{
+    request.expectValue();
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+template<typename... Replies, typename Target, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::String, Replies...>, Target &&target, Targets&&... targets)
+{
+    static_assert(std::is_same<typename std::remove_reference<Target>::type, std::string>::value ||
+        std::is_same<typename std::decay<Target>::type, CharSpan>::value,
+        "a string reply goes to a std::string or a CharSpan");
+
+    this->expectString(request, target);
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::Data, Replies...>, const Wire::Buffer &target, Targets&&... targets)
+{
+    request.expectData(target.data, target.capacity);
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::IPv4, Replies...>, IPv4Address &target, Targets&&... targets)
+{
+    request.expectData(target.octets, sizeof(target.octets));
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+template<typename... Replies, typename... Targets>
+void ESP8266::expectReplies(ESP8266Request &request, WireList<Wire::Mac, Replies...>, MacAddress &target, Targets&&... targets)
+{
+    request.expectData(target.bytes, sizeof(target.bytes));
+    this->expectReplies(request, WireList<Replies...>(), std::forward<Targets>(targets)...);
+}
+
+void ESP8266::expectString(ESP8266Request &request, std::string &target)
+{
+    request.expectString(target);
+}
+
+void ESP8266::expectString(ESP8266Request &request, const CharSpan &target)
+{
+    request.expectString(target.data, target.size);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::U8, const std::uint8_t value)
+{
+    (void)request;
+    this->writeByte(value);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::U16, const std::uint16_t value)
+{
+    (void)request;
+    this->write16(value);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::U32, const std::uint32_t value)
+{
+    (void)request;
+    this->write16(static_cast<std::uint16_t>(value & 0xFFFF));
+    this->write16(static_cast<std::uint16_t>(value >> 16));
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Bool, const bool value)
+{
+    (void)request;
+    this->writeByte(value ? 1 : 0);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Bool16, const bool value)
+{
+    (void)request;
+    this->write16(value ? 1 : 0);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Text, const std::string &value)
+{
+    (void)request;
+    this->sendString(value);
+}
+
+template<std::size_t Size>
+void ESP8266::put(ESP8266Request &request, Wire::Raw<Size>, const std::uint8_t* value)
+{
+    (void)request;
+    this->writeBytes(value, Size);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Payload, const Wire::Span &value)
+{
+    this->sendPayload(request, value.data, value.size);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Http, const HttpRequest &value)
+{
+    (void)request;
+    this->sendHttpRequest(value);
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::IPv4, const IPv4Address &value)
+{
+    (void)request;
+    this->writeBytes(value.octets, sizeof(value.octets));
+}
+
+void ESP8266::put(ESP8266Request &request, Wire::Mac, const MacAddress &value)
+{
+    (void)request;
+    this->writeBytes(value.bytes, sizeof(value.bytes));
+}
+
+void ESP8266::reject(ESP8266Request &request)
+{
+    // never sent, it fails at once as a refused command would
+    this->cancel(request);
+    request.reset();
+    request.owner = this;
+    request.status = RequestStatus::Failed;
+    if(request.callback)
+        request.callback(request);
+}
+
+//
+// Requests
+//
+
+void ESP8266::beginCommand(ESP8266Request &request, const Commands command, const std::uint32_t timeout)
+{
+    this->cancel(request);
+
+    while(this->isBusy())
+        this->waitStep(this->waitStrategy);
+
+    if(this->linkMode == LinkMode::Legacy)
+    {
+        //flush  uart, nobody is waiting for what is there
+        this->transport->flushRx();
+        this->resetRx();
+    }
+
+    this->transport->markCommand(static_cast<std::uint16_t>(command));
+
+    request.reset();
+    request.owner = this;
+    request.command = command;
+    request.status = RequestStatus::Pending;
+    request.timeout = timeout;
+    request.start = this->clock->getTime();
+    request.next = nullptr;
+#ifdef ESP8266_STATS
+    request.issued = request.start;
+#endif
+
+    if(this->tail != nullptr)
+        this->tail->next = &request;
+    else
+        this->head = &request;
+    this->tail = &request;
+    this->inFlight++;
+
+    if(this->linkMode != LinkMode::Legacy)
+    {
+        // 0 is never used, so a zeroed byte can not match a request
+        this->nextSeq = (this->nextSeq == 0xFF) ? 1 : this->nextSeq + 1;
+        request.seq = this->nextSeq;
+    }
+
+    // framed commands are staged until endCommand()
+    if(this->linkMode == LinkMode::Framed)
+        this->txRequest = &request;
+    else if(this->linkMode == LinkMode::Pipelined)
+        this->writeByte(request.seq);
+
+    this->write16(static_cast<std::uint16_t>(command));
+}
+
+void ESP8266::endCommand(ESP8266Request &request)
+{
+    if(this->txRequest != &request)
+        return;
+
+    this->txRequest = nullptr;
+    this->transmit(request);
+}
+
+void ESP8266::transmit(ESP8266Request &request)
+{
+    const std::size_t length = request.frame.size() + request.bulkSize;
+    if(length > 0xFFFF)
+    {
+        this->finish(request, RequestStatus::Failed);
+        return;
+    }
+
+    // the oldest request still waiting tells the ESP8266 which sequence
+    // numbers were given up on and will not come again
+    const std::uint8_t header[6] =
+    {
+        linkSync[0],
+        linkSync[1],
+        request.seq,
+        (this->head != nullptr) ? this->head->seq : request.seq,
+        static_cast<std::uint8_t>(length & 0xFF),
+        static_cast<std::uint8_t>(length >> 8),
+    };
+
+    std::uint16_t crc = Crc16::update(Crc16::initial, header + 2, 4);
+    crc = Crc16::update(crc, request.frame.data(), request.frame.size());
+    crc = Crc16::update(crc, request.bulk, request.bulkSize);
+
+    request.start = this->clock->getTime();
+    this->transport->write(header, sizeof(header));
+    this->transport->write(request.frame.data(), request.frame.size());
+
+    if(request.bulkSize != 0)
+    {
+        request.sending = true;
+
+        ESP8266Clock* clock = this->clock;
+        this->transport->writeBulk(request.bulk, request.bulkSize, [&request, clock]()
+        {
+            request.start = clock->getTime();
+            request.sending = false;
+        });
+    }
+
+    const std::uint8_t trailer[2] = { static_cast<std::uint8_t>(crc & 0xFF), static_cast<std::uint8_t>(crc >> 8) };
+    this->transport->write(trailer, sizeof(trailer));
+}
 
-    std::size_t index = 0;
+void ESP8266::resend(void)
+{
+    // whatever is being received belongs to the frames sent again
+    this->resetRx();
+
+    // go back: the ESP8266 runs commands in order and answers the ones it
+    // already ran from its reply history, only the oldest one was lost
+    ESP8266Request* request = this->head;
+    if(request != nullptr && ++request->retries > ESP8266_LINK_RETRIES)
+        request = request->next;
 
-    while(index < limit)
+    while(request != nullptr)
     {
-        const std::uint32_t now = Pokitto::Core::getTime();
-        const std::uint32_t elapsed = (now - start);
+        request->restart();
+        this->transmit(*request);
+        request = request->next;
+    }
 
-        if(elapsed >= timeout)
-            break;
+    // callbacks may change the queue, so start over after each failure
+    while(true)
+    {
+        request = this->head;
+        while(request != nullptr && request->retries <= ESP8266_LINK_RETRIES)
+            request = request->next;
+
+        if(request == nullptr)
+            return;
+
+        this->finish(*request, RequestStatus::Failed);
+    }
+}
+
+bool ESP8266::wait(ESP8266Request &request)
+{
+    return this->wait(request, this->waitStrategy);
+}
+
+bool ESP8266::wait(ESP8266Request &request, const WaitStrategy strategy)
+{
+    while(request.status == RequestStatus::Pending)
+        this->waitStep(strategy);
+
+    return request.status == RequestStatus::Done;
+}
+
+void ESP8266::waitIdle(void)
+{
+    while(this->head != nullptr)
+        this->waitStep(this->waitStrategy);
+}
+
+void ESP8266::waitStep(const WaitStrategy strategy)
+{
+    // a blocking call from the idle handler spins, its time is the handler's
+    if(this->idling)
+    {
+        this->poll();
+        return;
+    }
+
+    const std::uint32_t start = this->clock->getTime();
+    this->poll();
+    this->waitStats.polls++;
+
+    if(strategy == WaitStrategy::Yield && this->idleHandler)
+    {
+        const std::uint32_t before = this->clock->getTime();
+        this->idling = true;
+        this->idleHandler();
+        this->idling = false;
+        this->waitStats.yieldTime += this->clock->getTime() - before;
+    }
+    else if(strategy == WaitStrategy::Sleep && this->transport->available() == 0)
+    {
+        // one millisecond at most, the timeouts are checked in time
+        const std::uint32_t before = this->clock->getTime();
+        this->transport->waitForRx(1);
+        this->waitStats.sleepTime += this->clock->getTime() - before;
+    }
+
+    this->waitStats.waitTime += this->clock->getTime() - start;
+}
+
+void ESP8266::setWaitStrategy(const WaitStrategy strategy)
+{
+    this->waitStrategy = strategy;
+}
+
+WaitStrategy ESP8266::getWaitStrategy(void) const
+{
+    return this->waitStrategy;
+}
+
+void ESP8266::setIdleHandler(const std::function<void(void)> &handler)
+{
+    this->idleHandler = handler;
+}
+
+const WaitStats& ESP8266::getWaitStats(void) const
+{
+    return this->waitStats;
+}
+
+void ESP8266::resetWaitStats(void)
+{
+    this->waitStats = WaitStats();
+}
+
+void ESP8266::cancel(ESP8266Request &request)
+{
+    if(request.status != RequestStatus::Pending || request.owner != this)
+        return;
+
+    // the transmitter may still read the payload
+    if(request.sending)
+        this->transport->flushTx();
+
+    this->finish(request, RequestStatus::Idle);
+}
+
+void ESP8266::finish(ESP8266Request &request, const RequestStatus status)
+{
+    ESP8266Request* previous = nullptr;
+    ESP8266Request* current = this->head;
+    while(current != nullptr && current != &request)
+    {
+        previous = current;
+        current = current->next;
+    }
+
+    if(current == nullptr)
+        return;
+
+    if(previous != nullptr)
+        previous->next = request.next;
+    else
+        this->head = request.next;
+    if(this->tail == &request)
+        this->tail = previous;
+
+    request.next = nullptr;
+    request.status = status;
+    this->inFlight--;
+
+    // the rest of a reply being received is dropped
+    if(this->rxRequest == &request)
+    {
+        this->rxRequest = nullptr;
+        this->rxSink = false;
+    }
+    if(this->rxLinkRequest == &request)
+        this->rxLinkRequest = nullptr;
+    if(this->txRequest == &request)
+        this->txRequest = nullptr;
+
+    // the ESP8266 comes back in legacy mode, uncompressed
+    if(request.command == Commands::restart && status == RequestStatus::Done)
+    {
+        this->linkMode = LinkMode::Legacy;
+        this->compression = false;
+    }
+
+#ifdef ESP8266_STATS
+    if(status != RequestStatus::Idle)
+    {
+        this->stats.record(static_cast<std::uint16_t>(request.command), status == RequestStatus::Timeout, status == RequestStatus::Failed,
+            this->clock->getTime() - request.issued, request.bytesSent, request.bytesReceived);
+    }
+#endif
+
+    // last, the callback may start the next request with this one
+    if(status != RequestStatus::Idle && request.callback)
+        request.callback(request);
+}
+
+void ESP8266::checkTimeouts(void)
+{
+    // a frame stopped halfway, a byte was lost
+    if(this->linkMode == LinkMode::Framed && this->rxState != RxState::FrameSync)
+    {
+        if((this->clock->getTime() - this->rxTime) >= ESP8266_LINK_GAP)
+            this->endLinkFrame(false);
+    }
+
+    // callbacks may change the queue, so start over after each timeout
+    while(true)
+    {
+        ESP8266Request* request = this->head;
+        while(request != nullptr)
+        {
+            // the timeout starts once the payload is out, the clock is read
+            // after start so an interrupt moving it can not wrap elapsed
+            if(!request->sending)
+            {
+                const std::uint32_t start = request->start;
+                const std::uint32_t elapsed = (this->clock->getTime() - start);
+                if(elapsed >= request->timeout)
+                    break;
+            }
+
+            request = request->next;
+        }
+
+        if(request == nullptr)
+            return;
+
+        // the command or its reply may have been lost as a whole
+        if(this->linkMode == LinkMode::Framed && request->retries < ESP8266_LINK_RETRIES)
+        {
+            this->resend();
+            return;
+        }
+
+        this->finish(*request, RequestStatus::Timeout);
+    }
+}
+
+void ESP8266::poll(void)
+{
+    this->receive();
+    this->checkTimeouts();
+}
+
+bool ESP8266::isBusy(void) const
+{
+    const std::uint8_t depth = (this->linkMode == LinkMode::Legacy) ? 1 : ESP8266_PIPELINE_DEPTH;
+    return this->inFlight >= depth;
+}
+
+std::uint32_t ESP8266::getTime(void) const
+{
+    return this->clock->getTime();
+}
+
+//
+// Receive
+//
+
+void ESP8266::resetRx(void)
+{
+    if(this->linkMode == LinkMode::Framed)
+        this->rxState = RxState::FrameSync;
+    else if(this->linkMode == LinkMode::Pipelined)
+        this->rxState = RxState::Seq;
+    else
+        this->rxState = RxState::Code;
+
+    this->rxCount = 0;
+    this->rxCode = Response::Error;
+    this->rxRemaining = 0;
+    this->rxRequest = nullptr;
+    this->rxSink = false;
+    this->rxDecoder.reset();
+    this->rxUnpacked = 0;
+
+    this->rxLinkRequest = nullptr;
+    this->rxLinkStatus = RequestStatus::Pending;
+    this->rxResend = false;
+    this->rxLinkRemaining = 0;
+    this->rxCrc = Crc16::initial;
+    this->rxTime = this->clock->getTime();
+
+    this->rxEventSize = 0;
+    this->rxEventFrame = false;
+    this->rxEventReady = false;
+}
+
+ESP8266Request* ESP8266::findRequest(const std::uint8_t seq)
+{
+    ESP8266Request* request = this->head;
+    while(request != nullptr && request->seq != seq)
+        request = request->next;
+
+    // a late reply to a request that timed out
+    if(request == nullptr)
+        return nullptr;
+
+    // frames sent again may overtake older replies
+    if(this->linkMode == LinkMode::Framed)
+        return request;
+
+    // replies come in order, the requests before this one lost theirs
+    while(this->head != nullptr && this->head != request)
+        this->finish(*this->head, RequestStatus::Failed);
+
+    // unless a callback dropped it meanwhile
+    return (this->head == request) ? request : nullptr;
+}
+
+std::size_t ESP8266::receiveBytes(std::uint8_t* data, const std::size_t size)
+{
+    if(this->linkMode != LinkMode::Framed)
+        return this->transport->read(data, size);
+
+    // inside a frame, only up to its end, and checked
+    const bool payload = (this->rxState == RxState::Code || this->rxState == RxState::Length || this->rxState == RxState::Payload);
+    const std::size_t count = this->transport->read(data, payload ? std::min<std::size_t>(size, this->rxLinkRemaining) : size);
+    if(count == 0)
+        return 0;
+
+    this->rxTime = this->clock->getTime();
+    if(payload)
+    {
+        this->rxCrc = Crc16::update(this->rxCrc, data, count);
+        this->rxLinkRemaining -= count;
+    }
+    return count;
+}
+
+bool ESP8266::receiveHeader(const std::uint8_t size)
+{
+    while(this->rxCount < size)
+    {
+        if(this->receiveBytes(&this->rxHeader[this->rxCount], 1) != 1)
+            return false;
+        this->rxCount++;
+    }
+
+    this->rxCount = 0;
+    return true;
+}
+
+void ESP8266::receiveFrame(void)
+{
+    const std::uint8_t seq = this->rxHeader[0];
+    this->rxCrc = Crc16::update(Crc16::initial, this->rxHeader, 3);
+    this->rxLinkRemaining = static_cast<std::uint16_t>(this->rxHeader[1] | (this->rxHeader[2] << 8));
+    this->rxLinkStatus = RequestStatus::Pending;
+    this->rxResend = false;
+    this->rxLinkRequest = (seq != 0) ? this->findRequest(seq) : nullptr;
+    this->rxEventFrame = (seq == 0);
+    this->rxEventSize = 0;
+    this->rxEventReady = false;
+
+    this->rxState = (this->rxLinkRemaining != 0) ? RxState::Code : RxState::FrameCrc;
+}
+
+void ESP8266::endLinkFrame(const bool valid)
+{
+    ESP8266Request* request = this->rxLinkRequest;
+    const RequestStatus status = this->rxLinkStatus;
+    const bool resend = this->rxResend;
+    const bool event = this->rxEventReady;
+
+    this->resetRx();
+
+    if(!valid || resend)
+    {
+        this->resend();
+        return;
+    }
+
+    // resetRx() leaves the event bytes alone
+    if(event)
+        this->dispatchEvent();
+
+    if(request != nullptr && status != RequestStatus::Pending)
+        this->finish(*request, status);
+}
+
+void ESP8266::receive(void)
+{
+    while(true)
+    {
+        switch(this->rxState)
+        {
+            case RxState::FrameSync:
+            {
+                std::uint8_t value;
+                if(this->transport->read(&value, 1) != 1)
+                    return;
+
+                if(value == linkSync[this->rxCount])
+                    this->rxCount++;
+                else
+                    this->rxCount = (value == linkSync[0]) ? 1 : 0;
+
+                if(this->rxCount == sizeof(linkSync))
+                {
+                    this->rxCount = 0;
+                    this->rxTime = this->clock->getTime();
+                    this->rxState = RxState::FrameHeader;
+                }
+                break;
+            }
+
+            case RxState::FrameHeader:
+                if(!this->receiveHeader(3))
+                    return;
+
+                this->receiveFrame();
+                break;
+
+            case RxState::FrameCrc:
+                if(!this->receiveHeader(2))
+                    return;
+
+                this->endLinkFrame(this->rxCrc == static_cast<std::uint16_t>(this->rxHeader[0] | (this->rxHeader[1] << 8)));
+                break;
+
+            case RxState::Seq:
+            {
+                std::uint8_t seq;
+                if(this->transport->read(&seq, 1) != 1)
+                    return;
+
+                // sequence number 0 carries events
+                this->rxRequest = (seq != 0) ? this->findRequest(seq) : nullptr;
+                this->rxEventFrame = (seq == 0);
+                this->rxEventSize = 0;
+                this->rxState = RxState::Code;
+                break;
+            }
+
+            case RxState::Code:
+                // every response of the frame is in
+                if(this->linkMode == LinkMode::Framed && this->rxLinkRemaining == 0 && this->rxCount == 0)
+                {
+                    this->rxState = RxState::FrameCrc;
+                    break;
+                }
+
+                if(!this->receiveHeader(2))
+                    return;
+
+                this->rxCode = static_cast<Response>(this->rxHeader[0] | (this->rxHeader[1] << 8));
+
+                if(this->linkMode == LinkMode::Legacy)
+                {
+                    this->rxRequest = this->head;
+
+                    // nobody is waiting, there is no way to know where this ends
+                    if(this->rxRequest == nullptr)
+                    {
+                        this->transport->flushRx();
+                        this->resetRx();
+                        return;
+                    }
+                }
+                else if(this->linkMode == LinkMode::Framed)
+                {
+                    if(this->rxCode == Response::Resend && this->rxLinkRequest == nullptr)
+                        this->rxResend = true;
+
+                    this->rxRequest = (this->rxLinkStatus == RequestStatus::Pending) ? this->rxLinkRequest : nullptr;
+                }
+
+#ifdef ESP8266_STATS
+                if(this->rxRequest != nullptr)
+                    this->rxRequest->bytesReceived += 2;
+#endif
+
+                if(this->rxCode == Response::Data || this->rxCode == Response::String || this->rxCode == Response::Event ||
+                   this->rxCode == Response::PackedData || this->rxCode == Response::PackedString)
+                    this->rxState = RxState::Length;
+                else
+                    this->endFrame();
+                break;
+
+            case RxState::Length:
+                if(this->linkMode == LinkMode::Framed && this->rxLinkRemaining == 0)
+                {
+                    this->endLinkFrame(false);
+                    break;
+                }
+
+                if(!this->receiveHeader(2))
+                    return;
+
+                this->rxRemaining = static_cast<std::uint16_t>(this->rxHeader[0] | (this->rxHeader[1] << 8));
+                this->beginFrame();
+
+                if(this->rxRemaining == 0)
+                    this->endFrame();
+                else
+                    this->rxState = RxState::Payload;
+                break;
+
+            case RxState::Payload:
+                if(this->linkMode == LinkMode::Framed && this->rxLinkRemaining == 0)
+                {
+                    this->endLinkFrame(false);
+                    break;
+                }
+
+                if(this->transport->available() == 0)
+                    return;
+
+                this->receivePayload();
+
+                if(this->rxRemaining == 0)
+                    this->endFrame();
+                break;
+        }
+    }
+}
+
+void ESP8266::beginFrame(void)
+{
+    this->rxSink = false;
+    if(this->rxRequest == nullptr)
+        return;
+
+#ifdef ESP8266_STATS
+    this->rxRequest->bytesReceived += 2 + this->rxRemaining;
+#endif
+
+    ESP8266Request::Frame &frame = this->rxRequest->frames[this->rxRequest->frameIndex];
+    frame.length = this->rxRemaining;
+    frame.size = 0;
+    this->rxDecoder.reset();
+    this->rxUnpacked = 0;
+
+    this->rxSink = (frame.expected == this->rxCode) ||
+        (frame.expected == Response::Data && this->rxCode == Response::PackedData) ||
+        (frame.expected == Response::String && this->rxCode == Response::PackedString);
+    if(this->rxSink && frame.string != nullptr)
+        frame.string->reserve(this->rxRemaining);
+}
+
+void ESP8266::receivePayload(void)
+{
+    ESP8266Request::Frame* frame = nullptr;
+    if(this->rxSink)
+        frame = &this->rxRequest->frames[this->rxRequest->frameIndex];
+
+    const bool packed = (this->rxCode == Response::PackedData || this->rxCode == Response::PackedString);
+
+    // straight into the caller's buffer, strings keep room for their NUL
+    if(!packed && frame != nullptr && frame->buffer != nullptr && frame->size < this->frameLimit(*frame))
+    {
+        const std::size_t room = this->frameLimit(*frame) - frame->size;
+        const std::size_t count = this->receiveBytes(frame->buffer + frame->size, std::min<std::size_t>(this->rxRemaining, room));
+        frame->size += count;
+        this->rxRemaining -= count;
+        if(frame->expected == Response::String)
+            frame->buffer[frame->size] = '\0';
+        return;
+    }
+
+    // strings, and whatever does not fit, go through a small chunk
+    std::uint8_t chunk[32];
+    const std::size_t count = this->receiveBytes(chunk, std::min<std::size_t>(this->rxRemaining, sizeof(chunk)));
+    this->rxRemaining -= count;
+
+    if(this->rxEventFrame && this->rxCode == Response::Event)
+    {
+        for(std::size_t i = 0; i < count && this->rxEventSize < sizeof(this->rxEvent); i++)
+            this->rxEvent[this->rxEventSize++] = chunk[i];
+        return;
+    }
+
+    if(frame != nullptr && packed)
+    {
+        this->unpack(*frame, chunk, count);
+        return;
+    }
+
+    if(frame == nullptr || frame->string == nullptr)
+        return;
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        if(chunk[i] == '\0')
+            continue;
+
+        frame->string->push_back(static_cast<char>(chunk[i]));
+        frame->size++;
+    }
+}
+
+void ESP8266::unpack(ESP8266Request::Frame &frame, const std::uint8_t* data, const std::size_t size)
+{
+    for(std::size_t i = 0; i < size; i++)
+    {
+        std::uint8_t literal, length;
+        std::uint16_t distance;
+        switch(this->rxDecoder.feed(data[i], literal, distance, length))
+        {
+            case Lzss::Decoder::Token::Literal:
+                this->unpackByte(frame, literal);
+                break;
+
+            case Lzss::Decoder::Token::Match:
+                // copied from the bytes already unpacked, those past the buffer are dropped anyway
+                for(std::uint8_t j = 0; j < length && distance <= this->rxUnpacked; j++)
+                {
+                    const std::size_t from = this->rxUnpacked - distance;
+                    std::uint8_t value = 0;
+                    if(frame.string != nullptr)
+                        value = static_cast<std::uint8_t>((*frame.string)[from]);
+                    else if(frame.buffer != nullptr && from < frame.size)
+                        value = frame.buffer[from];
+                    this->unpackByte(frame, value);
+                }
+                break;
+
+            case Lzss::Decoder::Token::None:
+                break;
+        }
+    }
+}
+
+void ESP8266::unpackByte(ESP8266Request::Frame &frame, const std::uint8_t value)
+{
+    // strings keep their NUL bytes until the end, matches count them
+    if(frame.string != nullptr)
+    {
+        frame.string->push_back(static_cast<char>(value));
+    }
+    else if(frame.buffer != nullptr && this->rxUnpacked < this->frameLimit(frame))
+    {
+        frame.buffer[this->rxUnpacked] = value;
+        frame.size++;
+        if(frame.expected == Response::String)
+            frame.buffer[frame.size] = '\0';
+    }
+    this->rxUnpacked++;
+}
+
+std::uint16_t ESP8266::frameLimit(const ESP8266Request::Frame &frame) const
+{
+    if(frame.expected == Response::String)
+        return frame.capacity - 1;
+
+    return frame.capacity;
+}
+
+void ESP8266::endFrame(void)
+{
+    ESP8266Request* request = this->rxRequest;
+    Response code = this->rxCode;
+
+    // a compressed reply counts as its plain form
+    if(code == Response::PackedData || code == Response::PackedString)
+    {
+        if(this->rxSink)
+        {
+            ESP8266Request::Frame &frame = request->frames[request->frameIndex];
+            frame.length = this->rxUnpacked;
+            if(frame.string != nullptr)
+            {
+                frame.string->erase(std::remove(frame.string->begin(), frame.string->end(), '\0'), frame.string->end());
+                frame.size = static_cast<std::uint16_t>(frame.string->size());
+            }
+        }
+        code = (code == Response::PackedData) ? Response::Data : Response::String;
+    }
+
+    // a string in the caller's buffer drops its NUL bytes once complete
+    if(this->rxSink && code == Response::String)
+    {
+        ESP8266Request::Frame &frame = request->frames[request->frameIndex];
+        if(frame.buffer != nullptr)
+        {
+            char* text = reinterpret_cast<char*>(frame.buffer);
+            frame.size = static_cast<std::uint16_t>(std::remove(text, text + frame.size, '\0') - text);
+            text[frame.size] = '\0';
+        }
+    }
+
+    this->rxRequest = nullptr;
+    this->rxSink = false;
+    this->rxState = (this->linkMode == LinkMode::Pipelined) ? RxState::Seq : RxState::Code;
+
+    if(request == nullptr)
+    {
+        // a framed event only counts once its CRC is checked
+        if(this->rxEventFrame && code == Response::Event && this->rxEventSize == sizeof(this->rxEvent))
+        {
+            if(this->linkMode == LinkMode::Framed)
+                this->rxEventReady = true;
+            else
+                this->dispatchEvent();
+        }
+        return;
+    }
+
+    request->response = code;
+
+    RequestStatus status = RequestStatus::Pending;
+    if(code != request->frames[request->frameIndex].expected)
+        status = RequestStatus::Failed;
+    else if(++request->frameIndex == request->frameCount)
+        status = RequestStatus::Done;
+
+    // a framed reply only counts once its CRC is checked
+    if(this->linkMode == LinkMode::Framed)
+        this->rxLinkStatus = status;
+    else if(status != RequestStatus::Pending)
+        this->finish(*request, status);
+}
+
+//
+// Transmit
+//
+
+void ESP8266::sendData(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size)
+{
+#ifdef ESP8266_STATS
+    request.bytesSent += size;
+#endif
+
+    // framed payloads go out with the frame, and again if it is lost
+    if(this->txRequest == &request)
+    {
+        request.bulk = data;
+        request.bulkSize = size;
+        return;
+    }
+
+    request.sending = true;
+
+    ESP8266Clock* clock = this->clock;
+    this->transport->writeBulk(data, size, [&request, clock]()
+    {
+        request.start = clock->getTime();
+        request.sending = false;
+    });
+}
 
-        buffer[index] = this->uart->getc();
-        index++;
+void ESP8266::sendPayload(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size)
+{
+    this->write16(size);
+
+    // compressed, the packed size follows, the same as size when sent as it is
+    if(this->compression)
+    {
+        if(size >= ESP8266_PACK_THRESHOLD && Lzss::encode(data, size, request.packed))
+        {
+            const std::uint16_t packedSize = static_cast<std::uint16_t>(request.packed.size());
+            this->write16(packedSize);
+            this->sendData(request, request.packed.data(), packedSize);
+            return;
+        }
+        this->write16(size);
     }
 
-    return index;
-}
\ No newline at end of file
+    if(size != 0)
+        this->sendData(request, data, size);
+}
+
+void ESP8266::writeByte(const std::uint8_t value)
+{
+    this->writeBytes(&value, 1);
+}
+
+void ESP8266::writeBytes(const std::uint8_t* data, const std::size_t size)
+{
+#ifdef ESP8266_STATS
+    // only commands being written come here
+    if(this->tail != nullptr)
+        this->tail->bytesSent += size;
+#endif
+
+    if(this->txRequest != nullptr)
+        this->txRequest->frame.insert(this->txRequest->frame.end(), data, data + size);
+    else
+        this->transport->write(data, size);
+}
+
+void ESP8266::write16(const std::uint16_t value)
+{
+    const std::uint8_t low = (value & 0xFF);
+	const std::uint8_t high = ((value >> 8) & 0xFF);
+
+	const std::uint8_t bytes[2] = { low, high };
+	this->writeBytes(bytes, sizeof(bytes));
+}
+
+void ESP8266::sendString(const std::string &String)
+{
+    this->writeBytes(reinterpret_cast<const std::uint8_t*>(String.data()), String.length());
+    this->writeByte('\n');
+}
@@ -1,93 +1,94 @@
 
 #pragma once
 
-#include <mbed.h>
 #include <string>
+#include <cstdio>
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <vector>
+#include "ESP8266Transport.h"
+#include "ESP8266Request.h"
+#include "ESP8266Commands.h"
+#include "ESP8266Http.h"
+#include "Crc16.h"
+#include "Lzss.h"
+#include "InlineString.h"
+#include "ESP8266Stats.h"
 
+/// Number of commands that may wait for their reply at the same time in
+/// LinkMode::Pipelined, the coprocessor receive buffer must hold them all.
+#ifndef ESP8266_PIPELINE_DEPTH
+#define ESP8266_PIPELINE_DEPTH 4
+#endif
 
-enum class Commands: std::uint16_t
-{
-    nop=1,
-    restart,
-    checkVersion,
-    getVersion,
-    getVersionString,
-    setBaudRate,
-    eraseConfig,
-    // Wifi
-    setWifiMode,
-    getWifiMode,
-    joinAP,
-    getStatus,
-    leaveAP,
-    getSSID,
-    getRSSI,
-    getLocalIP,
-    getGatewayIP,
-    getSubnetMask,
-    getMac,
-    setStationIP,
-    scanNetworks,
-    scanComplete,
-    getNetworkInfo,
-    //wifi softAP
-    setSoftAPConfig,
-    getSoftAPConfig,
-    setSoftAPIP,
-    getSoftAPIP,
-    softAPdisconnect,
-    softAPgetStationNum,
-    getSoftAPClient,
-    //TCP client
-    createTCP,
-    sendTCP,
-    availableTCP,
-    readTCP,
-    closeTCP,
-    isConnectedTCP,
-    //UDP
-    createUDP,
-    sendUDP,
-    listenUDP,
-    availableUDP,
-    closeUDP,
-    readUDP,
-    getRemoteInfoUDP,
-    //http client
-    createHTTP,
-    sendGetHTTP,
-    getStringHTTP,
-    readDataHTTP,
-    getSizeHTTP,
-    closeHTTP,
-    setFingerPrintHTTP,
-    setInSecureHTTP,
-    addHeaderHTTP,
-    getResponseHeaderCountHTTP,
-    getResponseHeaderHTTP,
-    sendPostHttp,
-    // ESP-NOW https://docs.espressif.com/projects/esp-idf/en/latest/api-reference/network/esp_now.html
-    espNowInit,
-    espNowAddPeer,
-    espNowRemovePeer,
-    espNowSend,
-    espNowReceive,
-    espNowDeInit,
+/// Number of times a command is sent again in LinkMode::Framed before its
+/// request fails.
+#ifndef ESP8266_LINK_RETRIES
+#define ESP8266_LINK_RETRIES 3
+#endif
 
-    // crypto
-    sha1,
+/// Milliseconds without a byte after which a partly received frame is
+/// dropped in LinkMode::Framed.
+#ifndef ESP8266_LINK_GAP
+#define ESP8266_LINK_GAP 20
+#endif
+
+/// Largest piece of a streamed send, see ESP8266Upload.
+#ifndef ESP8266_STREAM_CHUNK
+#define ESP8266_STREAM_CHUNK 1024
+#endif
+
+/// Smallest payload compressed once setCompression() is on, shorter ones
+/// gain too little to be worth the time.
+#ifndef ESP8266_PACK_THRESHOLD
+#define ESP8266_PACK_THRESHOLD 32
+#endif
+
+/// Echoes of ESP8266_BAUD_PROBE_SIZE bytes run by negotiateBaudRate() at
+/// every rate, they must all come back intact.
+#ifndef ESP8266_BAUD_PROBES
+#define ESP8266_BAUD_PROBES 8
+#endif
+
+#ifndef ESP8266_BAUD_PROBE_SIZE
+#define ESP8266_BAUD_PROBE_SIZE 256
+#endif
+
+enum class LinkMode: std::uint8_t
+{
+    /// One command at a time, replies carry no tag.
+    Legacy = 0,
+    /// Commands and replies carry a sequence number, several commands may be in flight.
+    Pipelined = 1,
+    /// Like Pipelined, with every command and reply in a checked frame, lost frames are sent again.
+    Framed = 2,
 };
 
-enum class Response: std::uint16_t
+/// @brief
+/// How the blocking calls spend the time until the ESP8266 answers.
+///
+enum class WaitStrategy: std::uint8_t
 {
-	Ok = 1,
-	Error,
-	String,
-	Data,
+    /// Poll without a pause, the lowest latency.
+    Spin = 0,
+    /// Call the idle handler between polls, to keep the game running.
+    Yield,
+    /// Sleep until a byte arrives or the next millisecond, to save power.
+    Sleep,
 };
 
+/// @brief
+/// First two bytes of every frame in LinkMode::Framed.
+///
+/// A frame is the sync bytes, a sequence number, the payload length (u16),
+/// the payload and a Crc16 of everything after the sync bytes. A command
+/// frame holds one command with its arguments and has the oldest sequence
+/// number the driver still waits for right after its own. A reply frame
+/// holds the responses to one command.
+///
+constexpr std::uint8_t linkSync[2] = { 0xA5, 0x5A };
+
 enum class WiFiMode 
 {
     Off = 0,
@@ -127,6 +128,74 @@ struct NetworkInfo
     bool isHidden;
 };
 
+enum class EventType : std::uint8_t
+{
+    /// Data arrived on a TCP socket, value is the number of bytes readable.
+    TcpReadable = 0,
+    /// The peer closed a TCP socket.
+    TcpClosed = 1,
+    /// A datagram arrived on a UDP socket, value is the number of bytes readable.
+    UdpReadable = 2,
+    /// An ESP-NOW message arrived, value is its size.
+    EspNowReceived = 3,
+    /// The station status changed, value is the new WifiStatus.
+    WifiStatusChanged = 4,
+};
+
+/// @brief
+/// A notification pushed by the ESP8266.
+///
+struct Event
+{
+    EventType type;
+    /// Socket id of the socket events, 0 otherwise.
+    std::uint8_t id;
+    std::uint16_t value;
+};
+
+/// @brief
+/// State of every TCP and UDP link id, bit n and entry n are about id n.
+///
+struct SocketStatus
+{
+    /// Bit set when the TCP link is connected.
+    std::uint8_t tcpConnected;
+    /// Bit set when the UDP link is open.
+    std::uint8_t udpOpen;
+    /// Bytes readable on each TCP link.
+    std::uint16_t tcpAvailable[5];
+    /// Size of the next datagram waiting on each UDP link, 0 for none.
+    std::uint16_t udpAvailable[5];
+};
+
+/// @brief
+/// A rate tried by ESP8266::negotiateBaudRate().
+///
+struct BaudRateTrial
+{
+    std::uint32_t baud;
+    /// Payload bytes per second through the echoes, both ways together, 0 when they failed.
+    std::uint32_t goodput;
+    /// Echoes lost or changed on the way.
+    std::uint8_t errors;
+};
+
+/// @brief
+/// Where the time of the blocking calls went, see ESP8266::getWaitStats().
+/// Milliseconds, sampled at the clock resolution.
+///
+struct WaitStats
+{
+    /// Time spent waiting for the ESP8266.
+    std::uint32_t waitTime;
+    /// Part of it asleep, with WaitStrategy::Sleep.
+    std::uint32_t sleepTime;
+    /// Part of it in the idle handler, with WaitStrategy::Yield.
+    std::uint32_t yieldTime;
+    /// Number of polls made while waiting.
+    std::uint32_t polls;
+};
+
 struct EspNowReceiveInfo
 {
     std::uint8_t Sender[6];
@@ -140,26 +209,156 @@ struct EspNowReceiveInfo
 class ESP8266
 {
 private:
-	Serial* uart;
+	enum class RxState: std::uint8_t
+	{
+		Seq,
+		Code,
+		Length,
+		Payload,
+		FrameSync,
+		FrameHeader,
+		FrameCrc,
+	};
 
-	DigitalOut pinEnable;
-	DigitalOut pinReset;
-	DigitalOut pinProg;
+	static const std::size_t eventTypeCount = 5;
 
-private:
-    std::string receiveString(const std::uint32_t timeout);
-    bool receiveOk(const std::uint32_t timeout);
-    Response getResponse(const std::uint32_t timeout);
+	ESP8266Transport* transport;
+	ESP8266Clock* clock;
+	bool ownsTransport;
+
+	LinkMode linkMode;
+	bool compression;
+	std::uint8_t nextSeq;
+	std::uint8_t inFlight;
+	ESP8266Request* head;
+	ESP8266Request* tail;
+
+	RxState rxState;
+	std::uint8_t rxHeader[3];
+	std::uint8_t rxCount;
+	Response rxCode;
+	std::uint16_t rxRemaining;
+	ESP8266Request* rxRequest;
+	bool rxSink;
+	Lzss::Decoder rxDecoder;
+	std::uint16_t rxUnpacked;
 
-    void sendData(const std::uint8_t* data, const std::uint16_t size);
-    std::uint16_t read16(void);
+	ESP8266Request* txRequest;
+	ESP8266Request* rxLinkRequest;
+	RequestStatus rxLinkStatus;
+	bool rxResend;
+	std::uint16_t rxLinkRemaining;
+	std::uint16_t rxCrc;
+	std::uint32_t rxTime;
+
+	std::function<void(const Event&)> eventHandlers[eventTypeCount];
+	std::uint8_t rxEvent[4];
+	std::uint8_t rxEventSize;
+	bool rxEventFrame;
+	bool rxEventReady;
+
+	WaitStrategy waitStrategy;
+	std::function<void(void)> idleHandler;
+	bool idling;
+	WaitStats waitStats;
+
+#ifdef ESP8266_STATS
+	ESP8266Stats stats;
+#endif
+
+private:
+    void beginCommand(ESP8266Request &request, const Commands command, const std::uint32_t timeout);
+    void endCommand(ESP8266Request &request);
+    void transmit(ESP8266Request &request);
+    void resend(void);
+    void sendData(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size);
+    void sendPayload(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size);
+    void writeByte(const std::uint8_t value);
+    void writeBytes(const std::uint8_t* data, const std::size_t size);
     void write16(const std::uint16_t value);
-    void sendCommand(const Commands command);
     void sendString(const std::string &String);
-    std::size_t readBuffer(std::uint8_t* buffer, const std::size_t bufferSize, const std::uint32_t timeout);
+    void sendHttpRequest(const HttpRequest &http);
+
+    template<Commands command, typename... Arguments>
+    void issue(ESP8266Request &request, Arguments&&... arguments);
+    template<Commands command, typename... Arguments>
+    void issueWithin(ESP8266Request &request, const std::uint32_t timeout, Arguments&&... arguments);
+    template<typename Field, typename... Fields, typename... Replies, typename Argument, typename... Arguments>
+    void marshal(ESP8266Request &request, WireList<Field, Fields...>, WireList<Replies...> replies, Argument &&argument, Arguments&&... arguments);
+    template<typename... Replies, typename... Targets>
+    void marshal(ESP8266Request &request, WireList<>, WireList<Replies...> replies, Targets&&... targets);
+    void expectReplies(ESP8266Request &request, WireList<>);
+    template<typename... Replies, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::Ok, Replies...>, Targets&&... targets);
+    template<typename... Replies, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::Value, Replies...>, Targets&&... targets);
+    template<typename... Replies, typename Target, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::String, Replies...>, Target &&target, Targets&&... targets);
+    template<typename... Replies, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::Data, Replies...>, const Wire::Buffer &target, Targets&&... targets);
+    template<typename... Replies, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::IPv4, Replies...>, IPv4Address &target, Targets&&... targets);
+    template<typename... Replies, typename... Targets>
+    void expectReplies(ESP8266Request &request, WireList<Wire::Mac, Replies...>, MacAddress &target, Targets&&... targets);
+    void expectString(ESP8266Request &request, std::string &target);
+    void expectString(ESP8266Request &request, const CharSpan &target);
+    void put(ESP8266Request &request, Wire::U8, const std::uint8_t value);
+    void put(ESP8266Request &request, Wire::U16, const std::uint16_t value);
+    void put(ESP8266Request &request, Wire::U32, const std::uint32_t value);
+    void put(ESP8266Request &request, Wire::Bool, const bool value);
+    void put(ESP8266Request &request, Wire::Bool16, const bool value);
+    void put(ESP8266Request &request, Wire::Text, const std::string &value);
+    template<std::size_t Size>
+    void put(ESP8266Request &request, Wire::Raw<Size>, const std::uint8_t* value);
+    void put(ESP8266Request &request, Wire::Payload, const Wire::Span &value);
+    void put(ESP8266Request &request, Wire::Http, const HttpRequest &value);
+    void put(ESP8266Request &request, Wire::IPv4, const IPv4Address &value);
+    void put(ESP8266Request &request, Wire::Mac, const MacAddress &value);
+    void reject(ESP8266Request &request);
+
+    void receive(void);
+    std::size_t receiveBytes(std::uint8_t* data, const std::size_t size);
+    bool receiveHeader(const std::uint8_t size);
+    void receiveFrame(void);
+    void endLinkFrame(const bool valid);
+    void receivePayload(void);
+    void unpack(ESP8266Request::Frame &frame, const std::uint8_t* data, const std::size_t size);
+    void unpackByte(ESP8266Request::Frame &frame, const std::uint8_t value);
+    std::uint16_t frameLimit(const ESP8266Request::Frame &frame) const;
+    void beginFrame(void);
+    void endFrame(void);
+    void dispatchEvent(void);
+    void resetRx(void);
+    ESP8266Request* findRequest(const std::uint8_t seq);
+    void finish(ESP8266Request &request, const RequestStatus status);
+    void checkTimeouts(void);
+    void waitStep(const WaitStrategy strategy);
+    void waitIdle(void);
+    bool probeBaudRate(const std::uint32_t baud, const std::uint16_t hold);
+    BaudRateTrial qualify(const std::uint32_t baud);
 
  public:
+#ifndef ESP8266_POSIX
+    /// @brief
+    /// Use the Pokitto UART and system timer.
+    ///
+    /// @param baud - the initial baud rate.
+    ///
     ESP8266(std::uint32_t baud = 230400);
+#endif
+
+    /// @brief
+    /// Use any link and time source, both must outlive the driver.
+    ///
+    /// @param transport - the byte link to the coprocessor.
+    /// @param clock - the millisecond time source for timeouts.
+    ///
+    ESP8266(ESP8266Transport &transport, ESP8266Clock &clock);
+
+    ~ESP8266();
+
+    ESP8266(const ESP8266&) = delete;
+    ESP8266& operator=(const ESP8266&) = delete;
 
     
     /// @brief
@@ -208,6 +407,16 @@ private:
     /// @return the string of version. 
     ///
     std::string getVersionString(void);
+
+    /// @brief
+    /// Get the version of the lib into the caller's buffer, without heap use.
+    ///
+    /// @param version - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getVersionString(const CharSpan version);
     
     /// @brief
     /// Set the buad rate to communicate with ESP8266.
@@ -215,9 +424,38 @@ private:
     /// @param baud - the buad rate to communicate with ESP8266(default:230400). 
     ///
     /// @retval true - success.
-    /// @retval false - failure.
+    /// @retval false - failure, nothing is sent when the transport does not support the rate.
     ///
     bool setBaudRate(const std::uint32_t baud=230400);
+
+    /// @brief
+    /// Find the fastest rate the link carries cleanly.
+    ///
+    /// The rates are tried in order, usually ascending. At each one the
+    /// ESP8266 switches for a while only, and ESP8266_BAUD_PROBES echoes
+    /// are checked by CRC. The rate is kept when they all come back intact.
+    /// At the first failure both sides return to the last good rate and
+    /// the search stops. Rates the transport does not support, 0 among
+    /// them, are skipped as failed trials. Waits for every pending request first.
+    ///
+    /// @param rates - the candidate rates.
+    /// @param count - the number of candidate rates.
+    /// @param trials - receives the outcome of every rate tried, may be nullptr.
+    ///
+    /// @return the rate in use afterwards.
+    ///
+    std::uint32_t negotiateBaudRate(const std::uint32_t* rates, const std::size_t count, std::vector<BaudRateTrial>* trials=nullptr);
+
+    /// @brief
+    /// Send data to the ESP8266 and check it comes back unchanged.
+    ///
+    /// @param data - the data.
+    /// @param size - the length of data.
+    ///
+    /// @retval true - the same data came back.
+    /// @retval false - failure or different data.
+    ///
+    bool echo(const std::uint8_t* data, const std::uint16_t size);
     
     /// @brief
     /// Erase the internal config of ESP8266.
@@ -227,6 +465,86 @@ private:
     ///
     bool eraseConfig(void);
 
+    /// @brief
+    /// Switch the framing used on the link.
+    /// Waits for every pending request first.
+    ///
+    /// @param mode - the new link mode.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure, the link mode is unchanged.
+    ///
+    bool setLinkMode(const LinkMode mode);
+
+    /// @brief
+    /// Get the framing used on the link.
+    ///
+    /// @return the current link mode.
+    ///
+    LinkMode getLinkMode(void) const;
+
+    /// @brief
+    /// Compress the payloads sent and received, see Lzss.
+    /// Waits for every pending request first. Payloads that do not
+    /// compress still go as they are, restart() turns it off.
+    ///
+    /// @param enabled - true to compress.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure, the setting is unchanged.
+    ///
+    bool setCompression(const bool enabled);
+
+    /// @brief
+    /// Check if the payloads are compressed.
+    ///
+    bool getCompression(void) const;
+
+    /// @brief
+    /// Get the number of bytes dropped because the receive buffer was full.
+    ///
+    /// @return the overrun count since the last reset.
+    ///
+    std::uint32_t getRxOverrunCount(void) const;
+
+    /// @brief
+    /// Get the highest fill level reached by the receive buffer.
+    ///
+    /// @return the high water mark in bytes, out of ESP8266_RX_BUFFER_SIZE.
+    ///
+    std::size_t getRxHighWater(void) const;
+
+    /// @brief
+    /// Reset the overrun count and the high water mark.
+    ///
+    void resetRxStats(void);
+
+#ifdef ESP8266_STATS
+    /// @brief
+    /// Get the per command call, timeout, byte and latency counters.
+    /// Built with ESP8266_STATS only.
+    ///
+    const ESP8266Stats& getStats(void) const;
+
+    /// @brief
+    /// Forget the per command counters.
+    ///
+    void resetStats(void);
+#endif
+
+    /// @brief
+    /// Check if everything queued for the ESP8266 has left the UART.
+    ///
+    /// @retval true - nothing left to send.
+    /// @retval false - a transfer is still running in the background.
+    ///
+    bool isTxIdle(void) const;
+
+    /// @brief
+    /// Wait until everything queued for the ESP8266 has left the UART.
+    ///
+    void flushTx(void);
+
     //
     // WiFi
     //
@@ -280,6 +598,16 @@ private:
     /// @return the SSID of Access Point.
     ///
     std::string getSSID(void);
+
+    /// @brief
+    /// Get the SSID of Access Point into the caller's buffer, without heap use.
+    ///
+    /// @param ssid - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSSID(const CharSpan ssid);
     
     /// @brief
     /// Get the RSSI of Access Point ESP8266 is connected to.
@@ -294,6 +622,26 @@ private:
     /// @return the IP list. 
     ///
     std::string getLocalIP(void);
+
+    /// @brief
+    /// Get the IP address of ESP8266 into the caller's buffer, without heap use.
+    ///
+    /// @param ip - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getLocalIP(const CharSpan ip);
+
+    /// @brief
+    /// Get the IP address of ESP8266 as its bytes.
+    ///
+    /// @param ip - receives the address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getLocalIP(IPv4Address &ip);
     
     /// @brief
     /// Get the Gateway address of Access Point ESP8266 is connected to.
@@ -301,6 +649,26 @@ private:
     /// @return the Gateway address of Access Point.
     ///
     std::string getGatewayIP(void);
+
+    /// @brief
+    /// Get the Gateway address of Access Point into the caller's buffer, without heap use.
+    ///
+    /// @param ip - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getGatewayIP(const CharSpan ip);
+
+    /// @brief
+    /// Get the Gateway address of Access Point as its bytes.
+    ///
+    /// @param ip - receives the address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getGatewayIP(IPv4Address &ip);
     
     /// @brief
     /// Get the Subnet Mask of Access Point ESP8266 is connected to.
@@ -308,6 +676,26 @@ private:
     /// @return the Subnet Mask of Access Point.
     ///
     std::string getSubnetMask(void);
+
+    /// @brief
+    /// Get the Subnet Mask of Access Point into the caller's buffer, without heap use.
+    ///
+    /// @param mask - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSubnetMask(const CharSpan mask);
+
+    /// @brief
+    /// Get the Subnet Mask of Access Point as its bytes.
+    ///
+    /// @param mask - receives the address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSubnetMask(IPv4Address &mask);
     
     /// @brief
     /// Get the Mac address of Access Point ESP8266 is connected to.
@@ -315,9 +703,31 @@ private:
     /// @return the Mac address of Access Point.
     ///
     std::string getMac(void);
+
+    /// @brief
+    /// Get the Mac address of Access Point into the caller's buffer, without heap use.
+    ///
+    /// @param mac - receives the string, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getMac(const CharSpan mac);
+
+    /// @brief
+    /// Get the Mac address of Access Point as its bytes.
+    ///
+    /// @param mac - receives the address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getMac(MacAddress &mac);
     
     /// @brief
-    /// Change IP configuration settings disabling the dhcp client
+    /// Change IP configuration settings disabling the dhcp client.
+    /// An empty string is read as 0.0.0.0, any other text that is not an
+    /// address fails without sending.
     /// 
     /// @param local_ip - static ip configuration
     /// @param gateway - static gateway configuration
@@ -329,6 +739,21 @@ private:
     /// @retval false - failure.
     ///
     bool setStationIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet, const std::string &dns1, const std::string &dns2);
+
+    /// @brief
+    /// Change IP configuration settings disabling the dhcp client, with
+    /// the addresses as their bytes.
+    ///
+    /// @param local_ip - static ip configuration
+    /// @param gateway - static gateway configuration
+    /// @param subnet - static Subnet mask
+    /// @param dns1 - static DNS server 1
+    /// @param dns2 - static DNS server 2
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool setStationIP(const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet, const IPv4Address &dns1, const IPv4Address &dns2);
     
     /// @brief
     /// Start Scaning available APs.
@@ -390,7 +815,9 @@ private:
     bool getSoftAPConfig(std::string &ssid, std::string &passphrase);
     
     /// @brief
-    /// Configure access point
+    /// Configure access point.
+    /// An empty string is read as 0.0.0.0, any other text that is not an
+    /// address fails without sending.
     /// 
     /// @param local_ip - access point IP
     /// @param gateway - gateway IP ("0.0.0.0" to disable)
@@ -400,6 +827,18 @@ private:
     /// @retval false - failure.
     ///
     bool setSoftAPIP(const std::string &local_ip, const std::string &gateway, const std::string &subnet);
+
+    /// @brief
+    /// Configure access point, with the addresses as their bytes.
+    ///
+    /// @param local_ip - access point IP
+    /// @param gateway - gateway IP (0.0.0.0 to disable)
+    /// @param subnet - subnet mask
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool setSoftAPIP(const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet);
     
     /// @brief
     /// Get the softAP interface IP address and MAC address.
@@ -411,6 +850,17 @@ private:
     /// @retval false - failure.
     ///
     bool getSoftAPIP(std::string &ip_address, std::string &mac);
+
+    /// @brief
+    /// Get the softAP interface IP address and MAC address as their bytes.
+    ///
+    /// @param ip_address - receives the IP address.
+    /// @param mac - receives the mac address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSoftAPIP(IPv4Address &ip_address, MacAddress &mac);
     
     /// @brief
     /// Disconnect from the network (close AP)
@@ -440,6 +890,31 @@ private:
     /// @retval false - failure.
     ///
     bool getSoftAPClient(const std::uint16_t id, std::string &ip_address, std::string &mac);
+
+    /// @brief
+    /// Get the softAP connected client IP address and MAC address into the
+    /// caller's buffers, without heap use.
+    ///
+    /// @param id - specify from which client want to get the information
+    /// @param ip_address - receives the IP address, cut to fit.
+    /// @param mac - receives the mac address, cut to fit.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSoftAPClient(const std::uint16_t id, const CharSpan ip_address, const CharSpan mac);
+
+    /// @brief
+    /// Get the softAP connected client IP address and MAC address as their bytes.
+    ///
+    /// @param id - specify from which client want to get the information
+    /// @param ip_address - receives the IP address.
+    /// @param mac - receives the mac address.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure, or no such client.
+    ///
+    bool getSoftAPClient(const std::uint16_t id, IPv4Address &ip_address, MacAddress &mac);
     
     //
     // TCP
@@ -488,6 +963,19 @@ private:
     /// @retval false - failure.
     ///
     bool sendTCP(const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size);
+
+    /// @brief
+    /// Send data of any length based on one of TCP, in chunks paced by the
+    /// room the ESP8266 reports. See ESP8266Upload to send without waiting.
+    ///
+    /// @param id - the identifier of this TCP(available value: 0 - 4).
+    /// @param buffer - the buffer of data to send.
+    /// @param size - the length of data to send.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure, part of the data may be sent.
+    ///
+    bool streamTCP(const std::uint8_t id, const std::uint8_t* buffer, const std::size_t size);
     
 
     
@@ -502,6 +990,19 @@ private:
     /// @return the length of data received actually. 
     ///
     std::uint16_t readTCP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout = 1000);
+
+    /// @brief
+    /// Read data from one of TCP, at most buffer_size bytes leave the
+    /// ESP8266 and the rest stays there for the next read. readTCP()
+    /// drops whatever does not fit the buffer.
+    ///
+    /// @param id - the identifier of this TCP(available value: 0 - 4).
+    /// @param buffer - the buffer for storing data.
+    /// @param buffer_size - the length of the buffer.
+    ///
+    /// @return the length of data received actually.
+    ///
+    std::uint16_t readSomeTCP(const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size);
    
    
     /// @brief
@@ -598,6 +1099,21 @@ private:
     ///
     bool getRemoteInfoUDP(const std::uint8_t id, std::string &address, std::uint16_t &port);
     
+    //
+    // sockets
+    //
+
+    /// @brief
+    /// Get the state of all TCP and UDP links in one round trip, instead of
+    /// isConnectedTCP(), availableTCP() and availableUDP() for every id.
+    ///
+    /// @param status - receives the state.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool getSocketStatus(SocketStatus &status);
+
     //
     // HTTP
     //
@@ -648,6 +1164,18 @@ private:
     /// @return -1 if no info or > 0 when Content-Length is set by server
     ///
     std::uint32_t getSizeHTTP(void);
+
+    /// @brief
+    /// Read the whole body of the http response in chunks, never holding
+    /// more than two of them. See ESP8266Download to read without waiting.
+    ///
+    /// @param handler - receives every chunk in order, returns false to stop.
+    /// @param chunk_size - the largest chunk handed to the handler.
+    ///
+    /// @retval true - the whole body was handed to the handler.
+    /// @retval false - failure or stopped by the handler.
+    ///
+    bool downloadHTTP(const std::function<bool(const std::uint8_t* data, std::uint16_t size)> &handler, const std::uint16_t chunk_size=ESP8266_STREAM_CHUNK);
     
     /// @brief
     /// Close HTTP. 
@@ -656,9 +1184,21 @@ private:
     /// @retval false - failure.
     ///
     bool closeHTTP(void);
-    
+
     /// @brief
-    /// HTTPS SHA1 fingerprint of certificate to check.
+    /// Keep the connection open after a request, so the next createHTTP to
+    /// the same host and port skips the TCP and TLS handshakes. Turning it
+    /// off closes a kept connection.
+    ///
+    /// @param reuse - true to keep connections, false to close after every request.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool setReuseHTTP(const bool reuse);
+    
+    /// @brief
+    /// HTTPS SHA1 fingerprint of certificate to check.
     /// 
     /// @param fingerprint - SHA1 fingerprint of certificate.
     /// 
@@ -712,6 +1252,54 @@ private:
     /// @return http code
     ///
     std::int32_t sendPostHttp(const std::uint8_t* payload, std::uint16_t size, std::uint32_t timeout=3000);
+
+    /// @brief
+    /// Send a complete request in one command, in place of createHTTP(),
+    /// addHeaderHTTP(), sendGetHTTP() and getResponseHeaderHTTP(). The body
+    /// is then read as after sendGetHTTP().
+    ///
+    /// @param http - the method, target, headers and body.
+    /// @param response - receives the status, Content-Length and the
+    ///     headers named in http.responseHeaders.
+    /// @param timeout - the time waiting for the response.
+    ///
+    /// @return error code on failure or http code on success.
+    ///
+    std::int32_t requestHTTP(const HttpRequest &http, HttpResponse &response, const std::uint32_t timeout=5000);
+
+    /// @brief
+    /// Send a request whose body is produced piece by piece, for POST and
+    /// PUT bodies that are built up over time or do not fit in RAM. Only
+    /// one chunk buffer is allocated.
+    ///
+    /// @param http - the method, target and headers, http.body is not used.
+    /// @param producer - fills the buffer with the next part of the body and
+    ///     returns its length, 0 at the end.
+    /// @param response - receives the status, Content-Length and the
+    ///     headers named in http.responseHeaders.
+    /// @param length - the body length, the producer must give exactly that
+    ///     much. 0xFFFFFFFF sends the body with chunked transfer encoding.
+    /// @param chunk_size - the size of the buffer handed to the producer.
+    ///
+    /// @return error code on failure or http code on success. A part of
+    ///     the body the ESP8266 did not take gives httpErrorSendPayloadFailed,
+    ///     the connection is closed without ending the body.
+    ///
+    std::int32_t streamHTTP(const HttpRequest &http, const std::function<std::size_t(std::uint8_t* buffer, std::size_t size)> &producer, HttpResponse &response, const std::uint32_t length=0xFFFFFFFF, const std::uint16_t chunk_size=ESP8266_STREAM_CHUNK);
+
+    /// @brief
+    /// Send a request with the rest of a file as body, from the current
+    /// position to the end. Only one chunk of the file is in RAM at a time.
+    ///
+    /// @param http - the method, target and headers, http.body is not used.
+    /// @param file - the open file.
+    /// @param response - receives the status, Content-Length and the
+    ///     headers named in http.responseHeaders.
+    /// @param chunk_size - the size of every read from the file.
+    ///
+    /// @return error code on failure or http code on success.
+    ///
+    std::int32_t streamHTTP(const HttpRequest &http, std::FILE* file, HttpResponse &response, const std::uint16_t chunk_size=ESP8266_STREAM_CHUNK);
     
     //
     // ESP_NOW
@@ -727,6 +1315,7 @@ private:
     
     /// @brief
     /// Add a peer or change peer channel.
+    /// Text that is not a MAC address, the empty string too, fails without sending.
     ///
     /// @param mac - peer MAC address
     /// @param - channel peer channel, 0 for current channel
@@ -735,9 +1324,21 @@ private:
     /// @retval false - failure.
     ///
     bool espNowAddPeer(const std::string &mac, std::uint8_t channel=0);
+
+    /// @brief
+    /// Add a peer or change peer channel, the address as its bytes.
+    ///
+    /// @param mac - peer MAC address
+    /// @param - channel peer channel, 0 for current channel
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool espNowAddPeer(const MacAddress &mac, std::uint8_t channel=0);
     
     /// @brief 
     /// Remove a peer.
+    /// Text that is not a MAC address, the empty string too, fails without sending.
     ///
     /// @param mac -  peer MAC address
     ///
@@ -745,9 +1346,20 @@ private:
     /// @retval false - failure.
     ///
     bool espNowRemovePeer(const std::string &mac);
+
+    /// @brief
+    /// Remove a peer, the address as its bytes.
+    ///
+    /// @param mac -  peer MAC address
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool espNowRemovePeer(const MacAddress &mac);
     
     /// @brief
     /// Send a message via ESP-NOW.
+    /// Text other than an empty string or a MAC address fails without sending.
     ///
     /// @param mac - destination MAC address, empty string for all peers
     /// @param buffer - payload
@@ -757,6 +1369,18 @@ private:
     /// @retval false - failure.
     ///
     bool espNowSend(const std::string &mac, std::uint8_t* buffer, const std::size_t size);
+
+    /// @brief
+    /// Send a message via ESP-NOW, the address as its bytes.
+    ///
+    /// @param mac - destination MAC address, 00:00:00:00:00:00 for all peers
+    /// @param buffer - payload
+    /// @param size - payload size, must not exceed 250 bytes
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool espNowSend(const MacAddress &mac, const std::uint8_t* buffer, const std::size_t size);
     
     /// @brief
     /// Receive a message via ESP-NOW.
@@ -788,4 +1412,526 @@ private:
     ///
     bool sha1(const std::uint8_t data[], const std::uint16_t size, std::uint8_t hash[20]);
 
+    //
+    // events
+    //
+
+    /// @brief
+    /// Choose the events the ESP8266 pushes, instead of polling with
+    /// availableTCP(), availableUDP(), espNowReceive() or getStatus().
+    /// Needs LinkMode::Pipelined or LinkMode::Framed, the legacy framing
+    /// has no room for unsolicited messages.
+    ///
+    /// A readable event comes once when a socket gets data, and again after
+    /// the next read if data is left.
+    ///
+    /// @param mask - a bit (1 << EventType) for every event wanted, 0 for none.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    bool setEventMask(const std::uint16_t mask);
+
+    /// @brief
+    /// Register the function called from poll() for an event type.
+    ///
+    /// @param type - the event type.
+    /// @param handler - the function, empty to remove it.
+    ///
+    void onEvent(const EventType type, const std::function<void(const Event&)> &handler);
+
+    //
+    // Pipelined calls
+    //
+    // Each ...Async() call sends its command at once and returns without
+    // waiting for the reply, which completes the given request later on.
+    // In LinkMode::Pipelined and LinkMode::Framed up to ESP8266_PIPELINE_DEPTH commands are in
+    // flight, so a burst of calls costs a single round trip. In
+    // LinkMode::Legacy a call waits for the previous request first.
+    //
+    // Nothing happens in the background: call poll() once per frame from
+    // the game loop, and check isBusy() before starting a request so the
+    // call never has to wait.
+    //
+    // The request, and every buffer or string receiving the reply, must
+    // stay alive until the request is ready. Payload buffers are sent
+    // without copying and must stay alive as well.
+    //
+    // Addresses are only read into IPv4Address and MacAddress, format()
+    // them once the request is ready.
+    //
+
+    /// @brief
+    /// Wait until a request is ready.
+    ///
+    /// @param request - the request to wait for.
+    ///
+    /// @retval true - the whole expected reply arrived.
+    /// @retval false - failure or timeout.
+    ///
+    bool wait(ESP8266Request &request);
+
+    /// @brief
+    /// Wait until a request is ready, with another strategy than the default.
+    ///
+    /// @param request - the request to wait for.
+    /// @param strategy - how to spend the time meanwhile.
+    ///
+    /// @retval true - the whole expected reply arrived.
+    /// @retval false - failure or timeout.
+    ///
+    bool wait(ESP8266Request &request, const WaitStrategy strategy);
+
+    /// @brief
+    /// Drop a pending request, a late reply is ignored.
+    ///
+    /// @param request - the request to drop.
+    ///
+    void cancel(ESP8266Request &request);
+
+    /// @brief
+    /// Receive the replies that arrived and expire the requests that timed
+    /// out. Completion callbacks are called from here.
+    ///
+    void poll(void);
+
+    /// @brief
+    /// Choose how every blocking call waits, WaitStrategy::Spin by default.
+    ///
+    /// @param strategy - the strategy of the blocking calls.
+    ///
+    void setWaitStrategy(const WaitStrategy strategy);
+
+    /// @brief
+    /// Get the strategy of the blocking calls.
+    ///
+    WaitStrategy getWaitStrategy(void) const;
+
+    /// @brief
+    /// Set the function WaitStrategy::Yield calls between polls, the game
+    /// tick for example. It may start requests, a blocking call made from
+    /// it spins.
+    ///
+    /// @param handler - the function, empty to only poll.
+    ///
+    void setIdleHandler(const std::function<void(void)> &handler);
+
+    /// @brief
+    /// Get where the time of the blocking calls went. The CPU was busy for
+    /// waitTime - sleepTime - yieldTime of it.
+    ///
+    const WaitStats& getWaitStats(void) const;
+
+    /// @brief
+    /// Reset the wait counters.
+    ///
+    void resetWaitStats(void);
+
+    /// @brief
+    /// Check if starting a request now would wait for a free slot.
+    ///
+    /// @retval true - all slots are in flight.
+    /// @retval false - a request can start at once.
+    ///
+    bool isBusy(void) const;
+
+    /// @brief
+    /// Get the time of the clock the driver runs on.
+    ///
+    /// @return milliseconds, wrapping.
+    ///
+    std::uint32_t getTime(void) const;
+
+    /// @brief
+    /// Start isPresent(), the request is ok when the ESP8266 answered.
+    ///
+    void isPresentAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start restart().
+    ///
+    void restartAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start checkVersion().
+    ///
+    void checkVersionAsync(ESP8266Request &request, const std::string &version);
+
+    /// @brief
+    /// Start getVersion(), the version is in request.getValue16().
+    ///
+    void getVersionAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getVersionString().
+    ///
+    void getVersionStringAsync(ESP8266Request &request, std::string &version);
+
+    /// @brief
+    /// Start getVersionString() into the caller's buffer.
+    ///
+    void getVersionStringAsync(ESP8266Request &request, const CharSpan version);
+
+    /// @brief
+    /// Start eraseConfig().
+    ///
+    void eraseConfigAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start setWifiMode().
+    ///
+    void setWifiModeAsync(ESP8266Request &request, const WiFiMode mode);
+
+    /// @brief
+    /// Start getWifiMode(), the mode is in request.getValue16().
+    ///
+    void getWifiModeAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start joinAP().
+    ///
+    void joinAPAsync(ESP8266Request &request, const std::string &ssid, const std::string &password);
+
+    /// @brief
+    /// Start getStatus(), the WifiStatus is in request.getValue16().
+    ///
+    void getStatusAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start leaveAP().
+    ///
+    void leaveAPAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getSSID().
+    ///
+    void getSSIDAsync(ESP8266Request &request, std::string &ssid);
+
+    /// @brief
+    /// Start getSSID() into the caller's buffer.
+    ///
+    void getSSIDAsync(ESP8266Request &request, const CharSpan ssid);
+
+    /// @brief
+    /// Start getRSSI(), the RSSI is in request.getValue32().
+    ///
+    void getRSSIAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getLocalIP() into an IPv4Address.
+    ///
+    void getLocalIPAsync(ESP8266Request &request, IPv4Address &ip);
+
+    /// @brief
+    /// Start getGatewayIP() into an IPv4Address.
+    ///
+    void getGatewayIPAsync(ESP8266Request &request, IPv4Address &ip);
+
+    /// @brief
+    /// Start getSubnetMask() into an IPv4Address.
+    ///
+    void getSubnetMaskAsync(ESP8266Request &request, IPv4Address &mask);
+
+    /// @brief
+    /// Start getMac() into a MacAddress.
+    ///
+    void getMacAsync(ESP8266Request &request, MacAddress &mac);
+
+    /// @brief
+    /// Start setStationIP(), text that is not an address fails the request without sending.
+    ///
+    void setStationIPAsync(ESP8266Request &request, const std::string &local_ip, const std::string &gateway, const std::string &subnet, const std::string &dns1, const std::string &dns2);
+
+    /// @brief
+    /// Start setStationIP() with the addresses as their bytes.
+    ///
+    void setStationIPAsync(ESP8266Request &request, const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet, const IPv4Address &dns1, const IPv4Address &dns2);
+
+    /// @brief
+    /// Start scanNetworks().
+    ///
+    void scanNetworksAsync(ESP8266Request &request, const bool async=true, const bool show_hidden=false, const std::uint8_t channel=0, const std::string &ssid="");
+
+    /// @brief
+    /// Start scanComplete(), the result is in request.getValue16().
+    ///
+    void scanCompleteAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getNetworkInfo().
+    ///
+    void getNetworkInfoAsync(ESP8266Request &request, const std::uint16_t id, NetworkInfo &info);
+
+    /// @brief
+    /// Start setSoftAPConfig().
+    ///
+    void setSoftAPConfigAsync(ESP8266Request &request, const std::string &ssid, const std::string &passphrase="", const std::uint16_t channel=1);
+
+    /// @brief
+    /// Start getSoftAPConfig().
+    ///
+    void getSoftAPConfigAsync(ESP8266Request &request, std::string &ssid, std::string &passphrase);
+
+    /// @brief
+    /// Start setSoftAPIP(), text that is not an address fails the request without sending.
+    ///
+    void setSoftAPIPAsync(ESP8266Request &request, const std::string &local_ip, const std::string &gateway, const std::string &subnet);
+
+    /// @brief
+    /// Start setSoftAPIP() with the addresses as their bytes.
+    ///
+    void setSoftAPIPAsync(ESP8266Request &request, const IPv4Address &local_ip, const IPv4Address &gateway, const IPv4Address &subnet);
+
+    /// @brief
+    /// Start getSoftAPIP() into an IPv4Address and a MacAddress.
+    ///
+    void getSoftAPIPAsync(ESP8266Request &request, IPv4Address &ip_address, MacAddress &mac);
+
+    /// @brief
+    /// Start softAPdisconnect().
+    ///
+    void softAPdisconnectAsync(ESP8266Request &request, const bool wifioff=false);
+
+    /// @brief
+    /// Start softAPgetStationNum(), the count is in request.getValue16().
+    ///
+    void softAPgetStationNumAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getSoftAPClient() into an IPv4Address and a MacAddress.
+    ///
+    void getSoftAPClientAsync(ESP8266Request &request, const std::uint16_t id, IPv4Address &ip_address, MacAddress &mac);
+
+    /// @brief
+    /// Start createTCP().
+    ///
+    void createTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::string &address, const std::uint16_t port);
+
+    /// @brief
+    /// Start closeTCP().
+    ///
+    void closeTCPAsync(ESP8266Request &request, const std::uint8_t id=0);
+
+    /// @brief
+    /// Start availableTCP(), the request is ok when data is available.
+    ///
+    void availableTCPAsync(ESP8266Request &request, const std::uint8_t id=0);
+
+    /// @brief
+    /// Start sendTCP().
+    ///
+    void sendTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size);
+
+    /// @brief
+    /// Send one chunk of a streamed send, request.getValue16() is the
+    /// number of bytes the ESP8266 can take next.
+    ///
+    void sendChunkTCPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size);
+
+    /// @brief
+    /// Start readTCP(), the received length is in request.getSize().
+    ///
+    void readTCPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout = 1000);
+
+    /// @brief
+    /// Start readSomeTCP(), the received length is in request.getSize().
+    ///
+    void readSomeTCPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size);
+
+    /// @brief
+    /// Start isConnectedTCP(), the request is ok when connected.
+    ///
+    void isConnectedTCPAsync(ESP8266Request &request, const std::uint8_t id=0);
+
+    /// @brief
+    /// Start createUDP().
+    ///
+    void createUDPAsync(ESP8266Request &request, const std::uint8_t id, const std::string &address, const std::uint16_t port);
+
+    /// @brief
+    /// Start closeUDP().
+    ///
+    void closeUDPAsync(ESP8266Request &request, const std::uint8_t id=0);
+
+    /// @brief
+    /// Start sendUDP().
+    ///
+    void sendUDPAsync(ESP8266Request &request, const std::uint8_t id, const std::uint8_t* buffer, const std::uint16_t size);
+
+    /// @brief
+    /// Start readUDP(), the received length is in request.getSize().
+    ///
+    void readUDPAsync(ESP8266Request &request, const std::uint8_t id, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout = 1000);
+
+    /// @brief
+    /// Start availableUDP(), the request is ok when a packet is available.
+    ///
+    void availableUDPAsync(ESP8266Request &request, const std::uint8_t id=0);
+
+    /// @brief
+    /// Start listenUDP().
+    ///
+    void listenUDPAsync(ESP8266Request &request, const std::uint8_t id=0, const std::uint16_t port=333);
+
+    /// @brief
+    /// Start getRemoteInfoUDP(), the port is in request.getValue16().
+    ///
+    void getRemoteInfoUDPAsync(ESP8266Request &request, const std::uint8_t id, std::string &address);
+
+    /// @brief
+    /// Start createHTTP().
+    ///
+    void createHTTPAsync(ESP8266Request &request, const std::string &host, const std::uint16_t port=80, const std::string &uri="/", const bool is_https=false);
+
+    /// @brief
+    /// Start sendGetHTTP(), the http code is in request.getValue32().
+    ///
+    void sendGetHTTPAsync(ESP8266Request &request, const std::uint32_t timeout=5000);
+
+    /// @brief
+    /// Start getStringHTTP().
+    ///
+    void getStringHTTPAsync(ESP8266Request &request, std::string &body);
+
+    /// @brief
+    /// Start readDataHTTP(), the received length is in request.getSize().
+    ///
+    void readDataHTTPAsync(ESP8266Request &request, std::uint8_t* buffer, const std::uint16_t buffer_size, const std::uint32_t timeout=1000);
+
+    /// @brief
+    /// Read the next chunk of the http response body, at most buffer_size
+    /// bytes. The received length is in request.getSize(), 0 at the end.
+    ///
+    void readChunkHTTPAsync(ESP8266Request &request, std::uint8_t* buffer, const std::uint16_t buffer_size);
+
+    /// @brief
+    /// Start getSizeHTTP(), the size is in request.getValue32().
+    ///
+    void getSizeHTTPAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start closeHTTP().
+    ///
+    void closeHTTPAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start setReuseHTTP().
+    ///
+    void setReuseHTTPAsync(ESP8266Request &request, const bool reuse);
+
+    /// @brief
+    /// Start setFingerPrintHTTP().
+    ///
+    void setFingerPrintHTTPAsync(ESP8266Request &request, const std::uint8_t fingerprint[]);
+
+    /// @brief
+    /// Start setInSecureHTTP().
+    ///
+    void setInSecureHTTPAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start addHeaderHTTP().
+    ///
+    void addHeaderHTTPAsync(ESP8266Request &request, const std::string &name, const std::string &value);
+
+    /// @brief
+    /// Start getResponseHeaderCountHTTP(), the count is in request.getValue32().
+    ///
+    void getResponseHeaderCountHTTPAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start getResponseHeaderHTTP().
+    ///
+    void getResponseHeaderHTTPAsync(ESP8266Request &request, std::size_t id, std::string &name, std::string &value);
+
+    /// @brief
+    /// Start sendPostHttp(), the http code is in request.getValue32().
+    ///
+    void sendPostHttpAsync(ESP8266Request &request, const std::uint8_t* payload, std::uint16_t size, std::uint32_t timeout=3000);
+
+    /// @brief
+    /// Start requestHTTP(), response is filled when the request is done.
+    ///
+    void requestHTTPAsync(ESP8266Request &request, const HttpRequest &http, HttpResponse &response, const std::uint32_t timeout=5000);
+
+    /// @brief
+    /// Connect and send the head of a streamed request, see streamHTTP().
+    ///
+    void beginStreamHTTPAsync(ESP8266Request &request, const HttpRequest &http, const std::uint32_t length=0xFFFFFFFF);
+
+    /// @brief
+    /// Send the next part of the body of a streamed request.
+    ///
+    void sendStreamHTTPAsync(ESP8266Request &request, const std::uint8_t* buffer, const std::uint16_t size);
+
+    /// @brief
+    /// End the body of a streamed request, response is filled when the
+    /// request is done.
+    ///
+    void endStreamHTTPAsync(ESP8266Request &request, HttpResponse &response, const std::uint32_t timeout=5000);
+
+    /// @brief
+    /// Start espNowInit().
+    ///
+    void espNowInitAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start espNowAddPeer(), text that is not a MAC address fails the request without sending.
+    ///
+    void espNowAddPeerAsync(ESP8266Request &request, const std::string &mac, std::uint8_t channel=0);
+
+    /// @brief
+    /// Start espNowAddPeer() with the address as its bytes.
+    ///
+    void espNowAddPeerAsync(ESP8266Request &request, const MacAddress &mac, std::uint8_t channel=0);
+
+    /// @brief
+    /// Start espNowRemovePeer(), text that is not a MAC address fails the request without sending.
+    ///
+    void espNowRemovePeerAsync(ESP8266Request &request, const std::string &mac);
+
+    /// @brief
+    /// Start espNowRemovePeer() with the address as its bytes.
+    ///
+    void espNowRemovePeerAsync(ESP8266Request &request, const MacAddress &mac);
+
+    /// @brief
+    /// Start espNowSend(), text other than an empty string or a MAC address fails the request without sending.
+    ///
+    void espNowSendAsync(ESP8266Request &request, const std::string &mac, const std::uint8_t* buffer, const std::size_t size);
+
+    /// @brief
+    /// Start espNowSend() with the address as its bytes.
+    ///
+    void espNowSendAsync(ESP8266Request &request, const MacAddress &mac, const std::uint8_t* buffer, const std::size_t size);
+
+    /// @brief
+    /// Start espNowReceive(), the request is ok when a message was received.
+    ///
+    void espNowReceiveAsync(ESP8266Request &request, EspNowReceiveInfo &info);
+
+    /// @brief
+    /// Start espNowDeInit().
+    ///
+    void espNowDeInitAsync(ESP8266Request &request);
+
+    /// @brief
+    /// Start sha1().
+    ///
+    void sha1Async(ESP8266Request &request, const std::uint8_t data[], const std::uint16_t size, std::uint8_t hash[20]);
+
+    /// @brief
+    /// Start echo(), the reply is stored in reply.
+    ///
+    void echoAsync(ESP8266Request &request, const std::uint8_t* data, const std::uint16_t size, std::uint8_t* reply, const std::uint32_t timeout=1000);
+
+    /// @brief
+    /// Start setEventMask().
+    ///
+    void setEventMaskAsync(ESP8266Request &request, const std::uint16_t mask);
+
+    /// @brief
+    /// Start getSocketStatus().
+    ///
+    void getSocketStatusAsync(ESP8266Request &request, SocketStatus &status);
 };
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "ESP8266Http.h"
+#include "NetworkAddress.h"
+
+enum class Commands: std::uint16_t
+{
+    nop=1,
+    restart,
+    checkVersion,
+    getVersion,
+    getVersionString,
+    setBaudRate,
+    eraseConfig,
+    // Wifi
+    setWifiMode,
+    getWifiMode,
+    joinAP,
+    getStatus,
+    leaveAP,
+    getSSID,
+    getRSSI,
+    getLocalIP,
+    getGatewayIP,
+    getSubnetMask,
+    getMac,
+    setStationIP,
+    scanNetworks,
+    scanComplete,
+    getNetworkInfo,
+    //wifi softAP
+    setSoftAPConfig,
+    getSoftAPConfig,
+    setSoftAPIP,
+    getSoftAPIP,
+    softAPdisconnect,
+    softAPgetStationNum,
+    getSoftAPClient,
+    //TCP client
+    createTCP,
+    sendTCP,
+    availableTCP,
+    readTCP,
+    closeTCP,
+    isConnectedTCP,
+    //UDP
+    createUDP,
+    sendUDP,
+    listenUDP,
+    availableUDP,
+    closeUDP,
+    readUDP,
+    getRemoteInfoUDP,
+    //http client
+    createHTTP,
+    sendGetHTTP,
+    getStringHTTP,
+    readDataHTTP,
+    getSizeHTTP,
+    closeHTTP,
+    setFingerPrintHTTP,
+    setInSecureHTTP,
+    addHeaderHTTP,
+    getResponseHeaderCountHTTP,
+    getResponseHeaderHTTP,
+    sendPostHttp,
+    // ESP-NOW https://docs.espressif.com/projects/esp-idf/en/latest/api-reference/network/esp_now.html
+    espNowInit,
+    espNowAddPeer,
+    espNowRemovePeer,
+    espNowSend,
+    espNowReceive,
+    espNowDeInit,
+
+    // crypto
+    sha1,
+
+    // link
+    setLinkMode,
+
+    // events
+    setEventMask,
+
+    // sockets
+    getSocketStatus,
+    readSomeTCP,
+    sendChunkTCP,
+
+    // http
+    readChunkHTTP,
+    setReuseHTTP,
+    requestHTTP,
+    beginStreamHTTP,
+    sendStreamHTTP,
+    endStreamHTTP,
+
+    // link
+    setCompression,
+    echo,
+    probeBaudRate,
+
+    // addresses, as their bytes
+    getLocalIPBinary,
+    getGatewayIPBinary,
+    getSubnetMaskBinary,
+    getMacBinary,
+    setStationIPBinary,
+    setSoftAPIPBinary,
+    getSoftAPIPBinary,
+    getSoftAPClientBinary,
+    espNowAddPeerBinary,
+    espNowRemovePeerBinary,
+    espNowSendBinary,
+};
+
+enum class Response: std::uint16_t
+{
+	Ok = 1,
+	Error,
+	String,
+	Data,
+	/// LinkMode::Framed only, the ESP8266 lost a frame and asks for the unanswered commands again.
+	Resend,
+	/// Unsolicited, pushed with sequence number 0 once enabled by setEventMask().
+	Event,
+	/// Data compressed with Lzss, once enabled by setCompression().
+	PackedData,
+	/// String compressed with Lzss, once enabled by setCompression().
+	PackedString,
+};
+
+/// @brief
+/// Wire shapes of the command fields and of the replies, the building
+/// blocks of the CommandTraits descriptors.
+///
+namespace Wire
+{
+    /// Bytes sent from the caller's buffer.
+    struct Span
+    {
+        const std::uint8_t* data;
+        std::uint16_t size;
+    };
+
+    /// Caller's buffer receiving a data reply.
+    struct Buffer
+    {
+        std::uint8_t* data;
+        std::uint16_t capacity;
+    };
+
+    //
+    // Fields, written in order after the command code. Type is what the
+    // caller must pass, exactly.
+    //
+
+    /// One byte.
+    struct U8 { typedef std::uint8_t Type; };
+    /// Two bytes, little endian.
+    struct U16 { typedef std::uint16_t Type; };
+    /// Four bytes, little endian.
+    struct U32 { typedef std::uint32_t Type; };
+    /// One byte, 1 for true.
+    struct Bool { typedef bool Type; };
+    /// Two bytes, 1 for true.
+    struct Bool16 { typedef bool Type; };
+    /// The characters, then a newline.
+    struct Text { typedef std::string Type; };
+    /// Size bytes as they are.
+    template<std::size_t Size>
+    struct Raw { typedef const std::uint8_t* Type; };
+    /// The size (u16), then the bytes, compressed once setCompression() is on.
+    struct Payload { typedef Span Type; };
+    /// Everything about an HTTP request but its body.
+    struct Http { typedef HttpRequest Type; };
+    /// The four octets, also a reply: Response::Data into an IPv4Address.
+    struct IPv4 { typedef IPv4Address Type; };
+    /// The six bytes, also a reply: Response::Data into a MacAddress.
+    struct Mac { typedef MacAddress Type; };
+
+    //
+    // Replies, expected in order.
+    //
+
+    /// Response::Ok.
+    struct Ok {};
+    /// Response::Data up to 4 bytes, read with ESP8266Request::getValue16() or getValue32().
+    struct Value {};
+    /// Response::String, into a std::string or a CharSpan.
+    struct String {};
+    /// Response::Data, into a Buffer.
+    struct Data {};
+}
+
+template<typename... Items>
+struct WireList {};
+
+/// @brief
+/// Descriptor of a command: its fields, its replies and its default timeout
+/// in milliseconds.
+///
+/// ESP8266 generates the code writing the fields and expecting the replies
+/// from it, and checks the arguments against it at compile time. A command
+/// without descriptor cannot be sent.
+///
+template<Commands command>
+struct CommandTraits;
+
+#define ESP8266_WIRE(...) __VA_ARGS__
+
+#define ESP8266_COMMAND(name, time, fields, replies) \
+    template<> \
+    struct CommandTraits<Commands::name> \
+    { \
+        static constexpr std::uint32_t timeout = time; \
+        typedef WireList<ESP8266_WIRE fields> Fields; \
+        typedef WireList<ESP8266_WIRE replies> Replies; \
+    }
+
+ESP8266_COMMAND(nop,                        100,  (),                                        (Wire::Ok));
+ESP8266_COMMAND(restart,                    100,  (),                                        (Wire::Ok));
+ESP8266_COMMAND(checkVersion,               100,  (Wire::Text),                              (Wire::Ok));
+ESP8266_COMMAND(getVersion,                 100,  (),                                        (Wire::Value));
+ESP8266_COMMAND(getVersionString,           200,  (),                                        (Wire::String));
+// the first Ok comes at the old rate, the second one at the new rate
+ESP8266_COMMAND(setBaudRate,                2000, (Wire::U32),                               (Wire::Ok, Wire::Ok));
+ESP8266_COMMAND(eraseConfig,                2000, (),                                        (Wire::Ok));
+
+// Wifi
+ESP8266_COMMAND(setWifiMode,                200,  (Wire::U16),                               (Wire::Ok));
+ESP8266_COMMAND(getWifiMode,                200,  (),                                        (Wire::Value));
+ESP8266_COMMAND(joinAP,                     1000, (Wire::Text, Wire::Text),                  (Wire::Ok));
+ESP8266_COMMAND(getStatus,                  100,  (),                                        (Wire::Value));
+ESP8266_COMMAND(leaveAP,                    1000, (),                                        (Wire::Ok));
+ESP8266_COMMAND(getSSID,                    200,  (),                                        (Wire::String));
+ESP8266_COMMAND(getRSSI,                    200,  (),                                        (Wire::Value));
+ESP8266_COMMAND(getLocalIP,                 200,  (),                                        (Wire::String));
+ESP8266_COMMAND(getGatewayIP,               200,  (),                                        (Wire::String));
+ESP8266_COMMAND(getSubnetMask,              200,  (),                                        (Wire::String));
+ESP8266_COMMAND(getMac,                     200,  (),                                        (Wire::String));
+ESP8266_COMMAND(setStationIP,               1000, (Wire::Text, Wire::Text, Wire::Text, Wire::Text, Wire::Text), (Wire::Ok));
+ESP8266_COMMAND(scanNetworks,               5000, (Wire::Bool, Wire::Bool, Wire::U8, Wire::Text), (Wire::Ok));
+ESP8266_COMMAND(scanComplete,               200,  (),                                        (Wire::Value));
+ESP8266_COMMAND(getNetworkInfo,             400,  (Wire::U16),                               (Wire::Data));
+
+// Wifi softAP
+ESP8266_COMMAND(setSoftAPConfig,            2000, (Wire::U16, Wire::Text, Wire::Text),       (Wire::Ok));
+ESP8266_COMMAND(getSoftAPConfig,            400,  (),                                        (Wire::String, Wire::String));
+ESP8266_COMMAND(setSoftAPIP,                5000, (Wire::Text, Wire::Text, Wire::Text),      (Wire::Ok));
+ESP8266_COMMAND(getSoftAPIP,                400,  (),                                        (Wire::String, Wire::String));
+ESP8266_COMMAND(softAPdisconnect,           500,  (Wire::Bool16),                            (Wire::Ok));
+ESP8266_COMMAND(softAPgetStationNum,        200,  (),                                        (Wire::Value));
+ESP8266_COMMAND(getSoftAPClient,            400,  (Wire::U16),                               (Wire::String, Wire::String));
+
+// TCP client
+ESP8266_COMMAND(createTCP,                  3000, (Wire::U8, Wire::U16, Wire::Text),         (Wire::Ok));
+ESP8266_COMMAND(sendTCP,                    3000, (Wire::U8, Wire::Payload),                 (Wire::Ok));
+ESP8266_COMMAND(availableTCP,               1000, (Wire::U8),                                (Wire::Ok));
+// plus the time the caller is ready to wait for data
+ESP8266_COMMAND(readTCP,                    300,  (Wire::U8),                                (Wire::Data));
+ESP8266_COMMAND(closeTCP,                   1000, (Wire::U8),                                (Wire::Ok));
+ESP8266_COMMAND(isConnectedTCP,             200,  (Wire::U8),                                (Wire::Ok));
+
+// UDP
+ESP8266_COMMAND(createUDP,                  3000, (Wire::U8, Wire::U16, Wire::Text),         (Wire::Ok));
+ESP8266_COMMAND(sendUDP,                    1000, (Wire::U8, Wire::Payload),                 (Wire::Ok));
+ESP8266_COMMAND(listenUDP,                  2000, (Wire::U8, Wire::U16),                     (Wire::Ok));
+ESP8266_COMMAND(availableUDP,               20,   (Wire::U8),                                (Wire::Ok));
+ESP8266_COMMAND(closeUDP,                   500,  (Wire::U8),                                (Wire::Ok));
+// plus the time the caller is ready to wait for data
+ESP8266_COMMAND(readUDP,                    300,  (Wire::U8),                                (Wire::Data));
+ESP8266_COMMAND(getRemoteInfoUDP,           800,  (Wire::U8),                                (Wire::Value, Wire::String));
+
+// HTTP client
+ESP8266_COMMAND(createHTTP,                 3000, (Wire::Bool16, Wire::U16, Wire::Text, Wire::Text), (Wire::Ok));
+ESP8266_COMMAND(sendGetHTTP,                5000, (),                                        (Wire::Value));
+ESP8266_COMMAND(getStringHTTP,              2000, (),                                        (Wire::String));
+// plus the time the caller is ready to wait for data
+ESP8266_COMMAND(readDataHTTP,               300,  (),                                        (Wire::Data));
+ESP8266_COMMAND(getSizeHTTP,                300,  (),                                        (Wire::Value));
+ESP8266_COMMAND(closeHTTP,                  200,  (),                                        (Wire::Ok));
+ESP8266_COMMAND(setFingerPrintHTTP,         200,  (Wire::Raw<20>),                           (Wire::Ok));
+ESP8266_COMMAND(setInSecureHTTP,            200,  (),                                        (Wire::Ok));
+ESP8266_COMMAND(addHeaderHTTP,              200,  (Wire::Text, Wire::Text),                  (Wire::Ok));
+ESP8266_COMMAND(getResponseHeaderCountHTTP, 300,  (),                                        (Wire::Value));
+ESP8266_COMMAND(getResponseHeaderHTTP,      400,  (Wire::U32),                               (Wire::String, Wire::String));
+ESP8266_COMMAND(sendPostHttp,               3000, (Wire::Payload),                           (Wire::Value));
+
+// ESP-NOW
+ESP8266_COMMAND(espNowInit,                 200,  (),                                        (Wire::Ok));
+ESP8266_COMMAND(espNowAddPeer,              200,  (Wire::U8, Wire::Text),                    (Wire::Ok));
+ESP8266_COMMAND(espNowRemovePeer,           200,  (Wire::Text),                              (Wire::Ok));
+ESP8266_COMMAND(espNowSend,                 1000, (Wire::Text, Wire::Payload),               (Wire::Ok));
+ESP8266_COMMAND(espNowReceive,              500,  (),                                        (Wire::Data));
+ESP8266_COMMAND(espNowDeInit,               200,  (),                                        (Wire::Ok));
+
+// crypto
+ESP8266_COMMAND(sha1,                       500,  (Wire::Payload),                           (Wire::Data));
+
+// link, events and sockets
+ESP8266_COMMAND(setLinkMode,                200,  (Wire::U8),                                (Wire::Ok));
+ESP8266_COMMAND(setEventMask,               200,  (Wire::U16),                               (Wire::Ok));
+ESP8266_COMMAND(getSocketStatus,            200,  (),                                        (Wire::Data));
+ESP8266_COMMAND(readSomeTCP,                300,  (Wire::U8, Wire::U16),                     (Wire::Data));
+ESP8266_COMMAND(sendChunkTCP,               3000, (Wire::U8, Wire::Payload),                 (Wire::Value));
+
+// HTTP
+ESP8266_COMMAND(readChunkHTTP,              1300, (Wire::U16),                               (Wire::Data));
+ESP8266_COMMAND(setReuseHTTP,               300,  (Wire::Bool),                              (Wire::Ok));
+ESP8266_COMMAND(requestHTTP,                5000, (Wire::Http, Wire::Payload),               (Wire::String));
+ESP8266_COMMAND(beginStreamHTTP,            5000, (Wire::Http, Wire::U32),                   (Wire::Ok));
+ESP8266_COMMAND(sendStreamHTTP,             3000, (Wire::Payload),                           (Wire::Ok));
+ESP8266_COMMAND(endStreamHTTP,              5000, (),                                        (Wire::String));
+
+// link
+ESP8266_COMMAND(setCompression,             200,  (Wire::Bool),                              (Wire::Ok));
+ESP8266_COMMAND(echo,                       1000, (Wire::Payload),                           (Wire::Data));
+ESP8266_COMMAND(probeBaudRate,              200,  (Wire::U32, Wire::U16),                    (Wire::Ok));
+
+// addresses, as their bytes
+ESP8266_COMMAND(getLocalIPBinary,           200,  (),                                        (Wire::IPv4));
+ESP8266_COMMAND(getGatewayIPBinary,         200,  (),                                        (Wire::IPv4));
+ESP8266_COMMAND(getSubnetMaskBinary,        200,  (),                                        (Wire::IPv4));
+ESP8266_COMMAND(getMacBinary,               200,  (),                                        (Wire::Mac));
+ESP8266_COMMAND(setStationIPBinary,         1000, (Wire::IPv4, Wire::IPv4, Wire::IPv4, Wire::IPv4, Wire::IPv4), (Wire::Ok));
+ESP8266_COMMAND(setSoftAPIPBinary,          5000, (Wire::IPv4, Wire::IPv4, Wire::IPv4),      (Wire::Ok));
+ESP8266_COMMAND(getSoftAPIPBinary,          400,  (),                                        (Wire::IPv4, Wire::Mac));
+ESP8266_COMMAND(getSoftAPClientBinary,      400,  (Wire::U16),                               (Wire::IPv4, Wire::Mac));
+ESP8266_COMMAND(espNowAddPeerBinary,        200,  (Wire::U8, Wire::Mac),                     (Wire::Ok));
+ESP8266_COMMAND(espNowRemovePeerBinary,     200,  (Wire::Mac),                               (Wire::Ok));
+ESP8266_COMMAND(espNowSendBinary,           1000, (Wire::Mac, Wire::Payload),                (Wire::Ok));
+
+#undef ESP8266_COMMAND
+#undef ESP8266_WIRE
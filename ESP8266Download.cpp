@@ -0,0 +1,133 @@
+///
+/// @file ESP8266Download.cpp
+/// @brief The implementation of class ESP8266Download.
+///
+
+#include "ESP8266Download.h"
+
+ESP8266Download::ESP8266Download(ESP8266 &esp, const std::uint16_t chunkSize)
+{
+    this->esp = &esp;
+    this->chunkSize = chunkSize != 0 ? chunkSize : 1;
+    this->total = unknownSize;
+    this->received = 0;
+    this->ended = true;
+    this->failed = false;
+    this->nextChunk = 0;
+    this->oldestChunk = 0;
+    this->chunksInFlight = 0;
+
+    this->sizeRequest.setCallback([this](ESP8266Request &request)
+    {
+        this->total = request.isOk() ? request.getValue32() : unknownSize;
+
+        // an empty body, or one already delivered, needs no more reads
+        if(this->total != unknownSize && this->received >= this->total)
+            this->ended = true;
+    });
+
+    for(std::uint8_t i = 0; i < maxChunks; i++)
+    {
+        this->buffers[i] = new std::uint8_t[this->chunkSize];
+        this->chunks[i].setCallback([this](ESP8266Request&)
+        {
+            this->deliver();
+        });
+    }
+}
+
+ESP8266Download::~ESP8266Download()
+{
+    // the buffers must outlive the requests using them
+    for(std::uint8_t i = 0; i < maxChunks; i++)
+    {
+        this->esp->cancel(this->chunks[i]);
+        delete[] this->buffers[i];
+    }
+}
+
+void ESP8266Download::beginHTTP(const Handler &handler)
+{
+    this->esp->cancel(this->sizeRequest);
+    for(std::uint8_t i = 0; i < maxChunks; i++)
+        this->esp->cancel(this->chunks[i]);
+
+    this->handler = handler;
+    this->total = unknownSize;
+    this->received = 0;
+    this->ended = false;
+    this->failed = false;
+    this->nextChunk = 0;
+    this->oldestChunk = 0;
+    this->chunksInFlight = 0;
+
+    // the reads do not wait for the size, they are queued behind it
+    this->esp->getSizeHTTPAsync(this->sizeRequest);
+    this->update();
+}
+
+void ESP8266Download::deliver(void)
+{
+    // in order, framed replies may overtake each other
+    while(this->chunksInFlight != 0 && this->chunks[this->oldestChunk].isReady())
+    {
+        ESP8266Request &chunk = this->chunks[this->oldestChunk];
+        if(!this->ended && !this->failed)
+        {
+            if(!chunk.isOk())
+                this->failed = true;
+            else if(chunk.getSize() == 0)
+                this->ended = true;
+            else
+            {
+                this->received += chunk.getSize();
+                if(!this->handler(this->buffers[this->oldestChunk], chunk.getSize()))
+                    this->failed = true;
+                else if(this->total != unknownSize && this->received >= this->total)
+                    this->ended = true;
+            }
+        }
+
+        this->oldestChunk = (this->oldestChunk + 1) % maxChunks;
+        this->chunksInFlight--;
+    }
+}
+
+void ESP8266Download::update(void)
+{
+    while(!this->ended && !this->failed && this->chunksInFlight < maxChunks && !this->esp->isBusy())
+    {
+        // no read past the announced end
+        if(this->total != unknownSize && this->received + this->chunksInFlight * this->chunkSize >= this->total)
+        {
+            if(this->received >= this->total)
+                this->ended = true;
+            return;
+        }
+
+        const std::uint8_t index = this->nextChunk;
+        this->nextChunk = (this->nextChunk + 1) % maxChunks;
+        this->chunksInFlight++;
+        this->esp->readChunkHTTPAsync(this->chunks[index], this->buffers[index], this->chunkSize);
+    }
+}
+
+bool ESP8266Download::isDone(void) const
+{
+    return (this->ended || this->failed) && this->chunksInFlight == 0 && this->sizeRequest.getStatus() != RequestStatus::Pending;
+}
+
+bool ESP8266Download::isFailed(void) const
+{
+    return this->failed || (this->total != unknownSize && this->received < this->total);
+}
+
+std::uint32_t ESP8266Download::getProgress(void) const
+{
+    return this->received;
+}
+
+std::uint32_t ESP8266Download::getSize(void) const
+{
+    return this->total;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "ESP8266.h"
+
+/// @brief
+/// The body of the current HTTP response, delivered in chunks.
+///
+/// Two readChunkHTTP commands are kept in flight, each into its own chunk
+/// buffer, and every chunk is handed to the handler in order as soon as it
+/// arrives. Only those two buffers are allocated, whatever the body size.
+///
+/// The download ends with an empty chunk, or once the Content-Length
+/// reported by getSizeHTTP has arrived.
+///
+class ESP8266Download
+{
+public:
+    /// Called with every chunk, return false to stop the download.
+    using Handler = std::function<bool(const std::uint8_t* data, std::uint16_t size)>;
+
+private:
+	static const std::uint8_t maxChunks = 2;
+	static const std::uint32_t unknownSize = 0xFFFFFFFF;
+
+	ESP8266* esp;
+	Handler handler;
+	std::uint16_t chunkSize;
+
+	std::uint32_t total;
+	std::uint32_t received;
+	bool ended;
+	bool failed;
+
+	ESP8266Request sizeRequest;
+	ESP8266Request chunks[maxChunks];
+	std::uint8_t* buffers[maxChunks];
+	std::uint8_t nextChunk;
+	std::uint8_t oldestChunk;
+	std::uint8_t chunksInFlight;
+
+private:
+    void deliver(void);
+
+public:
+    /// @param esp - the driver.
+    /// @param chunkSize - the largest chunk handed to the handler.
+    ///
+    explicit ESP8266Download(ESP8266 &esp, const std::uint16_t chunkSize = ESP8266_STREAM_CHUNK);
+    ~ESP8266Download();
+
+    ESP8266Download(const ESP8266Download&) = delete;
+    ESP8266Download& operator=(const ESP8266Download&) = delete;
+
+    /// @brief
+    /// Start reading the body of the response to sendGetHTTP(), a running
+    /// download is dropped.
+    ///
+    /// @param handler - receives the chunks.
+    ///
+    void beginHTTP(const Handler &handler);
+
+    /// @brief
+    /// Request the next chunks, call it after ESP8266::poll().
+    /// Does not wait.
+    ///
+    void update(void);
+
+    /// @brief
+    /// Check if the download is over, whatever the outcome.
+    ///
+    bool isDone(void) const;
+
+    /// @brief
+    /// Check if a read failed, the handler stopped the download or the
+    /// body ended before its Content-Length.
+    ///
+    bool isFailed(void) const;
+
+    /// @brief
+    /// Get the number of body bytes handed to the handler.
+    ///
+    std::uint32_t getProgress(void) const;
+
+    /// @brief
+    /// Get the Content-Length of the body.
+    ///
+    /// @return 0xFFFFFFFF while unknown or when the server did not send it.
+    ///
+    std::uint32_t getSize(void) const;
+};
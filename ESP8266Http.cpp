@@ -0,0 +1,86 @@
+///
+/// @file ESP8266Http.cpp
+/// @brief The implementation of class HttpResponse.
+///
+
+#include "ESP8266Http.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+// The reply is text: a line each for the code, the Content-Length and the
+// header count, then a name line and a value line per header.
+static const std::size_t headerLine = 3;
+
+std::size_t HttpResponse::findLine(std::size_t index) const
+{
+    std::size_t position = 0;
+    for(; index != 0 && position != std::string::npos; index--)
+    {
+        position = this->raw.find('\n', position);
+        if(position != std::string::npos)
+            position++;
+    }
+    return position;
+}
+
+std::int32_t HttpResponse::getCode(void) const
+{
+    if(this->raw.empty())
+        return -1;
+
+    return static_cast<std::int32_t>(std::strtol(this->raw.c_str(), nullptr, 10));
+}
+
+std::uint32_t HttpResponse::getContentLength(void) const
+{
+    const std::size_t position = this->findLine(1);
+    if(position == std::string::npos)
+        return 0xFFFFFFFF;
+
+    return static_cast<std::uint32_t>(std::strtol(this->raw.c_str() + position, nullptr, 10));
+}
+
+std::size_t HttpResponse::getHeaderCount(void) const
+{
+    const std::size_t position = this->findLine(2);
+    if(position == std::string::npos)
+        return 0;
+
+    return std::strtoul(this->raw.c_str() + position, nullptr, 10);
+}
+
+bool HttpResponse::getHeader(const std::size_t index, std::string &name, std::string &value) const
+{
+    if(index >= this->getHeaderCount())
+        return false;
+
+    const std::size_t position = this->findLine(headerLine + 2 * index);
+    const std::size_t nameEnd = position != std::string::npos ? this->raw.find('\n', position) : std::string::npos;
+    const std::size_t valueEnd = nameEnd != std::string::npos ? this->raw.find('\n', nameEnd + 1) : std::string::npos;
+    if(valueEnd == std::string::npos)
+        return false;
+
+    name.assign(this->raw, position, nameEnd - position);
+    value.assign(this->raw, nameEnd + 1, valueEnd - nameEnd - 1);
+    return true;
+}
+
+bool HttpResponse::getHeader(const std::string &name, std::string &value) const
+{
+    std::string candidate;
+    for(std::size_t i = 0; i < this->getHeaderCount(); i++)
+    {
+        if(!this->getHeader(i, candidate, value))
+            break;
+
+        if(candidate.size() == name.size() && std::equal(candidate.begin(), candidate.end(), name.begin(), [](const char a, const char b)
+        {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        }))
+            return true;
+    }
+
+    value.clear();
+    return false;
+}
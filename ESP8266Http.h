@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @brief
+/// Everything about an HTTP request, sent to the ESP8266 in a single command.
+///
+struct HttpRequest
+{
+    std::string method = "GET";
+    std::string host;
+    std::uint16_t port = 80;
+    std::string uri = "/";
+    bool https = false;
+
+    /// Request headers, at most 255.
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    /// Names of the response headers to return, at most 255.
+    std::vector<std::string> responseHeaders;
+
+    /// Optional body, sent without copying, must stay alive until the request is sent.
+    const std::uint8_t* body = nullptr;
+    std::uint16_t bodySize = 0;
+};
+
+/// ESP8266HTTPClient error code, the body could not be sent.
+static const std::int32_t httpErrorSendPayloadFailed = -3;
+
+/// @brief
+/// Status, Content-Length and collected headers of an HTTP response.
+///
+/// Kept as the reply bytes and decoded on access, the body stays on the
+/// ESP8266 for readChunkHTTP(), getStringHTTP() or downloadHTTP().
+///
+class HttpResponse
+{
+    friend class ESP8266;
+
+private:
+	std::string raw;
+
+private:
+    std::size_t findLine(std::size_t index) const;
+
+public:
+    /// @brief
+    /// Get the http code.
+    ///
+    /// @return the http code, or an error code below 0.
+    ///
+    std::int32_t getCode(void) const;
+
+    /// @brief
+    /// Get the Content-Length of the body.
+    ///
+    /// @return 0xFFFFFFFF when the server did not send it.
+    ///
+    std::uint32_t getContentLength(void) const;
+
+    /// @brief
+    /// Get the number of response headers returned.
+    ///
+    std::size_t getHeaderCount(void) const;
+
+    /// @brief
+    /// Get a response header by position.
+    ///
+    /// @param index - the position, below getHeaderCount().
+    /// @param name - receives the header name.
+    /// @param value - receives the header value.
+    ///
+    /// @retval true - success.
+    /// @retval false - no such header.
+    ///
+    bool getHeader(const std::size_t index, std::string &name, std::string &value) const;
+
+    /// @brief
+    /// Get a response header by name, ignoring case.
+    ///
+    /// @param name - the header name.
+    /// @param value - receives the header value.
+    ///
+    /// @retval true - success.
+    /// @retval false - the server did not send it or it was not requested.
+    ///
+    bool getHeader(const std::string &name, std::string &value) const;
+};
@@ -0,0 +1,226 @@
+///
+/// @file ESP8266MbedTransport.cpp
+/// @brief The Pokitto UART transport of class ESP8266.
+///
+
+#ifndef ESP8266_POSIX
+
+#include "ESP8266MbedTransport.h"
+#include <Pokitto.h>
+
+ESP8266MbedTransport::ESP8266MbedTransport(std::uint32_t baud)
+: pinEnable(P0_21), pinReset(P0_20), pinProg(P1_1)
+{
+    this->rxOverruns = 0;
+    this->rxHighWater = 0;
+
+    this->txActive = false;
+    this->bulkData = nullptr;
+    this->bulkSize = 0;
+    this->bulkLead = 0;
+
+    this->uart=new Serial(USBTX, USBRX);
+    this->uart->baud(baud);
+    this->baud = baud;
+    this->uart->attach(this, &ESP8266MbedTransport::onRxInterrupt, Serial::RxIrq);
+}
+
+ESP8266MbedTransport::~ESP8266MbedTransport()
+{
+    // both handlers point at this object, a byte moving afterwards would run them on freed memory
+    __disable_irq();
+    this->uart->attach(NULL, Serial::RxIrq);
+    this->uart->attach(NULL, Serial::TxIrq);
+    this->txActive = false;
+    __enable_irq();
+
+    delete this->uart;
+}
+
+bool ESP8266MbedTransport::begin(void)
+{
+    pinEnable = 1;
+	pinProg = 1;
+	pinReset = 1;
+
+	return true;
+}
+
+bool ESP8266MbedTransport::setBaudRate(const std::uint32_t baud)
+{
+    if(!this->isBaudRateSupported(baud))
+        return false;
+
+    this->flushTx();
+    this->uart->baud(baud);
+    this->baud = baud;
+    return true;
+}
+
+std::uint32_t ESP8266MbedTransport::getBaudRate(void) const
+{
+    return this->baud;
+}
+
+//
+// Receive
+//
+
+void ESP8266MbedTransport::onRxInterrupt(void)
+{
+    while(this->uart->readable())
+    {
+        if(!this->rxBuffer.push(static_cast<std::uint8_t>(this->uart->getc())))
+            this->rxOverruns = this->rxOverruns + 1;
+    }
+
+    const std::size_t level = this->rxBuffer.size();
+    if(level > this->rxHighWater)
+        this->rxHighWater = level;
+}
+
+std::size_t ESP8266MbedTransport::available(void)
+{
+    return this->rxBuffer.size();
+}
+
+std::size_t ESP8266MbedTransport::read(std::uint8_t* buffer, const std::size_t size)
+{
+    return this->rxBuffer.read(buffer, size);
+}
+
+void ESP8266MbedTransport::flushRx(void)
+{
+    this->rxBuffer.clear();
+}
+
+std::uint32_t ESP8266MbedTransport::getRxOverrunCount(void) const
+{
+    return this->rxOverruns;
+}
+
+std::size_t ESP8266MbedTransport::getRxHighWater(void) const
+{
+    return this->rxHighWater;
+}
+
+void ESP8266MbedTransport::resetRxStats(void)
+{
+    this->rxOverruns = 0;
+    this->rxHighWater = 0;
+}
+
+void ESP8266MbedTransport::onWakeup(void)
+{
+}
+
+void ESP8266MbedTransport::waitForRx(const std::uint32_t timeout)
+{
+    // any interrupt ends the sleep: a received byte, the transmitter or the timeout
+    this->wakeup.attach_us(this, &ESP8266MbedTransport::onWakeup, timeout * 1000);
+    if(this->rxBuffer.empty())
+        __WFI();
+    this->wakeup.detach();
+}
+
+//
+// Transmit
+//
+
+void ESP8266MbedTransport::write(const std::uint8_t* data, const std::size_t size)
+{
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        while(!this->txBuffer.push(data[i]))
+            this->startTx();
+    }
+
+    this->startTx();
+}
+
+void ESP8266MbedTransport::writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback)
+{
+    if(size == 0)
+    {
+        if(callback)
+            callback();
+        return;
+    }
+
+    // only one bulk transfer at a time, the previous one is usually long gone
+    while(this->bulkSize != 0)
+        ;
+
+    __disable_irq();
+    this->bulkLead = this->txBuffer.size();
+    this->bulkData = data;
+    this->bulkSize = size;
+    this->bulkCallback = callback;
+    __enable_irq();
+
+    this->startTx();
+}
+
+void ESP8266MbedTransport::startTx(void)
+{
+    __disable_irq();
+    if(!this->txActive)
+    {
+        this->txActive = true;
+        this->uart->attach(this, &ESP8266MbedTransport::onTxInterrupt, Serial::TxIrq);
+        this->onTxInterrupt();
+    }
+    __enable_irq();
+}
+
+void ESP8266MbedTransport::onTxInterrupt(void)
+{
+    while(this->uart->writeable())
+    {
+        // ring bytes queued before the bulk payload go first, the ones queued after it wait
+        if(this->bulkSize != 0 && this->bulkLead == 0)
+        {
+            this->uart->putc(*this->bulkData);
+            this->bulkData = this->bulkData + 1;
+            this->bulkSize = this->bulkSize - 1;
+
+            if(this->bulkSize == 0 && this->bulkCallback)
+                this->bulkCallback();
+            continue;
+        }
+
+        std::uint8_t value;
+        if(!this->txBuffer.pop(value))
+        {
+            this->txActive = false;
+            this->uart->attach(NULL, Serial::TxIrq);
+            return;
+        }
+
+        this->uart->putc(value);
+        if(this->bulkSize != 0)
+            this->bulkLead = this->bulkLead - 1;
+    }
+}
+
+bool ESP8266MbedTransport::isTxIdle(void)
+{
+    return !this->txActive && this->bulkSize == 0 && this->txBuffer.empty();
+}
+
+void ESP8266MbedTransport::flushTx(void)
+{
+    while(!this->isTxIdle())
+        this->startTx();
+}
+
+//
+// Clock
+//
+
+std::uint32_t ESP8266PokittoClock::getTime(void)
+{
+    return Pokitto::Core::getTime();
+}
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef ESP8266_POSIX
+
+#include <mbed.h>
+#include "ESP8266Transport.h"
+#include "RingBuffer.h"
+
+/// Size of the interrupt driven receive buffer, must be a power of two.
+#ifndef ESP8266_RX_BUFFER_SIZE
+#define ESP8266_RX_BUFFER_SIZE 512
+#endif
+
+/// Size of the interrupt driven transmit buffer, must be a power of two.
+/// Payloads do not go through it, they are sent straight from the caller's buffer.
+#ifndef ESP8266_TX_BUFFER_SIZE
+#define ESP8266_TX_BUFFER_SIZE 128
+#endif
+
+/// @brief
+/// Pokitto UART link to the ESP8266, interrupt driven in both directions.
+///
+class ESP8266MbedTransport : public ESP8266Transport
+{
+private:
+	Serial* uart;
+	std::uint32_t baud;
+
+	DigitalOut pinEnable;
+	DigitalOut pinReset;
+	DigitalOut pinProg;
+
+	RingBuffer<std::uint8_t, ESP8266_RX_BUFFER_SIZE> rxBuffer;
+	volatile std::uint32_t rxOverruns;
+	volatile std::size_t rxHighWater;
+
+	RingBuffer<std::uint8_t, ESP8266_TX_BUFFER_SIZE> txBuffer;
+	volatile bool txActive;
+	const std::uint8_t* volatile bulkData;
+	volatile std::size_t bulkSize;
+	volatile std::size_t bulkLead;
+	std::function<void(void)> bulkCallback;
+
+	Timeout wakeup;
+
+private:
+    void onRxInterrupt(void);
+    void onTxInterrupt(void);
+    void startTx(void);
+    void onWakeup(void);
+
+public:
+    ESP8266MbedTransport(std::uint32_t baud = 230400);
+    ~ESP8266MbedTransport();
+
+    ESP8266MbedTransport(const ESP8266MbedTransport&) = delete;
+    ESP8266MbedTransport& operator=(const ESP8266MbedTransport&) = delete;
+
+    bool begin(void) override;
+    bool setBaudRate(const std::uint32_t baud) override;
+    std::uint32_t getBaudRate(void) const override;
+
+    std::size_t available(void) override;
+    std::size_t read(std::uint8_t* buffer, const std::size_t size) override;
+    void flushRx(void) override;
+    void waitForRx(const std::uint32_t timeout) override;
+
+    void write(const std::uint8_t* data, const std::size_t size) override;
+    void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) override;
+    bool isTxIdle(void) override;
+    void flushTx(void) override;
+
+    std::uint32_t getRxOverrunCount(void) const override;
+    std::size_t getRxHighWater(void) const override;
+    void resetRxStats(void) override;
+};
+
+/// @brief
+/// Pokitto system timer.
+///
+class ESP8266PokittoClock : public ESP8266Clock
+{
+public:
+    std::uint32_t getTime(void) override;
+};
+
+#endif
@@ -0,0 +1,227 @@
+///
+/// @file ESP8266PosixTransport.cpp
+/// @brief The Linux host transport of class ESP8266.
+///
+
+#ifdef ESP8266_POSIX
+
+#include "ESP8266PosixTransport.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// B0 for a rate termios has no constant for, B0 hangs up the line
+static speed_t toSpeed(const std::uint32_t baud)
+{
+    switch(baud)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+#ifdef B460800
+        case 460800: return B460800;
+#endif
+#ifdef B921600
+        case 921600: return B921600;
+#endif
+#ifdef B1000000
+        case 1000000: return B1000000;
+#endif
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+        default: return B0;
+    }
+}
+
+ESP8266PosixTransport::ESP8266PosixTransport(const int fd)
+: fd(fd), ownsFd(false), baud(0)
+{
+    const int flags = ::fcntl(this->fd, F_GETFL);
+    if(flags >= 0)
+        ::fcntl(this->fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+ESP8266PosixTransport::ESP8266PosixTransport(const char* path, const std::uint32_t baud)
+: fd(::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK)), ownsFd(true), baud(0)
+{
+    if(this->fd < 0 || !::isatty(this->fd))
+        return;
+
+    termios options;
+    if(::tcgetattr(this->fd, &options) != 0)
+        return;
+
+    ::cfmakeraw(&options);
+    options.c_cflag |= (CLOCAL | CREAD);
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+    ::tcsetattr(this->fd, TCSANOW, &options);
+
+    this->setBaudRate(baud);
+}
+
+ESP8266PosixTransport::~ESP8266PosixTransport()
+{
+    if(this->ownsFd && this->fd >= 0)
+        ::close(this->fd);
+}
+
+bool ESP8266PosixTransport::isOpen(void) const
+{
+    return this->fd >= 0;
+}
+
+int ESP8266PosixTransport::getFileDescriptor(void) const
+{
+    return this->fd;
+}
+
+bool ESP8266PosixTransport::isBaudRateSupported(const std::uint32_t baud) const
+{
+    // a socketpair or a pipe carries any rate
+    if(!::isatty(this->fd))
+        return baud != 0;
+
+    return toSpeed(baud) != B0;
+}
+
+bool ESP8266PosixTransport::setBaudRate(const std::uint32_t baud)
+{
+    if(!this->isBaudRateSupported(baud))
+        return false;
+    if(!::isatty(this->fd))
+        return true;
+
+    termios options;
+    if(::tcgetattr(this->fd, &options) != 0)
+        return false;
+
+    ::tcdrain(this->fd);
+    if(::cfsetispeed(&options, toSpeed(baud)) != 0 || ::cfsetospeed(&options, toSpeed(baud)) != 0 ||
+       ::tcsetattr(this->fd, TCSANOW, &options) != 0)
+        return false;
+
+    this->baud = baud;
+    return true;
+}
+
+std::uint32_t ESP8266PosixTransport::getBaudRate(void) const
+{
+    return this->baud;
+}
+
+//
+// Receive
+//
+
+std::size_t ESP8266PosixTransport::available(void)
+{
+    int count = 0;
+    if(::ioctl(this->fd, FIONREAD, &count) < 0 || count < 0)
+        return 0;
+
+    return static_cast<std::size_t>(count);
+}
+
+std::size_t ESP8266PosixTransport::read(std::uint8_t* buffer, const std::size_t size)
+{
+    if(size == 0)
+        return 0;
+
+    const ssize_t count = ::read(this->fd, buffer, size);
+    if(count <= 0)
+        return 0;
+
+    return static_cast<std::size_t>(count);
+}
+
+void ESP8266PosixTransport::flushRx(void)
+{
+    std::uint8_t scratch[256];
+    while(this->read(scratch, sizeof(scratch)) != 0)
+        ;
+}
+
+void ESP8266PosixTransport::waitForRx(const std::uint32_t timeout)
+{
+    pollfd descriptor;
+    descriptor.fd = this->fd;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    ::poll(&descriptor, 1, static_cast<int>(timeout));
+}
+
+//
+// Transmit
+//
+
+void ESP8266PosixTransport::waitWritable(void)
+{
+    pollfd descriptor;
+    descriptor.fd = this->fd;
+    descriptor.events = POLLOUT;
+    descriptor.revents = 0;
+    ::poll(&descriptor, 1, 10);
+}
+
+void ESP8266PosixTransport::write(const std::uint8_t* data, const std::size_t size)
+{
+    std::size_t sent = 0;
+    while(sent < size)
+    {
+        const ssize_t count = ::write(this->fd, data + sent, size - sent);
+        if(count > 0)
+        {
+            sent += static_cast<std::size_t>(count);
+            continue;
+        }
+
+        if(count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return;
+
+        this->waitWritable();
+    }
+}
+
+void ESP8266PosixTransport::writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback)
+{
+    this->write(data, size);
+
+    if(callback)
+        callback();
+}
+
+bool ESP8266PosixTransport::isTxIdle(void)
+{
+    return true;
+}
+
+void ESP8266PosixTransport::flushTx(void)
+{
+    if(::isatty(this->fd))
+        ::tcdrain(this->fd);
+}
+
+//
+// Clock
+//
+
+ESP8266PosixClock::ESP8266PosixClock()
+: start(std::chrono::steady_clock::now())
+{
+}
+
+std::uint32_t ESP8266PosixClock::getTime(void)
+{
+    const auto elapsed = std::chrono::steady_clock::now() - this->start;
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifdef ESP8266_POSIX
+
+#include "ESP8266Transport.h"
+#include <chrono>
+
+/// @brief
+/// Linux host link to an ESP8266 or to a stand-in for it.
+///
+/// Works on any file descriptor: a serial device, a pty or one end of a
+/// socketpair. Used to run and measure the protocol code off-device.
+///
+class ESP8266PosixTransport : public ESP8266Transport
+{
+private:
+	int fd;
+	bool ownsFd;
+	std::uint32_t baud;
+
+private:
+    void waitWritable(void);
+
+public:
+    /// @brief
+    /// Use an already open descriptor, it is not closed by the transport.
+    ///
+    /// @param fd - the descriptor, a socketpair end or a pty master for example.
+    ///
+    explicit ESP8266PosixTransport(const int fd);
+
+    /// @brief
+    /// Open a serial device or a pty slave in raw mode.
+    ///
+    /// @param path - the device path.
+    /// @param baud - the baud rate, ignored when the device is not a tty.
+    ///   getBaudRate() stays 0 when the device does not take it.
+    ///
+    ESP8266PosixTransport(const char* path, const std::uint32_t baud = 230400);
+
+    ~ESP8266PosixTransport();
+
+    ESP8266PosixTransport(const ESP8266PosixTransport&) = delete;
+    ESP8266PosixTransport& operator=(const ESP8266PosixTransport&) = delete;
+
+    /// @brief
+    /// Check if the descriptor is usable.
+    ///
+    /// @retval true - open.
+    /// @retval false - the device could not be opened.
+    ///
+    bool isOpen(void) const;
+
+    /// @brief
+    /// Get the underlying descriptor, for poll() and the like.
+    ///
+    int getFileDescriptor(void) const;
+
+    bool isBaudRateSupported(const std::uint32_t baud) const override;
+    bool setBaudRate(const std::uint32_t baud) override;
+    std::uint32_t getBaudRate(void) const override;
+
+    std::size_t available(void) override;
+    std::size_t read(std::uint8_t* buffer, const std::size_t size) override;
+    void flushRx(void) override;
+    void waitForRx(const std::uint32_t timeout) override;
+
+    void write(const std::uint8_t* data, const std::size_t size) override;
+    void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) override;
+    bool isTxIdle(void) override;
+    void flushTx(void) override;
+};
+
+/// @brief
+/// Monotonic host clock.
+///
+class ESP8266PosixClock : public ESP8266Clock
+{
+private:
+	std::chrono::steady_clock::time_point start;
+
+public:
+    ESP8266PosixClock();
+
+    std::uint32_t getTime(void) override;
+};
+
+#endif
@@ -0,0 +1,163 @@
+///
+/// @file ESP8266Request.cpp
+/// @brief The implementation of class ESP8266Request.
+///
+
+#include "ESP8266Request.h"
+#include "ESP8266.h"
+#include <algorithm>
+
+ESP8266Request::ESP8266Request()
+{
+    this->owner = nullptr;
+    this->next = nullptr;
+    this->status = RequestStatus::Idle;
+    this->reset();
+}
+
+ESP8266Request::~ESP8266Request()
+{
+    if(this->owner != nullptr && this->status == RequestStatus::Pending)
+        this->owner->cancel(*this);
+}
+
+void ESP8266Request::reset(void)
+{
+    this->response = Response::Error;
+    this->seq = 0;
+    this->sending = false;
+    this->start = 0;
+    this->timeout = 0;
+    this->frameCount = 0;
+    this->frameIndex = 0;
+    this->frame.clear();
+    this->bulk = nullptr;
+    this->bulkSize = 0;
+    this->retries = 0;
+    this->packed.clear();
+
+#ifdef ESP8266_STATS
+    this->issued = 0;
+    this->bytesSent = 0;
+    this->bytesReceived = 0;
+#endif
+
+    for(std::size_t i = 0; i < sizeof(this->value); i++)
+        this->value[i] = 0;
+}
+
+void ESP8266Request::expect(const Response expected, std::uint8_t* buffer, const std::uint16_t capacity, std::string* string)
+{
+    if(this->frameCount >= maxFrames)
+        return;
+
+    Frame &frame = this->frames[this->frameCount++];
+    frame.expected = expected;
+    frame.buffer = buffer;
+    frame.string = string;
+    frame.capacity = capacity;
+    frame.size = 0;
+    frame.length = 0;
+}
+
+void ESP8266Request::restart(void)
+{
+    this->response = Response::Error;
+    this->frameIndex = 0;
+
+    for(std::size_t i = 0; i < this->frameCount; i++)
+    {
+        this->frames[i].size = 0;
+        this->frames[i].length = 0;
+        if(this->frames[i].string != nullptr)
+            this->frames[i].string->clear();
+        else if(this->frames[i].expected == Response::String && this->frames[i].buffer != nullptr)
+            this->frames[i].buffer[0] = '\0';
+    }
+}
+
+void ESP8266Request::expectOk(void)
+{
+    this->expect(Response::Ok, nullptr, 0, nullptr);
+}
+
+void ESP8266Request::expectValue(void)
+{
+    this->expect(Response::Data, this->value, sizeof(this->value), nullptr);
+}
+
+void ESP8266Request::expectData(std::uint8_t* buffer, const std::uint16_t capacity)
+{
+    this->expect(Response::Data, buffer, capacity, nullptr);
+}
+
+void ESP8266Request::expectString(std::string &string)
+{
+    string.clear();
+    this->expect(Response::String, nullptr, 0, &string);
+}
+
+void ESP8266Request::expectString(char* string, const std::size_t size)
+{
+    // one byte stays for the terminating NUL
+    if(size == 0)
+    {
+        this->expect(Response::String, nullptr, 0, nullptr);
+        return;
+    }
+
+    string[0] = '\0';
+    this->expect(Response::String, reinterpret_cast<std::uint8_t*>(string), static_cast<std::uint16_t>(std::min<std::size_t>(size, 0xFFFF)), nullptr);
+}
+
+void ESP8266Request::setCallback(const std::function<void(ESP8266Request&)> &callback)
+{
+    this->callback = callback;
+}
+
+RequestStatus ESP8266Request::getStatus(void) const
+{
+    return this->status;
+}
+
+bool ESP8266Request::isReady(void) const
+{
+    return this->status != RequestStatus::Pending;
+}
+
+bool ESP8266Request::isOk(void) const
+{
+    return this->status == RequestStatus::Done;
+}
+
+Response ESP8266Request::getResponse(void) const
+{
+    return this->response;
+}
+
+std::uint16_t ESP8266Request::getSize(void) const
+{
+    if(this->frameCount == 0)
+        return 0;
+
+    return this->frames[0].size;
+}
+
+std::uint16_t ESP8266Request::getValue16(void) const
+{
+    if(!this->isOk() || this->frames[0].length != 2)
+        return 0;
+
+    return static_cast<std::uint16_t>(this->value[0] | (this->value[1] << 8));
+}
+
+std::uint32_t ESP8266Request::getValue32(void) const
+{
+    if(!this->isOk() || this->frames[0].length != 4)
+        return 0;
+
+    return static_cast<std::uint32_t>(this->value[0])
+        | (static_cast<std::uint32_t>(this->value[1]) << 8)
+        | (static_cast<std::uint32_t>(this->value[2]) << 16)
+        | (static_cast<std::uint32_t>(this->value[3]) << 24);
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class ESP8266;
+enum class Commands: std::uint16_t;
+enum class Response: std::uint16_t;
+
+enum class RequestStatus: std::uint8_t
+{
+    Idle = 0,
+    Pending,
+    Done,
+    Failed,
+    Timeout,
+};
+
+/// @brief
+/// One command in flight and the reply it is waiting for.
+///
+/// Filled by the ...Async() calls of ESP8266 and completed while the driver
+/// receives. The request and every buffer given with it must stay alive
+/// until the request is ready.
+///
+class ESP8266Request
+{
+    friend class ESP8266;
+
+private:
+    struct Frame
+    {
+        Response expected;
+        std::uint8_t* buffer;
+        std::string* string;
+        std::uint16_t capacity;
+        std::uint16_t size;
+        std::uint16_t length;
+    };
+
+    static const std::size_t maxFrames = 2;
+
+	ESP8266* owner;
+	ESP8266Request* next;
+
+	Commands command;
+	RequestStatus status;
+	Response response;
+	std::uint8_t seq;
+	volatile bool sending;
+
+	volatile std::uint32_t start;
+	std::uint32_t timeout;
+
+	Frame frames[maxFrames];
+	std::uint8_t frameCount;
+	std::uint8_t frameIndex;
+
+	std::uint8_t value[4];
+
+	// LinkMode::Framed keeps the command to send it again
+	std::vector<std::uint8_t> frame;
+	const std::uint8_t* bulk;
+	std::uint16_t bulkSize;
+	std::uint8_t retries;
+
+	// a compressed payload, kept until it is sent
+	std::vector<std::uint8_t> packed;
+
+#ifdef ESP8266_STATS
+	std::uint32_t issued;
+	std::uint32_t bytesSent;
+	std::uint32_t bytesReceived;
+#endif
+
+	std::function<void(ESP8266Request&)> callback;
+
+private:
+    void reset(void);
+    void restart(void);
+    void expect(const Response expected, std::uint8_t* buffer, const std::uint16_t capacity, std::string* string);
+    void expectOk(void);
+    void expectValue(void);
+    void expectData(std::uint8_t* buffer, const std::uint16_t capacity);
+    void expectString(std::string &string);
+    void expectString(char* string, const std::size_t size);
+
+public:
+    ESP8266Request();
+    ~ESP8266Request();
+
+    ESP8266Request(const ESP8266Request&) = delete;
+    ESP8266Request& operator=(const ESP8266Request&) = delete;
+
+    /// @brief
+    /// Set the function called from ESP8266::poll() when the request
+    /// completes, fails or times out. It is kept for the next use of the
+    /// request, and may start a new request.
+    ///
+    /// @param callback - the function, empty for none.
+    ///
+    void setCallback(const std::function<void(ESP8266Request&)> &callback);
+
+    /// @brief
+    /// Get the state of the request.
+    ///
+    /// @return one of the value defined in RequestStatus
+    ///
+    RequestStatus getStatus(void) const;
+
+    /// @brief
+    /// Check if the request is over, whatever the outcome.
+    ///
+    /// @retval true - ready.
+    /// @retval false - still waiting for the reply.
+    ///
+    bool isReady(void) const;
+
+    /// @brief
+    /// Check if the whole expected reply arrived.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure, timeout or still pending.
+    ///
+    bool isOk(void) const;
+
+    /// @brief
+    /// Get the last response code received for this request.
+    ///
+    Response getResponse(void) const;
+
+    /// @brief
+    /// Get the number of bytes stored by the first data reply.
+    ///
+    std::uint16_t getSize(void) const;
+
+    /// @brief
+    /// Get a 16 bit reply.
+    ///
+    /// @return the value, 0 if the reply is not 2 bytes long.
+    ///
+    std::uint16_t getValue16(void) const;
+
+    /// @brief
+    /// Get a 32 bit reply.
+    ///
+    /// @return the value, 0 if the reply is not 4 bytes long.
+    ///
+    std::uint32_t getValue32(void) const;
+};
@@ -0,0 +1,145 @@
+///
+/// @file ESP8266Stats.cpp
+/// @brief The implementation of class ESP8266Stats.
+///
+
+#ifdef ESP8266_STATS
+
+#include "ESP8266Stats.h"
+#include <cstdio>
+
+std::uint32_t CommandStats::getAverage(void) const
+{
+    if(this->calls == 0)
+        return 0;
+
+    return this->latencyTotal / this->calls;
+}
+
+std::uint32_t CommandStats::getPercentile(const std::uint8_t percent) const
+{
+    std::uint32_t total = 0;
+    for(std::size_t i = 0; i < bucketCount; i++)
+        total += this->histogram[i];
+    if(total == 0)
+        return 0;
+
+    const std::uint32_t rank = (total * percent + 99) / 100;
+    std::uint32_t seen = 0;
+    for(std::size_t i = 0; i < bucketCount - 1; i++)
+    {
+        seen += this->histogram[i];
+        if(seen >= rank)
+        {
+            const std::uint32_t end = (i == 0) ? 0 : (1u << i) - 1;
+            return (end < this->latencyMax) ? end : this->latencyMax;
+        }
+    }
+    return this->latencyMax;
+}
+
+ESP8266Stats::ESP8266Stats()
+{
+    this->reset();
+}
+
+void ESP8266Stats::record(const std::uint16_t command, const bool timeout, const bool failed, const std::uint32_t latency, const std::uint32_t sent, const std::uint32_t received)
+{
+    CommandStats* stats = nullptr;
+    for(std::size_t i = 0; i < this->count && stats == nullptr; i++)
+    {
+        if(this->slots[i].command == command)
+            stats = &this->slots[i];
+    }
+
+    if(stats == nullptr)
+    {
+        if(this->count == ESP8266_STATS_SLOTS)
+        {
+            this->dropped++;
+            return;
+        }
+
+        stats = &this->slots[this->count++];
+        *stats = CommandStats();
+        stats->command = command;
+        stats->latencyMin = latency;
+    }
+
+    stats->calls++;
+    if(timeout)
+        stats->timeouts++;
+    if(failed)
+        stats->failures++;
+    stats->bytesSent += sent;
+    stats->bytesReceived += received;
+
+    if(latency < stats->latencyMin)
+        stats->latencyMin = latency;
+    if(latency > stats->latencyMax)
+        stats->latencyMax = latency;
+    stats->latencyTotal += latency;
+
+    std::size_t bucket = 0;
+    for(std::uint32_t rest = latency; rest != 0 && bucket < CommandStats::bucketCount - 1; rest >>= 1)
+        bucket++;
+
+    // halved when full, the shape and so the percentiles stay
+    if(stats->histogram[bucket] == 0xFFFF)
+    {
+        for(std::size_t i = 0; i < CommandStats::bucketCount; i++)
+            stats->histogram[i] /= 2;
+    }
+    stats->histogram[bucket]++;
+}
+
+void ESP8266Stats::reset(void)
+{
+    this->count = 0;
+    this->dropped = 0;
+}
+
+std::size_t ESP8266Stats::getCount(void) const
+{
+    return this->count;
+}
+
+const CommandStats& ESP8266Stats::get(const std::size_t index) const
+{
+    return this->slots[index];
+}
+
+std::uint32_t ESP8266Stats::getDropped(void) const
+{
+    return this->dropped;
+}
+
+void ESP8266Stats::dump(const std::function<void(const char* line)> &output) const
+{
+    char line[128];
+    output("cmd calls tmo err sent recv min avg p99 max");
+    for(std::size_t i = 0; i < this->count; i++)
+    {
+        const CommandStats &stats = this->slots[i];
+        std::snprintf(line, sizeof(line), "%3u %5lu %3lu %3lu %lu %lu %lu %lu %lu %lu",
+            static_cast<unsigned>(stats.command),
+            static_cast<unsigned long>(stats.calls),
+            static_cast<unsigned long>(stats.timeouts),
+            static_cast<unsigned long>(stats.failures),
+            static_cast<unsigned long>(stats.bytesSent),
+            static_cast<unsigned long>(stats.bytesReceived),
+            static_cast<unsigned long>(stats.latencyMin),
+            static_cast<unsigned long>(stats.getAverage()),
+            static_cast<unsigned long>(stats.getPercentile(99)),
+            static_cast<unsigned long>(stats.latencyMax));
+        output(line);
+    }
+
+    if(this->dropped != 0)
+    {
+        std::snprintf(line, sizeof(line), "%lu calls not counted", static_cast<unsigned long>(this->dropped));
+        output(line);
+    }
+}
+
+#endif
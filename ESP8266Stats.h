@@ -0,0 +1,105 @@
+#pragma once
+
+#ifdef ESP8266_STATS
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+/// Number of different commands counted, the ones used first get a slot.
+#ifndef ESP8266_STATS_SLOTS
+#define ESP8266_STATS_SLOTS 16
+#endif
+
+/// @brief
+/// What happened to one command, see ESP8266::getStats().
+///
+/// Latencies are in milliseconds, from the call to the reply.
+///
+struct CommandStats
+{
+    static const std::size_t bucketCount = 16;
+
+    std::uint16_t command;
+    std::uint32_t calls;
+    std::uint32_t timeouts;
+    std::uint32_t failures;
+    /// Command bytes, arguments and payload, as sent.
+    std::uint32_t bytesSent;
+    /// Response codes, lengths and payloads, as received.
+    std::uint32_t bytesReceived;
+    std::uint32_t latencyMin;
+    std::uint32_t latencyMax;
+    std::uint32_t latencyTotal;
+    /// Bucket 0 counts 0 ms, bucket n latencies below 2^n ms, the last one the rest.
+    std::uint16_t histogram[bucketCount];
+
+    /// @brief
+    /// Get the mean latency.
+    ///
+    std::uint32_t getAverage(void) const;
+
+    /// @brief
+    /// Get a latency percentile, rounded up to the end of its bucket.
+    ///
+    /// @param percent - the percentile, 99 for the p99.
+    ///
+    std::uint32_t getPercentile(const std::uint8_t percent) const;
+};
+
+/// @brief
+/// Per command counters of an ESP8266, built with ESP8266_STATS only.
+///
+class ESP8266Stats
+{
+private:
+	CommandStats slots[ESP8266_STATS_SLOTS];
+	std::size_t count;
+	std::uint32_t dropped;
+
+public:
+    ESP8266Stats();
+
+    /// @brief
+    /// Count a finished command.
+    ///
+    /// @param command - the command.
+    /// @param timeout - true when no reply came in time.
+    /// @param failed - true when the reply was not the expected one.
+    /// @param latency - the milliseconds from the call to the reply.
+    /// @param sent - the bytes sent.
+    /// @param received - the bytes received.
+    ///
+    void record(const std::uint16_t command, const bool timeout, const bool failed, const std::uint32_t latency, const std::uint32_t sent, const std::uint32_t received);
+
+    /// @brief
+    /// Forget every counter.
+    ///
+    void reset(void);
+
+    /// @brief
+    /// Get the number of commands counted.
+    ///
+    std::size_t getCount(void) const;
+
+    /// @brief
+    /// Get the counters of a command.
+    ///
+    /// @param index - 0 to getCount() - 1, in order of first use.
+    ///
+    const CommandStats& get(const std::size_t index) const;
+
+    /// @brief
+    /// Get the number of calls not counted because every slot was taken.
+    ///
+    std::uint32_t getDropped(void) const;
+
+    /// @brief
+    /// Format the counters one command per line, for the screen or a serial log.
+    ///
+    /// @param output - called with every line, without a line feed.
+    ///
+    void dump(const std::function<void(const char* line)> &output) const;
+};
+
+#endif
@@ -0,0 +1,460 @@
+///
+/// @file ESP8266Trace.cpp
+/// @brief The implementation of class ESP8266TraceTransport and class ESP8266ReplayTransport.
+///
+
+#include "ESP8266Trace.h"
+#include <algorithm>
+#include <cstring>
+
+static const char traceMagic[4] = { 'E', 'S', 'P', 'T' };
+static const std::uint8_t traceVersion = 1;
+
+//
+// Recording
+//
+
+ESP8266TraceTransport::ESP8266TraceTransport(ESP8266Transport &transport, ESP8266Clock &clock, std::FILE* file)
+{
+    this->transport = &transport;
+    this->clock = &clock;
+    this->file = file;
+
+    this->lastTime = clock.getTime();
+    this->pendingType = TraceRecord::Rx;
+    this->pendingTime = 0;
+    this->pendingSize = 0;
+
+    const std::uint32_t baud = transport.getBaudRate();
+    const std::uint8_t header[9] =
+    {
+        static_cast<std::uint8_t>(traceMagic[0]),
+        static_cast<std::uint8_t>(traceMagic[1]),
+        static_cast<std::uint8_t>(traceMagic[2]),
+        static_cast<std::uint8_t>(traceMagic[3]),
+        traceVersion,
+        static_cast<std::uint8_t>(baud & 0xFF),
+        static_cast<std::uint8_t>((baud >> 8) & 0xFF),
+        static_cast<std::uint8_t>((baud >> 16) & 0xFF),
+        static_cast<std::uint8_t>(baud >> 24),
+    };
+    std::fwrite(header, 1, sizeof(header), this->file);
+}
+
+ESP8266TraceTransport::~ESP8266TraceTransport()
+{
+    this->flush();
+}
+
+void ESP8266TraceTransport::writeVarint(std::uint32_t value)
+{
+    while(value >= 0x80)
+    {
+        std::fputc(static_cast<int>((value & 0x7F) | 0x80), this->file);
+        value >>= 7;
+    }
+    std::fputc(static_cast<int>(value), this->file);
+}
+
+void ESP8266TraceTransport::writeRecord(const TraceRecord type, const std::uint32_t time, const std::uint8_t* data, const std::size_t size)
+{
+    std::fputc(static_cast<int>(type), this->file);
+    this->writeVarint(time - this->lastTime);
+    this->writeVarint(static_cast<std::uint32_t>(size));
+    std::fwrite(data, 1, size, this->file);
+    this->lastTime = time;
+}
+
+void ESP8266TraceTransport::append(const TraceRecord type, const std::uint8_t* data, const std::size_t size)
+{
+    const std::uint32_t time = this->clock->getTime();
+    if(this->pendingSize != 0 && (type != this->pendingType || time != this->pendingTime || this->pendingSize + size > sizeof(this->pending)))
+        this->flushPending();
+
+    // command boundaries stay records of their own
+    if(size > sizeof(this->pending) || type == TraceRecord::Command || type == TraceRecord::BaudRate)
+    {
+        this->writeRecord(type, time, data, size);
+        return;
+    }
+
+    if(this->pendingSize == 0)
+    {
+        this->pendingType = type;
+        this->pendingTime = time;
+    }
+    std::memcpy(this->pending + this->pendingSize, data, size);
+    this->pendingSize += size;
+}
+
+void ESP8266TraceTransport::flushPending(void)
+{
+    if(this->pendingSize == 0)
+        return;
+
+    this->writeRecord(this->pendingType, this->pendingTime, this->pending, this->pendingSize);
+    this->pendingSize = 0;
+}
+
+void ESP8266TraceTransport::flush(void)
+{
+    this->flushPending();
+    std::fflush(this->file);
+}
+
+bool ESP8266TraceTransport::begin(void)
+{
+    return this->transport->begin();
+}
+
+bool ESP8266TraceTransport::isBaudRateSupported(const std::uint32_t baud) const
+{
+    return this->transport->isBaudRateSupported(baud);
+}
+
+bool ESP8266TraceTransport::setBaudRate(const std::uint32_t baud)
+{
+    // only a change that took place is part of the traffic
+    if(!this->transport->setBaudRate(baud))
+        return false;
+
+    const std::uint8_t bytes[4] =
+    {
+        static_cast<std::uint8_t>(baud & 0xFF),
+        static_cast<std::uint8_t>((baud >> 8) & 0xFF),
+        static_cast<std::uint8_t>((baud >> 16) & 0xFF),
+        static_cast<std::uint8_t>(baud >> 24),
+    };
+    this->append(TraceRecord::BaudRate, bytes, sizeof(bytes));
+    return true;
+}
+
+std::uint32_t ESP8266TraceTransport::getBaudRate(void) const
+{
+    return this->transport->getBaudRate();
+}
+
+std::size_t ESP8266TraceTransport::available(void)
+{
+    return this->transport->available();
+}
+
+std::size_t ESP8266TraceTransport::read(std::uint8_t* buffer, const std::size_t size)
+{
+    // only what the driver reads, bytes dropped by flushRx() never mattered
+    const std::size_t count = this->transport->read(buffer, size);
+    if(count != 0)
+        this->append(TraceRecord::Rx, buffer, count);
+    return count;
+}
+
+void ESP8266TraceTransport::flushRx(void)
+{
+    this->transport->flushRx();
+}
+
+void ESP8266TraceTransport::waitForRx(const std::uint32_t timeout)
+{
+    this->transport->waitForRx(timeout);
+}
+
+void ESP8266TraceTransport::write(const std::uint8_t* data, const std::size_t size)
+{
+    this->append(TraceRecord::Tx, data, size);
+    this->transport->write(data, size);
+}
+
+void ESP8266TraceTransport::writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback)
+{
+    this->append(TraceRecord::Tx, data, size);
+    this->transport->writeBulk(data, size, callback);
+}
+
+bool ESP8266TraceTransport::isTxIdle(void)
+{
+    return this->transport->isTxIdle();
+}
+
+void ESP8266TraceTransport::flushTx(void)
+{
+    this->transport->flushTx();
+}
+
+std::uint32_t ESP8266TraceTransport::getRxOverrunCount(void) const
+{
+    return this->transport->getRxOverrunCount();
+}
+
+std::size_t ESP8266TraceTransport::getRxHighWater(void) const
+{
+    return this->transport->getRxHighWater();
+}
+
+void ESP8266TraceTransport::resetRxStats(void)
+{
+    this->transport->resetRxStats();
+}
+
+void ESP8266TraceTransport::markCommand(const std::uint16_t command)
+{
+    const std::uint8_t bytes[2] = { static_cast<std::uint8_t>(command & 0xFF), static_cast<std::uint8_t>(command >> 8) };
+    this->append(TraceRecord::Command, bytes, sizeof(bytes));
+    this->transport->markCommand(command);
+}
+
+//
+// Replay
+//
+
+ESP8266ReplayTransport::ESP8266ReplayTransport(std::FILE* file)
+{
+    std::uint8_t buffer[512];
+    std::size_t count;
+    while((count = std::fread(buffer, 1, sizeof(buffer), file)) != 0)
+        this->trace.insert(this->trace.end(), buffer, buffer + count);
+
+    this->valid = this->parse();
+    this->rewind();
+}
+
+bool ESP8266ReplayTransport::parse(void)
+{
+    const std::size_t headerSize = sizeof(traceMagic) + 5;
+    if(this->trace.size() < headerSize || std::memcmp(this->trace.data(), traceMagic, sizeof(traceMagic)) != 0 ||
+       this->trace[sizeof(traceMagic)] != traceVersion)
+        return false;
+
+    std::size_t offset = headerSize;
+    std::uint32_t time = 0;
+    while(offset < this->trace.size())
+    {
+        Record record;
+        record.type = static_cast<TraceRecord>(this->trace[offset++]);
+
+        std::uint32_t values[2] = { 0, 0 };
+        for(std::size_t i = 0; i < 2; i++)
+        {
+            for(std::uint8_t shift = 0; ; shift += 7)
+            {
+                if(offset == this->trace.size() || shift > 28)
+                    return false;
+                const std::uint8_t value = this->trace[offset++];
+                values[i] |= static_cast<std::uint32_t>(value & 0x7F) << shift;
+                if((value & 0x80) == 0)
+                    break;
+            }
+        }
+
+        time += values[0];
+        record.time = time;
+        record.offset = offset;
+        record.size = values[1];
+        if(record.size > this->trace.size() - offset)
+            return false;
+        if((record.type == TraceRecord::Command && record.size != 2) || (record.type == TraceRecord::BaudRate && record.size != 4))
+            return false;
+
+        offset += record.size;
+        this->records.push_back(record);
+    }
+    return true;
+}
+
+void ESP8266ReplayTransport::rewind(void)
+{
+    this->rxIndex = 0;
+    this->rxOffset = 0;
+    this->txIndex = 0;
+    this->txOffset = 0;
+    this->time = 0;
+    this->mismatches = 0;
+    this->divergences = 0;
+
+    const std::uint8_t* header = this->trace.data() + sizeof(traceMagic) + 1;
+    this->baud = this->valid ? static_cast<std::uint32_t>(header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<std::uint32_t>(header[3]) << 24)) : 0;
+}
+
+void ESP8266ReplayTransport::skipRx(void)
+{
+    while(this->rxIndex < this->records.size() && this->records[this->rxIndex].type != TraceRecord::Rx)
+        this->rxIndex++;
+}
+
+void ESP8266ReplayTransport::skipTx(void)
+{
+    while(this->txIndex < this->records.size() && this->records[this->txIndex].type == TraceRecord::Rx)
+        this->txIndex++;
+}
+
+void ESP8266ReplayTransport::use(const Record &record)
+{
+    this->time = std::max(this->time, record.time);
+}
+
+bool ESP8266ReplayTransport::isValid(void) const
+{
+    return this->valid;
+}
+
+bool ESP8266ReplayTransport::isDone(void)
+{
+    this->skipRx();
+    this->skipTx();
+    return this->rxIndex == this->records.size() && this->txIndex == this->records.size();
+}
+
+std::uint32_t ESP8266ReplayTransport::getMismatches(void) const
+{
+    return this->mismatches;
+}
+
+std::uint32_t ESP8266ReplayTransport::getDivergences(void) const
+{
+    return this->divergences;
+}
+
+std::size_t ESP8266ReplayTransport::getRxSize(void) const
+{
+    std::size_t size = 0;
+    for(const Record &record : this->records)
+    {
+        if(record.type == TraceRecord::Rx)
+            size += record.size;
+    }
+    return size;
+}
+
+bool ESP8266ReplayTransport::setBaudRate(const std::uint32_t baud)
+{
+    this->skipTx();
+    if(this->txIndex < this->records.size() && this->records[this->txIndex].type == TraceRecord::BaudRate && this->txOffset == 0)
+    {
+        const Record &record = this->records[this->txIndex++];
+        const std::uint8_t* bytes = this->trace.data() + record.offset;
+        if(baud != static_cast<std::uint32_t>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24)))
+            this->mismatches++;
+        this->use(record);
+    }
+    else
+    {
+        this->divergences++;
+        return false;
+    }
+
+    this->baud = baud;
+    return true;
+}
+
+std::uint32_t ESP8266ReplayTransport::getBaudRate(void) const
+{
+    return this->baud;
+}
+
+std::size_t ESP8266ReplayTransport::available(void)
+{
+    this->skipRx();
+    this->skipTx();
+
+    // received only after everything recorded before it was written
+    if(this->rxIndex >= this->txIndex || this->rxIndex == this->records.size())
+        return 0;
+
+    return this->records[this->rxIndex].size - this->rxOffset;
+}
+
+std::size_t ESP8266ReplayTransport::read(std::uint8_t* buffer, const std::size_t size)
+{
+    std::size_t count = 0;
+    while(count < size)
+    {
+        const std::size_t ready = this->available();
+        if(ready == 0)
+            break;
+
+        const Record &record = this->records[this->rxIndex];
+        if(this->rxOffset == 0)
+            this->use(record);
+
+        const std::size_t chunk = std::min(ready, size - count);
+        std::memcpy(buffer + count, this->trace.data() + record.offset + this->rxOffset, chunk);
+        count += chunk;
+        this->rxOffset += chunk;
+        if(this->rxOffset == record.size)
+        {
+            this->rxIndex++;
+            this->rxOffset = 0;
+        }
+    }
+    return count;
+}
+
+void ESP8266ReplayTransport::flushRx(void)
+{
+    // the trace only holds what was read
+}
+
+void ESP8266ReplayTransport::write(const std::uint8_t* data, const std::size_t size)
+{
+    for(std::size_t i = 0; i < size; i++)
+    {
+        this->skipTx();
+        if(this->txIndex == this->records.size() || this->records[this->txIndex].type != TraceRecord::Tx)
+        {
+            this->mismatches++;
+            continue;
+        }
+
+        const Record &record = this->records[this->txIndex];
+        if(this->txOffset == 0)
+            this->use(record);
+        if(this->trace[record.offset + this->txOffset] != data[i])
+            this->mismatches++;
+
+        if(++this->txOffset == record.size)
+        {
+            this->txIndex++;
+            this->txOffset = 0;
+        }
+    }
+}
+
+void ESP8266ReplayTransport::writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback)
+{
+    this->write(data, size);
+    if(callback)
+        callback();
+}
+
+bool ESP8266ReplayTransport::isTxIdle(void)
+{
+    return true;
+}
+
+void ESP8266ReplayTransport::flushTx(void)
+{
+}
+
+void ESP8266ReplayTransport::markCommand(const std::uint16_t command)
+{
+    this->skipTx();
+    if(this->txIndex == this->records.size() || this->records[this->txIndex].type != TraceRecord::Command || this->txOffset != 0)
+    {
+        this->divergences++;
+        return;
+    }
+
+    const Record &record = this->records[this->txIndex++];
+    const std::uint8_t* bytes = this->trace.data() + record.offset;
+    if(command != static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8)))
+        this->divergences++;
+    this->use(record);
+}
+
+std::uint32_t ESP8266ReplayTransport::getTime(void)
+{
+    // idle, time goes on so that timeouts come
+    if(this->available() == 0)
+        this->time++;
+
+    return this->time;
+}
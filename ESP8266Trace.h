@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "ESP8266Transport.h"
+
+/// Bytes of the same direction and millisecond collected into one record.
+#ifndef ESP8266_TRACE_BUFFER
+#define ESP8266_TRACE_BUFFER 64
+#endif
+
+/// @brief
+/// Kinds of record in a trace.
+///
+/// A trace starts with "ESPT", a version byte and the baud rate of the
+/// link (u32). Every record is its kind, the milliseconds since the
+/// previous record and its size, both as LEB128 varints, then the bytes.
+///
+enum class TraceRecord: std::uint8_t
+{
+    /// Bytes read from the ESP8266.
+    Rx = 1,
+    /// Bytes written to the ESP8266.
+    Tx,
+    /// A command starts, its Commands value (u16).
+    Command,
+    /// The local baud rate changes, the new rate (u32).
+    BaudRate,
+};
+
+/// @brief
+/// Transport recording the traffic of another one into a trace file.
+///
+/// Every byte read or written goes to the file with its time and the
+/// command boundaries, the SD card on the Pokitto or any file on Linux.
+/// ESP8266ReplayTransport plays the trace back.
+///
+class ESP8266TraceTransport : public ESP8266Transport
+{
+private:
+	ESP8266Transport* transport;
+	ESP8266Clock* clock;
+	std::FILE* file;
+
+	std::uint32_t lastTime;
+	TraceRecord pendingType;
+	std::uint32_t pendingTime;
+	std::uint8_t pending[ESP8266_TRACE_BUFFER];
+	std::size_t pendingSize;
+
+private:
+    void writeVarint(std::uint32_t value);
+    void writeRecord(const TraceRecord type, const std::uint32_t time, const std::uint8_t* data, const std::size_t size);
+    void append(const TraceRecord type, const std::uint8_t* data, const std::size_t size);
+    void flushPending(void);
+
+public:
+    /// @param transport - the link to record.
+    /// @param clock - the time source of the records.
+    /// @param file - the trace, open for writing, it is not closed by the transport.
+    ///
+    ESP8266TraceTransport(ESP8266Transport &transport, ESP8266Clock &clock, std::FILE* file);
+    ~ESP8266TraceTransport();
+
+    ESP8266TraceTransport(const ESP8266TraceTransport&) = delete;
+    ESP8266TraceTransport& operator=(const ESP8266TraceTransport&) = delete;
+
+    /// @brief
+    /// Write the bytes still collected to the file and flush it.
+    ///
+    void flush(void);
+
+    bool begin(void) override;
+    bool isBaudRateSupported(const std::uint32_t baud) const override;
+    bool setBaudRate(const std::uint32_t baud) override;
+    std::uint32_t getBaudRate(void) const override;
+
+    std::size_t available(void) override;
+    std::size_t read(std::uint8_t* buffer, const std::size_t size) override;
+    void flushRx(void) override;
+    void waitForRx(const std::uint32_t timeout) override;
+
+    void write(const std::uint8_t* data, const std::size_t size) override;
+    void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) override;
+    bool isTxIdle(void) override;
+    void flushTx(void) override;
+
+    std::uint32_t getRxOverrunCount(void) const override;
+    std::size_t getRxHighWater(void) const override;
+    void resetRxStats(void) override;
+
+    void markCommand(const std::uint16_t command) override;
+};
+
+/// @brief
+/// Transport and clock playing a trace back, as fast as possible.
+///
+/// The received bytes of the trace are handed out in the order they were
+/// read, each record only once the driver wrote everything recorded before
+/// it. What the driver writes is compared with the trace, so a replay that
+/// takes another path shows up as mismatches.
+///
+/// The time is the time of the records used so far and moves one
+/// millisecond each time it is read while nothing is left to receive, so
+/// the timeouts of the recording happen again, and runs are identical.
+///
+class ESP8266ReplayTransport : public ESP8266Transport, public ESP8266Clock
+{
+private:
+    struct Record
+    {
+        TraceRecord type;
+        std::uint32_t time;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+	std::vector<std::uint8_t> trace;
+	std::vector<Record> records;
+	bool valid;
+
+	std::size_t rxIndex;
+	std::size_t rxOffset;
+	std::size_t txIndex;
+	std::size_t txOffset;
+	std::uint32_t time;
+	std::uint32_t baud;
+
+	std::uint32_t mismatches;
+	std::uint32_t divergences;
+
+private:
+    bool parse(void);
+    void skipRx(void);
+    void skipTx(void);
+    void use(const Record &record);
+
+public:
+    /// @param file - the trace, open for reading, it is read at once and not closed.
+    explicit ESP8266ReplayTransport(std::FILE* file);
+
+    /// @brief
+    /// Check if the trace could be read.
+    ///
+    bool isValid(void) const;
+
+    /// @brief
+    /// Start again from the first record.
+    ///
+    void rewind(void);
+
+    /// @brief
+    /// Check if every record was used.
+    ///
+    bool isDone(void);
+
+    /// @brief
+    /// Get the number of bytes written that differ from the trace, or
+    /// go past its end.
+    ///
+    std::uint32_t getMismatches(void) const;
+
+    /// @brief
+    /// Get the number of commands started that are not the recorded ones.
+    ///
+    std::uint32_t getDivergences(void) const;
+
+    /// @brief
+    /// Get the number of received bytes in the trace.
+    ///
+    std::size_t getRxSize(void) const;
+
+    bool setBaudRate(const std::uint32_t baud) override;
+    std::uint32_t getBaudRate(void) const override;
+
+    std::size_t available(void) override;
+    std::size_t read(std::uint8_t* buffer, const std::size_t size) override;
+    void flushRx(void) override;
+
+    void write(const std::uint8_t* data, const std::size_t size) override;
+    void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) override;
+    bool isTxIdle(void) override;
+    void flushTx(void) override;
+
+    void markCommand(const std::uint16_t command) override;
+
+    std::uint32_t getTime(void) override;
+};
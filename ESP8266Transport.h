@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+/// @brief
+/// Byte link between the driver and the ESP8266 coprocessor.
+///
+/// ESP8266 only talks to the coprocessor through this interface, so the
+/// protocol code runs unchanged on the Pokitto (ESP8266MbedTransport) and
+/// on a Linux host (ESP8266PosixTransport).
+///
+class ESP8266Transport
+{
+public:
+    virtual ~ESP8266Transport() {}
+
+    /// @brief
+    /// Power up the coprocessor, if the transport controls it.
+    ///
+    /// @retval true - success.
+    /// @retval false - failure.
+    ///
+    virtual bool begin(void) { return true; }
+
+    /// @brief
+    /// Check if the local side can run at a baud rate, before the
+    /// coprocessor is asked to switch.
+    ///
+    virtual bool isBaudRateSupported(const std::uint32_t baud) const { return baud != 0; }
+
+    /// @brief
+    /// Change the local baud rate.
+    ///
+    /// @retval true - success.
+    /// @retval false - the rate was not applied, the previous one stays.
+    ///
+    virtual bool setBaudRate(const std::uint32_t baud) = 0;
+
+    /// @brief
+    /// Get the local baud rate, 0 when the link has none.
+    ///
+    virtual std::uint32_t getBaudRate(void) const = 0;
+
+    /// @brief
+    /// Get the number of received bytes ready to be read.
+    ///
+    virtual std::size_t available(void) = 0;
+
+    /// @brief
+    /// Read up to size received bytes, never blocks.
+    ///
+    /// @return the number of bytes copied.
+    ///
+    virtual std::size_t read(std::uint8_t* buffer, const std::size_t size) = 0;
+
+    /// @brief
+    /// Drop every received byte not read yet.
+    ///
+    virtual void flushRx(void) = 0;
+
+    /// @brief
+    /// Sleep until a byte is received, or at most timeout milliseconds.
+    /// Returns at once by default, for transports that cannot sleep.
+    ///
+    /// @param timeout - the longest sleep in milliseconds.
+    ///
+    virtual void waitForRx(const std::uint32_t timeout) { (void)timeout; }
+
+    /// @brief
+    /// Queue bytes for sending, they are copied.
+    /// Blocks only while the transmit buffer is full.
+    ///
+    virtual void write(const std::uint8_t* data, const std::size_t size) = 0;
+
+    /// @brief
+    /// Queue a payload for sending without copying it.
+    /// Bytes written afterwards are sent after the payload.
+    ///
+    /// @param data - the payload, must stay valid until the callback or isTxIdle().
+    /// @param size - the payload size.
+    /// @param callback - called once the last byte has left, may be empty.
+    ///
+    virtual void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) = 0;
+
+    /// @brief
+    /// Check if everything queued has been sent.
+    ///
+    virtual bool isTxIdle(void) = 0;
+
+    /// @brief
+    /// Wait until everything queued has been sent.
+    ///
+    virtual void flushTx(void) = 0;
+
+    /// @brief
+    /// Get the number of received bytes dropped because a buffer was full.
+    ///
+    virtual std::uint32_t getRxOverrunCount(void) const { return 0; }
+
+    /// @brief
+    /// Get the highest fill level reached by the receive buffer.
+    ///
+    virtual std::size_t getRxHighWater(void) const { return 0; }
+
+    /// @brief
+    /// Reset the overrun count and the high water mark.
+    ///
+    virtual void resetRxStats(void) {}
+
+    /// @brief
+    /// Note that a command starts, for transports recording the traffic.
+    ///
+    /// @param command - the Commands value.
+    ///
+    virtual void markCommand(const std::uint16_t command) { (void)command; }
+};
+
+/// @brief
+/// Millisecond time source used for every timeout of the driver.
+///
+class ESP8266Clock
+{
+public:
+    virtual ~ESP8266Clock() {}
+
+    /// @brief
+    /// Get the time in milliseconds, wraps around.
+    ///
+    virtual std::uint32_t getTime(void) = 0;
+};
@@ -0,0 +1,112 @@
+///
+/// @file ESP8266Upload.cpp
+/// @brief The implementation of class ESP8266Upload.
+///
+
+#include "ESP8266Upload.h"
+#include <algorithm>
+
+ESP8266Upload::ESP8266Upload(ESP8266 &esp)
+{
+    this->esp = &esp;
+    this->id = 0;
+    this->data = nullptr;
+    this->size = 0;
+    this->sent = 0;
+    this->acknowledged = 0;
+    this->credit = ESP8266_STREAM_CHUNK;
+    this->failed = false;
+    this->nextChunk = 0;
+    this->oldestChunk = 0;
+    this->chunksInFlight = 0;
+
+    for(std::size_t i = 0; i < ESP8266_PIPELINE_DEPTH; i++)
+    {
+        this->chunkSizes[i] = 0;
+        this->chunks[i].setCallback([this](ESP8266Request &request)
+        {
+            this->acknowledge(request);
+        });
+    }
+}
+
+void ESP8266Upload::beginTCP(const std::uint8_t id, const std::uint8_t* data, const std::size_t size)
+{
+    for(std::size_t i = 0; i < ESP8266_PIPELINE_DEPTH; i++)
+        this->esp->cancel(this->chunks[i]);
+
+    this->id = id;
+    this->data = data;
+    this->size = size;
+    this->sent = 0;
+    this->acknowledged = 0;
+    // one chunk until the ESP8266 tells how much room it has
+    this->credit = ESP8266_STREAM_CHUNK;
+    this->failed = false;
+    this->nextChunk = 0;
+    this->oldestChunk = 0;
+    this->chunksInFlight = 0;
+
+    this->update();
+}
+
+void ESP8266Upload::acknowledge(ESP8266Request &request)
+{
+    (void)request;
+
+    // in order, framed replies may overtake each other
+    while(this->chunksInFlight != 0 && this->chunks[this->oldestChunk].isReady())
+    {
+        ESP8266Request &chunk = this->chunks[this->oldestChunk];
+        if(chunk.isOk() && !this->failed)
+        {
+            this->acknowledged += this->chunkSizes[this->oldestChunk];
+            this->credit = chunk.getValue16();
+        }
+        else
+            this->failed = true;
+
+        this->oldestChunk = (this->oldestChunk + 1) % ESP8266_PIPELINE_DEPTH;
+        this->chunksInFlight--;
+    }
+}
+
+void ESP8266Upload::update(void)
+{
+    while(!this->failed && this->sent < this->size && this->chunksInFlight < ESP8266_PIPELINE_DEPTH && !this->esp->isBusy())
+    {
+        const std::size_t length = std::min<std::size_t>(this->size - this->sent, ESP8266_STREAM_CHUNK);
+
+        // wait for room, unless nothing is in flight to make room
+        const std::size_t inFlight = this->sent - this->acknowledged;
+        if(inFlight != 0 && inFlight + length > this->credit)
+            return;
+
+        const std::uint8_t index = this->nextChunk;
+        this->chunkSizes[index] = static_cast<std::uint16_t>(length);
+        this->nextChunk = (this->nextChunk + 1) % ESP8266_PIPELINE_DEPTH;
+        this->chunksInFlight++;
+
+        const std::uint8_t* chunk = this->data + this->sent;
+        this->sent += length;
+        this->esp->sendChunkTCPAsync(this->chunks[index], this->id, chunk, static_cast<std::uint16_t>(length));
+    }
+}
+
+bool ESP8266Upload::isDone(void) const
+{
+    if(this->failed)
+        return this->chunksInFlight == 0;
+
+    return this->acknowledged == this->size;
+}
+
+bool ESP8266Upload::isFailed(void) const
+{
+    return this->failed;
+}
+
+std::size_t ESP8266Upload::getProgress(void) const
+{
+    return this->acknowledged;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "ESP8266.h"
+
+/// @brief
+/// A send of any length, split in chunks of ESP8266_STREAM_CHUNK bytes.
+///
+/// Every chunk is acknowledged with the number of bytes the ESP8266 can
+/// take next, its credit. Chunks are sent while they fit the credit, so
+/// several are in flight in the pipelined link modes and the link stays
+/// busy without overflowing the coprocessor receive buffer.
+///
+/// The data is sent without copying and must stay alive until the upload
+/// is done.
+///
+class ESP8266Upload
+{
+private:
+	ESP8266* esp;
+	std::uint8_t id;
+	const std::uint8_t* data;
+	std::size_t size;
+
+	std::size_t sent;
+	std::size_t acknowledged;
+	std::size_t credit;
+	bool failed;
+
+	ESP8266Request chunks[ESP8266_PIPELINE_DEPTH];
+	std::uint16_t chunkSizes[ESP8266_PIPELINE_DEPTH];
+	std::uint8_t nextChunk;
+	std::uint8_t oldestChunk;
+	std::uint8_t chunksInFlight;
+
+private:
+    void acknowledge(ESP8266Request &request);
+
+public:
+    /// @param esp - the driver.
+    explicit ESP8266Upload(ESP8266 &esp);
+
+    ESP8266Upload(const ESP8266Upload&) = delete;
+    ESP8266Upload& operator=(const ESP8266Upload&) = delete;
+
+    /// @brief
+    /// Start sending on one of TCP, a running upload is dropped.
+    ///
+    /// @param id - the identifier of this TCP(available value: 0 - 4).
+    /// @param data - the data to send.
+    /// @param size - the length of data to send.
+    ///
+    void beginTCP(const std::uint8_t id, const std::uint8_t* data, const std::size_t size);
+
+    /// @brief
+    /// Send the chunks that fit the credit, call it after ESP8266::poll().
+    /// Does not wait.
+    ///
+    void update(void);
+
+    /// @brief
+    /// Check if the upload is over, whatever the outcome.
+    ///
+    bool isDone(void) const;
+
+    /// @brief
+    /// Check if a chunk failed, the rest is not sent.
+    ///
+    bool isFailed(void) const;
+
+    /// @brief
+    /// Get the number of bytes the ESP8266 acknowledged.
+    ///
+    std::size_t getProgress(void) const;
+};
@@ -0,0 +1,218 @@
+///
+/// @file HttpCache.cpp
+/// @brief The implementation of class HttpCache.
+///
+
+#include "HttpCache.h"
+#include <cstdio>
+
+HttpCache::HttpCache(ESP8266 &esp, const std::size_t budget, const char* directory)
+{
+    this->esp = &esp;
+    this->budget = budget;
+    this->directory = (directory != nullptr) ? directory : "";
+    this->used = 0;
+    this->hits = 0;
+    this->misses = 0;
+}
+
+std::size_t HttpCache::cost(const Entry &entry)
+{
+    return entry.key.size() + entry.etag.size() + entry.lastModified.size() + entry.body.size();
+}
+
+std::string HttpCache::path(const std::string &key) const
+{
+    // FNV-1a, the key itself is checked on read
+    std::uint32_t hash = 2166136261u;
+    for(const char c : key)
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "%08lx.htc", static_cast<unsigned long>(hash));
+    return this->directory + "/" + name;
+}
+
+HttpCache::Entry* HttpCache::find(const std::string &key)
+{
+    for(auto i = this->entries.begin(); i != this->entries.end(); ++i)
+    {
+        if(i->key != key)
+            continue;
+
+        this->entries.splice(this->entries.begin(), this->entries, i);
+        return &this->entries.front();
+    }
+    return nullptr;
+}
+
+bool HttpCache::readFile(const std::string &key, Entry &entry, const bool withBody) const
+{
+    std::FILE* file = std::fopen(this->path(key).c_str(), "rb");
+    if(file == nullptr)
+        return false;
+
+    // the key, ETag and Last-Modified lines, then the body
+    std::string* lines[3] = { &entry.key, &entry.etag, &entry.lastModified };
+    bool valid = true;
+    for(std::string* line : lines)
+    {
+        line->clear();
+        int c;
+        while((c = std::fgetc(file)) != EOF && c != '\n')
+            line->push_back(static_cast<char>(c));
+        valid = valid && (c == '\n');
+    }
+    valid = valid && (entry.key == key);
+
+    entry.body.clear();
+    if(valid && withBody)
+    {
+        char buffer[256];
+        std::size_t count;
+        while((count = std::fread(buffer, 1, sizeof(buffer), file)) != 0)
+            entry.body.append(buffer, count);
+    }
+
+    std::fclose(file);
+    return valid;
+}
+
+void HttpCache::store(Entry &entry)
+{
+    if(!this->directory.empty())
+    {
+        std::FILE* file = std::fopen(this->path(entry.key).c_str(), "wb");
+        if(file == nullptr)
+            return;
+
+        const std::string head = entry.key + "\n" + entry.etag + "\n" + entry.lastModified + "\n";
+        const bool written = std::fwrite(head.data(), 1, head.size(), file) == head.size() &&
+                             std::fwrite(entry.body.data(), 1, entry.body.size(), file) == entry.body.size();
+        std::fclose(file);
+        if(!written)
+            std::remove(this->path(entry.key).c_str());
+        return;
+    }
+
+    this->remove(entry.key);
+    if(cost(entry) > this->budget)
+        return;
+
+    this->used += cost(entry);
+    this->entries.push_front(std::move(entry));
+    while(this->used > this->budget)
+    {
+        this->used -= cost(this->entries.back());
+        this->entries.pop_back();
+    }
+}
+
+void HttpCache::remove(const std::string &key)
+{
+    if(!this->directory.empty())
+    {
+        std::remove(this->path(key).c_str());
+        return;
+    }
+
+    Entry* entry = this->find(key);
+    if(entry == nullptr)
+        return;
+
+    this->used -= cost(*entry);
+    this->entries.pop_front();
+}
+
+std::int32_t HttpCache::get(const std::string &host, const std::uint16_t port, const std::string &uri, std::string &body, const bool is_https)
+{
+    const std::string key = (is_https ? "https://" : "http://") + host + ":" + std::to_string(port) + uri;
+
+    Entry loaded;
+    Entry* cached = nullptr;
+    if(this->directory.empty())
+        cached = this->find(key);
+    else if(this->readFile(key, loaded, false))
+        cached = &loaded;
+
+    HttpRequest request;
+    request.host = host;
+    request.port = port;
+    request.uri = uri;
+    request.https = is_https;
+    request.responseHeaders = { "ETag", "Last-Modified" };
+    if(cached != nullptr && !cached->etag.empty())
+        request.headers.push_back(std::make_pair("If-None-Match", cached->etag));
+    if(cached != nullptr && !cached->lastModified.empty())
+        request.headers.push_back(std::make_pair("If-Modified-Since", cached->lastModified));
+
+    HttpResponse response;
+    const std::int32_t code = this->esp->requestHTTP(request, response);
+
+    std::string etag, lastModified;
+    response.getHeader("ETag", etag);
+    response.getHeader("Last-Modified", lastModified);
+
+    if(code == 304 && cached != nullptr)
+    {
+        if(!this->directory.empty() && !this->readFile(key, loaded, true))
+        {
+            body.clear();
+            return -1;
+        }
+
+        this->hits++;
+        body = cached->body;
+
+        // the server may hand out new validators with the 304
+        if((!etag.empty() && etag != cached->etag) || (!lastModified.empty() && lastModified != cached->lastModified))
+        {
+            Entry entry = *cached;
+            entry.etag = etag.empty() ? entry.etag : etag;
+            entry.lastModified = lastModified.empty() ? entry.lastModified : lastModified;
+            this->store(entry);
+        }
+        return 200;
+    }
+
+    body.clear();
+    if(code != 200)
+        return code;
+
+    this->misses++;
+    const bool complete = this->esp->downloadHTTP([&body](const std::uint8_t* data, std::uint16_t size)
+    {
+        body.append(reinterpret_cast<const char*>(data), size);
+        return true;
+    });
+
+    if(!complete || (etag.empty() && lastModified.empty()))
+    {
+        this->remove(key);
+        return complete ? code : -1;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.etag = etag;
+    entry.lastModified = lastModified;
+    entry.body = body;
+    this->store(entry);
+    return code;
+}
+
+void HttpCache::clear(void)
+{
+    this->entries.clear();
+    this->used = 0;
+}
+
+std::uint32_t HttpCache::getHits(void) const
+{
+    return this->hits;
+}
+
+std::uint32_t HttpCache::getMisses(void) const
+{
+    return this->misses;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <string>
+#include "ESP8266.h"
+
+/// @brief
+/// Cache of HTTP GET responses, revalidated with conditional requests.
+///
+/// Responses that carry an ETag or a Last-Modified header are kept, keyed
+/// by scheme, host, port and URI. The next get() of the same resource
+/// sends If-None-Match and If-Modified-Since, and a 304 reply is served
+/// from the cache without moving the body over the UART again.
+///
+/// Entries live in RAM within a byte budget, least recently used first
+/// out, or in files under a directory, on the SD card for example, where
+/// they also survive a restart.
+///
+class HttpCache
+{
+private:
+    struct Entry
+    {
+        std::string key;
+        std::string etag;
+        std::string lastModified;
+        std::string body;
+    };
+
+	ESP8266* esp;
+	std::size_t budget;
+	std::string directory;
+
+	// most recently used first
+	std::list<Entry> entries;
+	std::size_t used;
+
+	std::uint32_t hits;
+	std::uint32_t misses;
+
+private:
+    static std::size_t cost(const Entry &entry);
+    std::string path(const std::string &key) const;
+    Entry* find(const std::string &key);
+    bool readFile(const std::string &key, Entry &entry, const bool withBody) const;
+    void store(Entry &entry);
+    void remove(const std::string &key);
+
+public:
+    /// @param esp - the driver.
+    /// @param budget - the most bytes kept in RAM, ignored with a directory.
+    /// @param directory - where to keep entries as files, nullptr for RAM.
+    ///
+    HttpCache(ESP8266 &esp, const std::size_t budget, const char* directory = nullptr);
+
+    HttpCache(const HttpCache&) = delete;
+    HttpCache& operator=(const HttpCache&) = delete;
+
+    /// @brief
+    /// Fetch a resource, from the cache when the server confirms it did
+    /// not change.
+    ///
+    /// @param host - the IP or domain name of the target host.
+    /// @param port - the port number of the target host.
+    /// @param uri - the uri.
+    /// @param body - receives the body.
+    /// @param is_https - https or http.
+    ///
+    /// @return error code on failure or http code on success, 200 for a
+    ///     body served from the cache.
+    ///
+    std::int32_t get(const std::string &host, const std::uint16_t port, const std::string &uri, std::string &body, const bool is_https = false);
+
+    /// @brief
+    /// Drop the entries kept in RAM. Files are left in place.
+    ///
+    void clear(void);
+
+    /// @brief
+    /// Get the number of get() calls served from the cache.
+    ///
+    std::uint32_t getHits(void) const;
+
+    /// @brief
+    /// Get the number of get() calls that transferred a body.
+    ///
+    std::uint32_t getMisses(void) const;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/// @brief
+/// Fixed capacity string kept in place, without any heap use.
+///
+/// Receives the string replies of ESP8266 through the char* overloads.
+/// Longer replies are cut to the capacity, which does not count the
+/// terminating NUL.
+///
+template<std::size_t Capacity>
+class InlineString
+{
+    static_assert(Capacity != 0, "InlineString capacity must not be zero");
+
+private:
+    char text[Capacity + 1];
+
+public:
+    InlineString()
+    {
+        this->text[0] = '\0';
+    }
+
+    InlineString(const char* string)
+    {
+        this->assign(string);
+    }
+
+    /// @brief
+    /// Replace the content, cut to the capacity.
+    ///
+    void assign(const char* string)
+    {
+        std::size_t length = 0;
+        while(length < Capacity && string[length] != '\0')
+        {
+            this->text[length] = string[length];
+            length++;
+        }
+        this->text[length] = '\0';
+    }
+
+    void clear(void)
+    {
+        this->text[0] = '\0';
+    }
+
+    const char* c_str(void) const
+    {
+        return this->text;
+    }
+
+    /// @brief
+    /// Get the storage, Capacity + 1 bytes with the terminating NUL.
+    ///
+    char* data(void)
+    {
+        return this->text;
+    }
+
+    std::size_t size(void) const
+    {
+        return std::strlen(this->text);
+    }
+
+    std::size_t length(void) const
+    {
+        return this->size();
+    }
+
+    bool empty(void) const
+    {
+        return this->text[0] == '\0';
+    }
+
+    static constexpr std::size_t capacity(void)
+    {
+        return Capacity;
+    }
+
+    char operator[](const std::size_t index) const
+    {
+        return this->text[index];
+    }
+
+    bool operator==(const char* string) const
+    {
+        return std::strcmp(this->text, string) == 0;
+    }
+
+    bool operator!=(const char* string) const
+    {
+        return !(*this == string);
+    }
+};
+
+/// @brief
+/// A caller's char buffer receiving a string reply: a plain array, an
+/// InlineString, or a pointer and a size.
+///
+struct CharSpan
+{
+    char* data;
+    /// Size of the buffer, with the terminating NUL.
+    std::size_t size;
+
+    CharSpan(char* data, const std::size_t size)
+    : data(data), size(size)
+    {
+    }
+
+    template<std::size_t Size>
+    CharSpan(char (&array)[Size])
+    : data(array), size(Size)
+    {
+    }
+
+    template<std::size_t Capacity>
+    CharSpan(InlineString<Capacity> &string)
+    : data(string.data()), size(Capacity + 1)
+    {
+    }
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// @brief
+/// LZSS codec of the compressed link payloads.
+///
+/// A flag byte announces the next eight items, least significant bit
+/// first: 1 for a literal byte, 0 for a match of two bytes holding a 12 bit
+/// distance back into the output (1 - 4096) and a 4 bit length (3 - 18).
+/// The decoder needs no window of its own: matches are copied from the
+/// output already produced.
+///
+class Lzss
+{
+public:
+    static const std::size_t windowSize = 4096;
+    static const std::size_t minMatch = 3;
+    static const std::size_t maxMatch = 18;
+
+    /// @brief
+    /// Decoder fed a byte at a time, for payloads decoded as they arrive.
+    ///
+    class Decoder
+    {
+    public:
+        enum class Token: std::uint8_t
+        {
+            None,
+            Literal,
+            Match,
+        };
+
+    private:
+		std::uint8_t flags;
+		std::uint8_t items;
+		std::uint8_t low;
+		bool haveLow;
+
+    public:
+        Decoder()
+        {
+            this->reset();
+        }
+
+        void reset(void)
+        {
+            this->flags = 0;
+            this->items = 0;
+            this->low = 0;
+            this->haveLow = false;
+        }
+
+        /// @brief
+        /// Take the next payload byte.
+        ///
+        /// @param value - the byte.
+        /// @param literal - receives the byte of a literal.
+        /// @param distance - receives how far back a match starts.
+        /// @param length - receives the length of a match.
+        ///
+        /// @return what the byte completed, if anything.
+        ///
+        Token feed(const std::uint8_t value, std::uint8_t &literal, std::uint16_t &distance, std::uint8_t &length)
+        {
+            if(this->items == 0)
+            {
+                this->flags = value;
+                this->items = 8;
+                return Token::None;
+            }
+
+            if(this->flags & 1)
+            {
+                this->flags >>= 1;
+                this->items--;
+                literal = value;
+                return Token::Literal;
+            }
+
+            if(!this->haveLow)
+            {
+                this->low = value;
+                this->haveLow = true;
+                return Token::None;
+            }
+
+            this->flags >>= 1;
+            this->items--;
+            this->haveLow = false;
+            distance = static_cast<std::uint16_t>((this->low | ((value >> 4) << 8)) + 1);
+            length = static_cast<std::uint8_t>((value & 0x0F) + minMatch);
+            return Token::Match;
+        }
+    };
+
+    /// @brief
+    /// Compress a buffer.
+    ///
+    /// @param data - the bytes.
+    /// @param size - the number of bytes.
+    /// @param packed - receives the compressed bytes.
+    ///
+    /// @retval true - packed is smaller than data.
+    /// @retval false - the data does not compress, send it as it is.
+    ///
+    static bool encode(const std::uint8_t* data, const std::size_t size, std::vector<std::uint8_t> &packed)
+    {
+        // one candidate per hash of the next three bytes
+        static const std::size_t hashBits = 10;
+        std::vector<std::uint16_t> table(1 << hashBits, 0xFFFF);
+
+        packed.clear();
+        packed.reserve(size);
+
+        std::size_t flagsAt = 0;
+        std::uint8_t item = 8;
+        std::size_t position = 0;
+        while(position < size)
+        {
+            if(item == 8)
+            {
+                flagsAt = packed.size();
+                packed.push_back(0);
+                item = 0;
+            }
+
+            std::size_t length = 0;
+            std::size_t distance = 0;
+            if(position + minMatch <= size)
+            {
+                const std::uint32_t hash = ((data[position] << 16) | (data[position + 1] << 8) | data[position + 2]) * 2654435761u >> (32 - hashBits);
+                const std::uint16_t candidate = table[hash];
+                table[hash] = static_cast<std::uint16_t>(position);
+
+                if(candidate != 0xFFFF && candidate < position && position - candidate <= windowSize)
+                {
+                    const std::size_t limit = (size - position < maxMatch) ? size - position : maxMatch;
+                    while(length < limit && data[candidate + length] == data[position + length])
+                        length++;
+                    distance = position - candidate;
+                }
+            }
+
+            if(length >= minMatch)
+            {
+                packed.push_back(static_cast<std::uint8_t>((distance - 1) & 0xFF));
+                packed.push_back(static_cast<std::uint8_t>((((distance - 1) >> 8) << 4) | (length - minMatch)));
+                position += length;
+            }
+            else
+            {
+                packed[flagsAt] |= static_cast<std::uint8_t>(1 << item);
+                packed.push_back(data[position]);
+                position++;
+            }
+            item++;
+
+            if(packed.size() >= size)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// @brief
+    /// Decompress a whole payload.
+    ///
+    /// @param packed - the compressed bytes.
+    /// @param size - the number of compressed bytes.
+    /// @param data - receives the bytes.
+    ///
+    /// @retval true - success.
+    /// @retval false - a match points before the start of the data.
+    ///
+    static bool decode(const std::uint8_t* packed, const std::size_t size, std::vector<std::uint8_t> &data)
+    {
+        Decoder decoder;
+        data.clear();
+        for(std::size_t i = 0; i < size; i++)
+        {
+            std::uint8_t literal, length;
+            std::uint16_t distance;
+            switch(decoder.feed(packed[i], literal, distance, length))
+            {
+                case Decoder::Token::Literal:
+                    data.push_back(literal);
+                    break;
+
+                case Decoder::Token::Match:
+                    if(distance > data.size())
+                        return false;
+                    for(std::uint8_t j = 0; j < length; j++)
+                        data.push_back(data[data.size() - distance]);
+                    break;
+
+                case Decoder::Token::None:
+                    break;
+            }
+        }
+        return true;
+    }
+};
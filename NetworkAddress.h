@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "InlineString.h"
+
+/// @brief
+/// IPv4 address as its four octets, in the dotted order.
+///
+/// Goes over the link as the four octets, where the text takes up to 16
+/// bytes. parse() is constexpr, so a constant address costs nothing:
+///   constexpr IPv4Address gateway = IPv4Address::parse("192.168.4.1");
+///
+class IPv4Address
+{
+public:
+    /// Longest dotted text, without the terminating NUL.
+    static constexpr std::size_t textLength = 15;
+
+    std::uint8_t octets[4];
+
+public:
+    constexpr IPv4Address()
+    : octets{ 0, 0, 0, 0 }
+    {
+    }
+
+    constexpr IPv4Address(const std::uint8_t a, const std::uint8_t b, const std::uint8_t c, const std::uint8_t d)
+    : octets{ a, b, c, d }
+    {
+    }
+
+    /// @brief
+    /// Check if the text is a dotted address, such as "192.168.4.1".
+    ///
+    static constexpr bool isValid(const char* text)
+    {
+        return (scan(text, 0, 0, 0, 0) & valid) != 0;
+    }
+
+    /// @brief
+    /// Read a dotted address, 0.0.0.0 when the text is not one, see isValid().
+    ///
+    static constexpr IPv4Address parse(const char* text)
+    {
+        return fromScan(scan(text, 0, 0, 0, 0));
+    }
+
+    constexpr bool operator==(const IPv4Address &other) const
+    {
+        return this->octets[0] == other.octets[0] && this->octets[1] == other.octets[1]
+            && this->octets[2] == other.octets[2] && this->octets[3] == other.octets[3];
+    }
+
+    constexpr bool operator!=(const IPv4Address &other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief
+    /// Write the dotted text into the caller's buffer, cut to fit.
+    ///
+    /// @return the length of the text written.
+    ///
+    std::size_t format(const CharSpan text) const
+    {
+        if(text.size == 0)
+            return 0;
+
+        char dotted[textLength + 1];
+        std::size_t length = 0;
+        for(std::size_t i = 0; i < sizeof(this->octets); i++)
+        {
+            if(i != 0)
+                dotted[length++] = '.';
+
+            const std::uint8_t octet = this->octets[i];
+            if(octet >= 100)
+                dotted[length++] = static_cast<char>('0' + octet / 100);
+            if(octet >= 10)
+                dotted[length++] = static_cast<char>('0' + (octet / 10) % 10);
+            dotted[length++] = static_cast<char>('0' + octet % 10);
+        }
+
+        if(length > text.size - 1)
+            length = text.size - 1;
+        for(std::size_t i = 0; i < length; i++)
+            text.data[i] = dotted[i];
+        text.data[length] = '\0';
+        return length;
+    }
+
+    std::string toString(void) const
+    {
+        char text[textLength + 1];
+        return std::string(text, this->format(text));
+    }
+
+private:
+    static constexpr std::uint64_t valid = std::uint64_t(1) << 32;
+
+    // one character at a time, C++11 constexpr functions are a single return
+    static constexpr std::uint64_t scan(const char* text, const std::uint64_t address, const std::uint32_t octet, const std::uint8_t digits, const std::uint8_t dots)
+    {
+        return (*text == '\0')
+            ? ((digits != 0 && dots == 3) ? (valid | (address << 8) | octet) : 0)
+            : (*text == '.')
+            ? ((digits != 0 && dots < 3) ? scan(text + 1, (address << 8) | octet, 0, 0, dots + 1) : 0)
+            : (*text >= '0' && *text <= '9' && digits < 3 && octet * 10 + (*text - '0') <= 255)
+            ? scan(text + 1, address, octet * 10 + (*text - '0'), digits + 1, dots)
+            : 0;
+    }
+
+    static constexpr IPv4Address fromScan(const std::uint64_t value)
+    {
+        return IPv4Address(static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value));
+    }
+};
+
+/// @brief
+/// MAC address as its six bytes, in the written order.
+///
+/// Goes over the link as the six bytes, where the text takes 18. The text
+/// is six pairs of hexadecimal digits split by colons, "5C:CF:7F:01:02:03",
+/// either case when parsed and upper case when formatted, as the ESP8266
+/// writes it.
+///
+class MacAddress
+{
+public:
+    /// Length of the text, without the terminating NUL.
+    static constexpr std::size_t textLength = 17;
+
+    std::uint8_t bytes[6];
+
+public:
+    constexpr MacAddress()
+    : bytes{ 0, 0, 0, 0, 0, 0 }
+    {
+    }
+
+    constexpr MacAddress(const std::uint8_t a, const std::uint8_t b, const std::uint8_t c, const std::uint8_t d, const std::uint8_t e, const std::uint8_t f)
+    : bytes{ a, b, c, d, e, f }
+    {
+    }
+
+    /// @brief
+    /// Check if the text is a MAC address, such as "5C:CF:7F:01:02:03".
+    ///
+    static constexpr bool isValid(const char* text)
+    {
+        return (scan(text, 0, 0) & valid) != 0;
+    }
+
+    /// @brief
+    /// Read a MAC address, 00:00:00:00:00:00 when the text is not one, see isValid().
+    ///
+    static constexpr MacAddress parse(const char* text)
+    {
+        return fromScan(scan(text, 0, 0));
+    }
+
+    constexpr bool operator==(const MacAddress &other) const
+    {
+        return this->bytes[0] == other.bytes[0] && this->bytes[1] == other.bytes[1] && this->bytes[2] == other.bytes[2]
+            && this->bytes[3] == other.bytes[3] && this->bytes[4] == other.bytes[4] && this->bytes[5] == other.bytes[5];
+    }
+
+    constexpr bool operator!=(const MacAddress &other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief
+    /// Write the text into the caller's buffer, cut to fit.
+    ///
+    /// @return the length of the text written.
+    ///
+    std::size_t format(const CharSpan text) const
+    {
+        if(text.size == 0)
+            return 0;
+
+        static const char digits[] = "0123456789ABCDEF";
+        std::size_t length = 0;
+        for(std::size_t i = 0; i < textLength && length < text.size - 1; i++)
+        {
+            const std::uint8_t byte = this->bytes[i / 3];
+            text.data[length++] = (i % 3 == 2) ? ':' : digits[(i % 3 == 0) ? (byte >> 4) : (byte & 0x0F)];
+        }
+        text.data[length] = '\0';
+        return length;
+    }
+
+    std::string toString(void) const
+    {
+        char text[textLength + 1];
+        return std::string(text, this->format(text));
+    }
+
+private:
+    static constexpr std::uint64_t valid = std::uint64_t(1) << 48;
+
+    static constexpr int hexDigit(const char c)
+    {
+        return (c >= '0' && c <= '9') ? (c - '0')
+            : (c >= 'a' && c <= 'f') ? (c - 'a' + 10)
+            : (c >= 'A' && c <= 'F') ? (c - 'A' + 10)
+            : -1;
+    }
+
+    // the position in the text tells a digit from a colon
+    static constexpr std::uint64_t scan(const char* text, const std::uint64_t value, const std::size_t position)
+    {
+        return (position == textLength)
+            ? ((*text == '\0') ? (valid | value) : 0)
+            : (position % 3 == 2)
+            ? ((*text == ':') ? scan(text + 1, value, position + 1) : 0)
+            : (hexDigit(*text) >= 0)
+            ? scan(text + 1, (value << 4) | static_cast<std::uint64_t>(hexDigit(*text)), position + 1)
+            : 0;
+    }
+
+    static constexpr MacAddress fromScan(const std::uint64_t value)
+    {
+        return MacAddress(static_cast<std::uint8_t>(value >> 40), static_cast<std::uint8_t>(value >> 32),
+            static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value));
+    }
+};
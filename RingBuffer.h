@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/// @brief
+/// Lock-free single producer / single consumer ring buffer.
+///
+/// One side (usually an interrupt handler) only pushes, the other side
+/// (the main loop) only pops, so no locking is needed on a single core.
+/// The capacity must be a power of two.
+///
+template<typename T, std::size_t Capacity>
+class RingBuffer
+{
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+private:
+    static const std::size_t mask = Capacity - 1;
+
+    T buffer[Capacity];
+    volatile std::size_t head = 0;
+    volatile std::size_t tail = 0;
+
+public:
+    /// @brief
+    /// Append a value, producer side.
+    ///
+    /// @retval true - success.
+    /// @retval false - the buffer is full, the value is dropped.
+    ///
+    bool push(const T value)
+    {
+        const std::size_t current = this->head;
+        if((current - this->tail) >= Capacity)
+            return false;
+
+        this->buffer[current & mask] = value;
+        this->head = current + 1;
+        return true;
+    }
+
+    /// @brief
+    /// Remove the oldest value, consumer side.
+    ///
+    /// @retval true - success.
+    /// @retval false - the buffer is empty.
+    ///
+    bool pop(T &value)
+    {
+        const std::size_t current = this->tail;
+        if(current == this->head)
+            return false;
+
+        value = this->buffer[current & mask];
+        this->tail = current + 1;
+        return true;
+    }
+
+    /// @brief
+    /// Remove up to count values at once, consumer side.
+    ///
+    /// @return the number of values copied.
+    ///
+    std::size_t read(T* values, const std::size_t count)
+    {
+        const std::size_t current = this->tail;
+        std::size_t available = this->head - current;
+        if(available > count)
+            available = count;
+
+        for(std::size_t i = 0; i < available; ++i)
+            values[i] = this->buffer[(current + i) & mask];
+
+        this->tail = current + available;
+        return available;
+    }
+
+    /// @brief
+    /// Drop everything currently buffered, consumer side.
+    ///
+    void clear(void)
+    {
+        this->tail = this->head;
+    }
+
+    std::size_t size(void) const
+    {
+        return this->head - this->tail;
+    }
+
+    bool empty(void) const
+    {
+        return this->head == this->tail;
+    }
+
+    static constexpr std::size_t capacity(void)
+    {
+        return Capacity;
+    }
+};
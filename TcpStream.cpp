@@ -0,0 +1,165 @@
+///
+/// @file TcpStream.cpp
+/// @brief The implementation of class TcpStream.
+///
+
+#include "TcpStream.h"
+#include <algorithm>
+#include <cstring>
+
+TcpStream::TcpStream(ESP8266 &esp, const std::uint8_t id, const std::size_t writeBufferSize, const std::size_t readBufferSize, const std::uint32_t flushDelay)
+{
+    this->esp = &esp;
+    this->id = id;
+    this->flushDelay = flushDelay;
+
+    this->writeBufferSize = std::max<std::size_t>(1, std::min<std::size_t>(writeBufferSize, 0xFFFF));
+    this->writeBuffers[0] = new std::uint8_t[this->writeBufferSize];
+    this->writeBuffers[1] = new std::uint8_t[this->writeBufferSize];
+    this->writeIndex = 0;
+    this->writeCount = 0;
+    this->writeStart = 0;
+    this->failed = false;
+
+    this->readBufferSize = std::max<std::size_t>(1, std::min<std::size_t>(readBufferSize, 0xFFFF));
+    this->readBuffer = new std::uint8_t[this->readBufferSize];
+    this->readPosition = 0;
+    this->readEnd = 0;
+
+    this->writeRequest.setCallback([this](ESP8266Request &request)
+    {
+        if(!request.isOk())
+            this->failed = true;
+    });
+
+    this->readRequest.setCallback([this](ESP8266Request &request)
+    {
+        this->readPosition = 0;
+        this->readEnd = request.isOk() ? request.getSize() : 0;
+    });
+}
+
+TcpStream::~TcpStream()
+{
+    // the buffers must outlive the requests using them
+    this->esp->cancel(this->writeRequest);
+    this->esp->cancel(this->readRequest);
+
+    delete[] this->writeBuffers[0];
+    delete[] this->writeBuffers[1];
+    delete[] this->readBuffer;
+}
+
+bool TcpStream::send(const bool block)
+{
+    if(this->writeCount == 0)
+        return true;
+
+    // the other buffer is still on its way
+    if(this->writeRequest.getStatus() == RequestStatus::Pending)
+    {
+        if(!block)
+            return false;
+        this->esp->wait(this->writeRequest);
+    }
+
+    if(!block && this->esp->isBusy())
+        return false;
+
+    this->esp->sendTCPAsync(this->writeRequest, this->id, this->writeBuffers[this->writeIndex], static_cast<std::uint16_t>(this->writeCount));
+    this->writeIndex ^= 1;
+    this->writeCount = 0;
+    return true;
+}
+
+void TcpStream::prefetch(void)
+{
+    if(this->readPosition != this->readEnd)
+        return;
+    if(this->readRequest.getStatus() == RequestStatus::Pending || this->esp->isBusy())
+        return;
+
+    this->esp->readSomeTCPAsync(this->readRequest, this->id, this->readBuffer, static_cast<std::uint16_t>(this->readBufferSize));
+}
+
+void TcpStream::update(void)
+{
+    if(this->writeCount != 0 && (this->esp->getTime() - this->writeStart) >= this->flushDelay)
+        this->send(false);
+
+    this->prefetch();
+}
+
+std::size_t TcpStream::write(const std::uint8_t* data, const std::size_t size)
+{
+    std::size_t written = 0;
+    while(written < size && !this->failed)
+    {
+        if(this->writeCount == this->writeBufferSize)
+            this->send(true);
+
+        if(this->writeCount == 0)
+            this->writeStart = this->esp->getTime();
+
+        const std::size_t count = std::min(size - written, this->writeBufferSize - this->writeCount);
+        std::memcpy(this->writeBuffers[this->writeIndex] + this->writeCount, data + written, count);
+        this->writeCount += count;
+        written += count;
+    }
+
+    // a full buffer goes at once
+    if(this->writeCount == this->writeBufferSize)
+        this->send(false);
+
+    return written;
+}
+
+std::size_t TcpStream::write(const std::uint8_t value)
+{
+    return this->write(&value, 1);
+}
+
+bool TcpStream::flush(void)
+{
+    this->send(true);
+    this->esp->wait(this->writeRequest);
+    return !this->failed;
+}
+
+std::size_t TcpStream::available(void) const
+{
+    return this->readEnd - this->readPosition;
+}
+
+int TcpStream::read(void)
+{
+    std::uint8_t value;
+    if(this->read(&value, 1) == 0)
+        return -1;
+
+    return value;
+}
+
+int TcpStream::peek(void) const
+{
+    if(this->readPosition == this->readEnd)
+        return -1;
+
+    return this->readBuffer[this->readPosition];
+}
+
+std::size_t TcpStream::read(std::uint8_t* buffer, const std::size_t size)
+{
+    const std::size_t count = std::min(size, this->readEnd - this->readPosition);
+    std::memcpy(buffer, this->readBuffer + this->readPosition, count);
+    this->readPosition += count;
+
+    // start the next read as soon as the buffer runs dry
+    this->prefetch();
+    return count;
+}
+
+bool TcpStream::isFailed(void) const
+{
+    return this->failed;
+}
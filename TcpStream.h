@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "ESP8266.h"
+
+/// @brief
+/// Buffered byte stream over one TCP link of an ESP8266.
+///
+/// Small writes are collected and sent with a single sendTCP once the
+/// buffer is full or the oldest byte has waited flushDelay milliseconds.
+/// Reads are served from a local buffer that is refilled with readTCP in
+/// the background, so parsing a byte at a time costs no round trip.
+///
+/// Nothing happens unless update() is called regularly, once per frame
+/// from the game loop, after ESP8266::poll().
+///
+class TcpStream
+{
+private:
+	ESP8266* esp;
+	std::uint8_t id;
+	std::uint32_t flushDelay;
+
+	// two write buffers, one is filled while the other is sent
+	std::uint8_t* writeBuffers[2];
+	std::size_t writeBufferSize;
+	std::uint8_t writeIndex;
+	std::size_t writeCount;
+	std::uint32_t writeStart;
+	ESP8266Request writeRequest;
+	bool failed;
+
+	std::uint8_t* readBuffer;
+	std::size_t readBufferSize;
+	std::size_t readPosition;
+	std::size_t readEnd;
+	ESP8266Request readRequest;
+
+private:
+    bool send(const bool block);
+    void prefetch(void);
+
+public:
+    /// @brief
+    /// Wrap a TCP link that is already created.
+    ///
+    /// @param esp - the driver.
+    /// @param id - the identifier of the TCP link (available value: 0 - 4).
+    /// @param writeBufferSize - the largest write sent at once, 1 to 65535.
+    /// @param readBufferSize - the largest read requested at once, 1 to 65535.
+    /// @param flushDelay - milliseconds a written byte may wait for more.
+    ///
+    TcpStream(ESP8266 &esp, const std::uint8_t id, const std::size_t writeBufferSize = 256, const std::size_t readBufferSize = 256, const std::uint32_t flushDelay = 20);
+    ~TcpStream();
+
+    TcpStream(const TcpStream&) = delete;
+    TcpStream& operator=(const TcpStream&) = delete;
+
+    /// @brief
+    /// Send the writes whose delay is over and keep the read buffer filled.
+    ///
+    void update(void);
+
+    /// @brief
+    /// Queue bytes for sending, waits only when both write buffers are full.
+    ///
+    /// @param data - the bytes.
+    /// @param size - the number of bytes.
+    ///
+    /// @return the number of bytes queued, less than size after a failure.
+    ///
+    std::size_t write(const std::uint8_t* data, const std::size_t size);
+
+    /// @brief
+    /// Queue one byte for sending.
+    ///
+    std::size_t write(const std::uint8_t value);
+
+    /// @brief
+    /// Send everything queued and wait until the ESP8266 took it.
+    ///
+    /// @retval true - success.
+    /// @retval false - a send failed.
+    ///
+    bool flush(void);
+
+    /// @brief
+    /// Get the number of bytes that can be read without waiting.
+    ///
+    std::size_t available(void) const;
+
+    /// @brief
+    /// Read one byte.
+    ///
+    /// @return the byte, -1 when nothing is buffered yet.
+    ///
+    int read(void);
+
+    /// @brief
+    /// Get the next byte without consuming it.
+    ///
+    /// @return the byte, -1 when nothing is buffered yet.
+    ///
+    int peek(void) const;
+
+    /// @brief
+    /// Read the buffered bytes, does not wait for more.
+    ///
+    /// @param buffer - receives the bytes.
+    /// @param size - the size of buffer.
+    ///
+    /// @return the number of bytes read.
+    ///
+    std::size_t read(std::uint8_t* buffer, const std::size_t size);
+
+    /// @brief
+    /// Check if a send failed since the stream was created.
+    ///
+    bool isFailed(void) const;
+};
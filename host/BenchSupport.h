@@ -0,0 +1,353 @@
+#pragma once
+
+#ifdef ESP8266_POSIX
+
+#include "../ESP8266.h"
+#include "../ESP8266PosixTransport.h"
+#include "ESP8266Emulator.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief
+/// Loopback servers the emulator bridges to: a TCP echo, a UDP echo and a
+/// keep-alive HTTP server answering every request with the same body.
+/// With an ETag the HTTP server sends it, and answers 304 to a request
+/// carrying it in If-None-Match.
+///
+class LoopbackServers
+{
+private:
+	int tcpListener;
+	int udpSocket;
+	int httpListener;
+	std::uint16_t tcpPort;
+	std::uint16_t udpPort;
+	std::uint16_t httpPort;
+	std::string body;
+	std::string etag;
+	std::atomic<bool> running;
+	std::vector<std::thread> threads;
+
+private:
+    static int open(const int type, std::uint16_t &port)
+    {
+        const int socket = ::socket(AF_INET, type, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if(socket < 0 || ::bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+           (type == SOCK_STREAM && ::listen(socket, 8) != 0) ||
+           ::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        {
+            if(socket >= 0)
+                ::close(socket);
+            return -1;
+        }
+        port = ntohs(address.sin_port);
+        return socket;
+    }
+
+    static bool ready(const int socket)
+    {
+        pollfd descriptor = { socket, POLLIN, 0 };
+        return ::poll(&descriptor, 1, 100) == 1;
+    }
+
+    void accept(const int listener, const std::function<void(int)> &serve)
+    {
+        this->threads.emplace_back([this, listener, serve]()
+        {
+            std::vector<std::thread> connections;
+            while(this->running)
+            {
+                if(!ready(listener))
+                    continue;
+                const int socket = ::accept(listener, nullptr, nullptr);
+                if(socket >= 0)
+                    connections.emplace_back(serve, socket);
+            }
+            for(auto &connection : connections)
+                connection.join();
+        });
+    }
+
+    void echo(const int socket)
+    {
+        while(this->running)
+        {
+            if(!ready(socket))
+                continue;
+
+            char buffer[4096];
+            const ssize_t count = ::recv(socket, buffer, sizeof(buffer), 0);
+            if(count <= 0 || ::send(socket, buffer, static_cast<std::size_t>(count), MSG_NOSIGNAL) != count)
+                break;
+        }
+        ::close(socket);
+    }
+
+    void http(const int socket)
+    {
+        std::string request;
+        while(this->running)
+        {
+            const std::size_t end = request.find("\r\n\r\n");
+            if(end == std::string::npos)
+            {
+                if(!ready(socket))
+                    continue;
+
+                char buffer[1024];
+                const ssize_t count = ::recv(socket, buffer, sizeof(buffer), 0);
+                if(count <= 0)
+                    break;
+                request.append(buffer, static_cast<std::size_t>(count));
+                continue;
+            }
+
+            const bool close = request.find("Connection: close") < end;
+            const bool unchanged = !this->etag.empty() && request.find("If-None-Match: " + this->etag + "\r\n") < end;
+            request.erase(0, end + 4);
+
+            std::string response = unchanged ? "HTTP/1.1 304 Not Modified\r\n" : "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n";
+            if(!this->etag.empty())
+                response += "ETag: " + this->etag + "\r\n";
+            if(!unchanged)
+                response += "Content-Length: " + std::to_string(this->body.size()) + "\r\n";
+            response += close ? "Connection: close\r\n\r\n" : "\r\n";
+            if(!unchanged)
+                response += this->body;
+            if(::send(socket, response.data(), response.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(response.size()) || close)
+                break;
+        }
+        ::close(socket);
+    }
+
+public:
+    /// @param bodySize - the size of the HTTP response body.
+    /// @param etag - the quoted ETag of the body, empty for none.
+    explicit LoopbackServers(const std::size_t bodySize = 0, const std::string &etag = std::string())
+    : tcpPort(0), udpPort(0), httpPort(0), body(bodySize, 'x'), etag(etag), running(true)
+    {
+        this->tcpListener = open(SOCK_STREAM, this->tcpPort);
+        this->udpSocket = open(SOCK_DGRAM, this->udpPort);
+        this->httpListener = open(SOCK_STREAM, this->httpPort);
+        if(this->tcpListener < 0 || this->udpSocket < 0 || this->httpListener < 0)
+            return;
+
+        this->accept(this->tcpListener, [this](int socket) { this->echo(socket); });
+        this->accept(this->httpListener, [this](int socket) { this->http(socket); });
+        this->threads.emplace_back([this]()
+        {
+            while(this->running)
+            {
+                if(!ready(this->udpSocket))
+                    continue;
+
+                char buffer[2048];
+                sockaddr_in from = {};
+                socklen_t length = sizeof(from);
+                const ssize_t count = ::recvfrom(this->udpSocket, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &length);
+                if(count > 0)
+                    ::sendto(this->udpSocket, buffer, static_cast<std::size_t>(count), 0, reinterpret_cast<sockaddr*>(&from), length);
+            }
+        });
+    }
+
+    ~LoopbackServers()
+    {
+        this->running = false;
+        for(auto &thread : this->threads)
+            thread.join();
+        for(const int socket : { this->tcpListener, this->udpSocket, this->httpListener })
+        {
+            if(socket >= 0)
+                ::close(socket);
+        }
+    }
+
+    LoopbackServers(const LoopbackServers&) = delete;
+    LoopbackServers& operator=(const LoopbackServers&) = delete;
+
+    bool isReady(void) const
+    {
+        return this->tcpPort != 0 && this->udpPort != 0 && this->httpPort != 0;
+    }
+
+    std::uint16_t getTcpPort(void) const { return this->tcpPort; }
+    std::uint16_t getUdpPort(void) const { return this->udpPort; }
+    std::uint16_t getHttpPort(void) const { return this->httpPort; }
+};
+
+/// @brief
+/// ESP8266Emulator running on one end of a socketpair, with the transport
+/// and clock of the other end for ESP8266.
+///
+/// The emulator runs from construction to destruction, so an ESP8266 on
+/// the link must be declared after it.
+///
+class EmulatorLink
+{
+private:
+    struct SocketPair
+    {
+        int fds[2];
+
+        SocketPair()
+        {
+            if(::socketpair(AF_UNIX, SOCK_STREAM, 0, this->fds) != 0)
+                this->fds[0] = this->fds[1] = -1;
+        }
+
+        ~SocketPair()
+        {
+            for(const int fd : this->fds)
+            {
+                if(fd >= 0)
+                    ::close(fd);
+            }
+        }
+    };
+
+	SocketPair pair;
+	ESP8266Emulator emulator;
+	ESP8266PosixTransport transport;
+	ESP8266PosixClock clock;
+
+public:
+    explicit EmulatorLink(const ESP8266EmulatorConfig &config)
+    : pair(), emulator(pair.fds[1], config), transport(pair.fds[0])
+    {
+        if(this->isReady())
+            this->emulator.start();
+    }
+
+    ~EmulatorLink()
+    {
+        this->emulator.stop();
+    }
+
+    EmulatorLink(const EmulatorLink&) = delete;
+    EmulatorLink& operator=(const EmulatorLink&) = delete;
+
+    bool isReady(void) const
+    {
+        return this->pair.fds[0] >= 0;
+    }
+
+    ESP8266Emulator& getEmulator(void) { return this->emulator; }
+    ESP8266PosixTransport& getTransport(void) { return this->transport; }
+    ESP8266PosixClock& getClock(void) { return this->clock; }
+};
+
+/// @brief
+/// Throughput and latency percentiles of one timed operation.
+///
+struct BenchResult
+{
+    std::string name;
+    std::uint32_t baud;
+    std::size_t payload;
+    std::size_t operations;
+    std::size_t failures;
+    double operationsPerSecond;
+    double bytesPerSecond;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+/// @brief
+/// Time an operation, once per iteration after a few warm up calls.
+///
+/// @param operation - returns false on failure.
+/// @param payload - the bytes moved by one operation, for the throughput.
+/// @param warmups - untimed calls first, 0 when every call must be counted.
+///
+inline BenchResult measure(const std::string &name, const std::uint32_t baud, const std::size_t payload, const std::size_t iterations,
+    const std::function<bool(void)> &operation, const std::size_t warmups = 3)
+{
+    BenchResult result = {};
+    result.name = name;
+    result.baud = baud;
+    result.payload = payload;
+    result.operations = iterations;
+
+    for(std::size_t i = 0; i < warmups; i++)
+        operation();
+
+    std::vector<double> latencies;
+    latencies.reserve(iterations);
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < iterations; i++)
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        if(!operation())
+            result.failures++;
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](const double rank)
+    {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(rank * latencies.size()))];
+    };
+    result.operationsPerSecond = iterations / elapsed.count();
+    result.bytesPerSecond = result.operationsPerSecond * payload;
+    result.p50 = percentile(0.50);
+    result.p90 = percentile(0.90);
+    result.p99 = percentile(0.99);
+    result.max = latencies.back();
+    return result;
+}
+
+inline void printTable(const std::vector<BenchResult> &results)
+{
+    std::printf("%-16s %8s %7s %10s %12s %9s %9s %9s %9s %5s\n",
+        "operation", "baud", "payload", "ops/s", "bytes/s", "p50 us", "p90 us", "p99 us", "max us", "fail");
+    for(const BenchResult &result : results)
+    {
+        std::printf("%-16s %8u %7zu %10.1f %12.0f %9.0f %9.0f %9.0f %9.0f %5zu\n",
+            result.name.c_str(), static_cast<unsigned>(result.baud), result.payload, result.operationsPerSecond,
+            result.bytesPerSecond, result.p50, result.p90, result.p99, result.max, result.failures);
+    }
+}
+
+inline void printJson(const std::vector<BenchResult> &results, const int linkMode)
+{
+    std::printf("{\n  \"linkMode\": %d,\n  \"results\": [\n", linkMode);
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results[i];
+        std::printf("    {\"operation\": \"%s\", \"baud\": %u, \"payload\": %zu, \"operations\": %zu, \"failures\": %zu, "
+            "\"opsPerSecond\": %.1f, \"bytesPerSecond\": %.0f, \"p50Us\": %.1f, \"p90Us\": %.1f, \"p99Us\": %.1f, \"maxUs\": %.1f}%s\n",
+            result.name.c_str(), static_cast<unsigned>(result.baud), result.payload, result.operations, result.failures,
+            result.operationsPerSecond, result.bytesPerSecond, result.p50, result.p90, result.p99, result.max,
+            (i + 1 < results.size()) ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+inline std::size_t countFailures(const std::vector<BenchResult> &results)
+{
+    std::size_t failures = 0;
+    for(const BenchResult &result : results)
+        failures += result.failures;
+    return failures;
+}
+
+#endif
@@ -0,0 +1,2016 @@
+///
+/// @file ESP8266Emulator.cpp
+/// @brief Host stand-in for the ESP8266 firmware.
+///
+
+#ifdef ESP8266_POSIX
+
+#include "ESP8266Emulator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const std::uint16_t emulatorVersion = 0x0100;
+static const char* emulatorVersionString = "1.0.0-emulator";
+
+// share of the bytes garbled above ESP8266EmulatorConfig::maxBaud
+static const double overspeedErrorRate = 0.02;
+
+// ESP8266HTTPClient error codes
+static const std::int32_t httpErrorConnectionRefused = -1;
+static const std::int32_t httpErrorSendHeaderFailed = -2;
+static const std::int32_t httpErrorNotConnected = -4;
+static const std::int32_t httpErrorConnectionLost = -5;
+static const std::int32_t httpErrorNoHttpServer = -7;
+static const std::int32_t httpErrorReadTimeout = -11;
+
+//
+// helpers
+//
+
+static bool resolve(const std::string &host, const std::uint16_t port, sockaddr_in &address)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+
+    addrinfo* result = nullptr;
+    if(::getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+        return false;
+
+    std::memcpy(&address, result->ai_addr, sizeof(address));
+    address.sin_port = htons(port);
+    ::freeaddrinfo(result);
+    return true;
+}
+
+static int connectTcp(const std::string &host, const std::uint16_t port, const int timeout)
+{
+    sockaddr_in address;
+    if(!resolve(host, port, address))
+        return -1;
+
+    const int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(socket < 0)
+        return -1;
+
+    ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL) | O_NONBLOCK);
+    if(::connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 && errno != EINPROGRESS)
+    {
+        ::close(socket);
+        return -1;
+    }
+
+    pollfd descriptor = { socket, POLLOUT, 0 };
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if(::poll(&descriptor, 1, timeout) != 1 || ::getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0)
+    {
+        ::close(socket);
+        return -1;
+    }
+
+    return socket;
+}
+
+static bool sendAll(const int socket, const std::uint8_t* data, const std::size_t size)
+{
+    std::size_t sent = 0;
+    while(sent < size)
+    {
+        const ssize_t count = ::send(socket, data + sent, size - sent, MSG_NOSIGNAL);
+        if(count > 0)
+        {
+            sent += static_cast<std::size_t>(count);
+            continue;
+        }
+
+        if(count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return false;
+
+        pollfd descriptor = { socket, POLLOUT, 0 };
+        if(::poll(&descriptor, 1, 1000) != 1)
+            return false;
+    }
+
+    return true;
+}
+
+static std::size_t pendingBytes(const int socket)
+{
+    int count = 0;
+    if(socket < 0 || ::ioctl(socket, FIONREAD, &count) < 0 || count < 0)
+        return 0;
+
+    return static_cast<std::size_t>(count);
+}
+
+static bool isConnected(const int socket)
+{
+    if(socket < 0)
+        return false;
+
+    std::uint8_t peek;
+    const ssize_t count = ::recv(socket, &peek, 1, MSG_PEEK | MSG_DONTWAIT);
+    return (count > 0) || (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+static std::string toLower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+// Length of the HTTP response at the start of raw, npos while it is incomplete
+// or when only the end of the connection ends the body.
+static std::size_t httpResponseLength(const std::string &raw, bool &untilClose)
+{
+    untilClose = false;
+    const std::size_t headerEnd = raw.find("\r\n\r\n");
+    if(headerEnd == std::string::npos)
+        return std::string::npos;
+    const std::size_t bodyStart = headerEnd + 4;
+
+    const std::size_t space = raw.find(' ');
+    const int code = space < headerEnd ? std::atoi(raw.c_str() + space + 1) : 0;
+    if((code >= 100 && code < 200) || code == 204 || code == 304)
+        return bodyStart;
+
+    const std::string headers = toLower(raw.substr(0, bodyStart));
+    if(headers.find("\r\ntransfer-encoding: chunked\r\n") != std::string::npos)
+    {
+        std::size_t position = bodyStart;
+        while(true)
+        {
+            const std::size_t end = raw.find("\r\n", position);
+            if(end == std::string::npos)
+                return std::string::npos;
+
+            const std::size_t length = std::strtoul(raw.c_str() + position, nullptr, 16);
+            if(length == 0)
+            {
+                // the last chunk, then optional trailers and an empty line
+                const std::size_t trailerEnd = raw.compare(end + 2, 2, "\r\n") == 0 ? end : raw.find("\r\n\r\n", end);
+                return trailerEnd != std::string::npos ? trailerEnd + 4 : std::string::npos;
+            }
+
+            position = end + 2 + length + 2;
+            if(position > raw.size())
+                return std::string::npos;
+        }
+    }
+
+    const std::size_t field = headers.find("\r\ncontent-length:");
+    if(field != std::string::npos)
+    {
+        const std::size_t length = bodyStart + std::strtoul(headers.c_str() + field + 17, nullptr, 10);
+        return raw.size() >= length ? length : std::string::npos;
+    }
+
+    untilClose = true;
+    return std::string::npos;
+}
+
+static void sha1(const std::uint8_t* data, const std::size_t size, std::uint8_t hash[20])
+{
+    std::uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    std::vector<std::uint8_t> message(data, data + size);
+    message.push_back(0x80);
+    while((message.size() % 64) != 56)
+        message.push_back(0);
+
+    const std::uint64_t bits = static_cast<std::uint64_t>(size) * 8;
+    for(int i = 7; i >= 0; --i)
+        message.push_back(static_cast<std::uint8_t>(bits >> (i * 8)));
+
+    auto rotate = [](const std::uint32_t value, const int count) { return (value << count) | (value >> (32 - count)); };
+
+    for(std::size_t block = 0; block < message.size(); block += 64)
+    {
+        std::uint32_t w[80];
+        for(int i = 0; i < 16; ++i)
+        {
+            const std::uint8_t* p = &message[block + i * 4];
+            w[i] = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+        }
+        for(int i = 16; i < 80; ++i)
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for(int i = 0; i < 80; ++i)
+        {
+            std::uint32_t f, k;
+            if(i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if(i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if(i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+
+            const std::uint32_t temp = rotate(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rotate(b, 30); b = a; a = temp;
+        }
+
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for(int i = 0; i < 5; ++i)
+        for(int j = 0; j < 4; ++j)
+            hash[i * 4 + j] = static_cast<std::uint8_t>(h[i] >> (24 - j * 8));
+}
+
+//
+// lifetime
+//
+
+ESP8266Emulator::ESP8266Emulator(const int fd, const ESP8266EmulatorConfig &config)
+: fd(fd), config(config), running(false), random(config.seed), inputOffset(0),
+  bytesReceived(0), bytesSent(0), commandCount(0), httpSocket(-1), httpSocketPort(0),
+  httpReuse(false), httpConnectCount(0), espNowSocket(-1)
+{
+    for(std::size_t i = 0; i < 5; ++i)
+    {
+        this->tcp[i] = -1;
+        this->udp[i] = -1;
+    }
+
+    const std::uint8_t defaultMac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    std::memcpy(this->mac, defaultMac, sizeof(this->mac));
+    if(config.espNowPort != 0)
+        this->mac[5] = static_cast<std::uint8_t>(config.espNowPort & 0xFF);
+
+    NetworkInfo network;
+    std::memset(&network, 0, sizeof(network));
+    std::strcpy(network.ssid, "Emulator");
+    network.encryptionType = EncryptionType::None;
+    network.rssi = -42;
+    network.channel = 1;
+    std::memcpy(network.bssid, this->mac, sizeof(network.bssid));
+    this->networks.push_back(network);
+
+    this->reset();
+}
+
+ESP8266Emulator::~ESP8266Emulator()
+{
+    this->stop();
+    this->closeSockets();
+}
+
+void ESP8266Emulator::start(void)
+{
+    if(this->running)
+        return;
+
+    this->running = true;
+    this->thread = std::thread([this]() { this->run(); });
+}
+
+void ESP8266Emulator::stop(void)
+{
+    this->running = false;
+    if(this->thread.joinable())
+        this->thread.join();
+}
+
+void ESP8266Emulator::addNetwork(const NetworkInfo &info)
+{
+    this->networks.push_back(info);
+}
+
+std::uint64_t ESP8266Emulator::getBytesReceived(void) const
+{
+    return this->bytesReceived;
+}
+
+std::uint64_t ESP8266Emulator::getBytesSent(void) const
+{
+    return this->bytesSent;
+}
+
+std::uint64_t ESP8266Emulator::getCommandCount(void) const
+{
+    return this->commandCount;
+}
+
+std::uint64_t ESP8266Emulator::getHttpConnectCount(void) const
+{
+    return this->httpConnectCount;
+}
+
+void ESP8266Emulator::reset(void)
+{
+    this->closeSockets();
+
+    this->wifiMode = WiFiMode::Station;
+    this->wifiStatus = WifiStatus::Disconnected;
+    this->ssid.clear();
+    this->scanDone = false;
+    this->softAPSsid = "Emulator-AP";
+    this->softAPPassphrase.clear();
+    this->http = HttpState();
+    this->httpReuse = false;
+    this->espNowActive = false;
+    this->espNowFrames.clear();
+    this->linkMode = LinkMode::Legacy;
+    this->compression = false;
+    this->seq = 0;
+    this->expectedSeq = 1;
+    this->resendAsked = false;
+    this->frameEnd = 0;
+    for(std::size_t i = 0; i < 256; ++i)
+        this->replies[i].clear();
+    this->probing = false;
+
+    this->eventMask = 0;
+    for(std::size_t i = 0; i < 5; ++i)
+    {
+        this->tcpWatched[i] = -1;
+        this->udpWatched[i] = -1;
+    }
+    this->espNowReported = 0;
+    this->reportedStatus = this->wifiStatus;
+}
+
+void ESP8266Emulator::closeSockets(void)
+{
+    for(std::size_t i = 0; i < 5; ++i)
+    {
+        if(this->tcp[i] >= 0)
+            ::close(this->tcp[i]);
+        if(this->udp[i] >= 0)
+            ::close(this->udp[i]);
+        this->tcp[i] = -1;
+        this->udp[i] = -1;
+    }
+
+    if(this->espNowSocket >= 0)
+        ::close(this->espNowSocket);
+    this->espNowSocket = -1;
+
+    this->closeHttpSocket();
+}
+
+bool ESP8266Emulator::validId(const std::uint8_t id) const
+{
+    return id < 5;
+}
+
+//
+// link
+//
+
+bool ESP8266Emulator::chance(const double rate)
+{
+    if(rate <= 0.0)
+        return false;
+
+    return std::uniform_real_distribution<double>(0.0, 1.0)(this->random) < rate;
+}
+
+void ESP8266Emulator::pollProbe(void)
+{
+    if(!this->probing || Clock::now() < this->probeDeadline)
+        return;
+
+    this->config.baud = this->probeFallback;
+    this->probing = false;
+}
+
+void ESP8266Emulator::pace(Clock::time_point &lineFree, const std::size_t bytes)
+{
+    if(this->config.baud == 0)
+        return;
+
+    // 8N1: ten bit times per byte
+    const auto byteTime = std::chrono::nanoseconds(10000000000ull / this->config.baud);
+    const auto now = Clock::now();
+    if(lineFree < now)
+        lineFree = now;
+
+    lineFree += byteTime * bytes;
+    std::this_thread::sleep_until(lineFree);
+}
+
+bool ESP8266Emulator::fill(const int timeoutMs)
+{
+    if(this->inputOffset == this->input.size())
+    {
+        this->input.clear();
+        this->inputOffset = 0;
+    }
+
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while(true)
+    {
+        if(!this->running)
+            return false;
+        if(timeoutMs != 0 && Clock::now() >= deadline)
+            return false;
+
+        this->pollProbe();
+        this->pollEspNow();
+        this->pollEvents();
+
+        pollfd descriptor = { this->fd, POLLIN, 0 };
+        const int ready = ::poll(&descriptor, 1, 20);
+        if(ready < 0 && errno != EINTR)
+            return false;
+        if(ready <= 0)
+            continue;
+
+        std::uint8_t buffer[256];
+        const ssize_t count = ::read(this->fd, buffer, sizeof(buffer));
+        if(count == 0 || (count < 0 && errno != EAGAIN && errno != EINTR))
+            return false;
+        if(count < 0)
+            continue;
+
+        this->pace(this->rxLineFree, static_cast<std::size_t>(count));
+        this->bytesReceived += static_cast<std::uint64_t>(count);
+
+        bool filled = false;
+        for(ssize_t i = 0; i < count; ++i)
+        {
+            if(this->chance(this->config.rxLossRate))
+                continue;
+            this->input.push_back(buffer[i]);
+            filled = true;
+        }
+
+        if(filled)
+            return true;
+    }
+}
+
+bool ESP8266Emulator::readBytes(std::uint8_t* buffer, const std::size_t size, const int timeoutMs)
+{
+    std::size_t index = 0;
+    while(index < size)
+    {
+        if(this->inputOffset == this->input.size() && !this->fill(timeoutMs))
+            return false;
+
+        const std::size_t count = std::min(size - index, this->input.size() - this->inputOffset);
+        std::memcpy(buffer + index, &this->input[this->inputOffset], count);
+        this->inputOffset += count;
+        index += count;
+    }
+
+    return true;
+}
+
+bool ESP8266Emulator::read8(std::uint8_t &value)
+{
+    return this->readBytes(&value, 1);
+}
+
+bool ESP8266Emulator::read16(std::uint16_t &value)
+{
+    std::uint8_t bytes[2];
+    if(!this->readBytes(bytes, sizeof(bytes)))
+        return false;
+
+    value = static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+    return true;
+}
+
+bool ESP8266Emulator::read32(std::uint32_t &value)
+{
+    std::uint8_t bytes[4];
+    if(!this->readBytes(bytes, sizeof(bytes)))
+        return false;
+
+    value = std::uint32_t(bytes[0]) | (std::uint32_t(bytes[1]) << 8) | (std::uint32_t(bytes[2]) << 16) | (std::uint32_t(bytes[3]) << 24);
+    return true;
+}
+
+bool ESP8266Emulator::readString(std::string &value)
+{
+    value.clear();
+    while(true)
+    {
+        std::uint8_t c;
+        if(!this->read8(c))
+            return false;
+        if(c == '\n')
+            return true;
+        value += static_cast<char>(c);
+    }
+}
+
+bool ESP8266Emulator::readPayload(std::vector<std::uint8_t> &payload)
+{
+    std::uint16_t size;
+    if(!this->read16(size))
+        return false;
+
+    if(!this->compression)
+    {
+        payload.resize(size);
+        return size == 0 || this->readBytes(payload.data(), size);
+    }
+
+    // the packed size, the same as size for a payload sent as it is
+    std::uint16_t packedSize;
+    if(!this->read16(packedSize))
+        return false;
+
+    std::vector<std::uint8_t> packed(packedSize);
+    if(packedSize != 0 && !this->readBytes(packed.data(), packedSize))
+        return false;
+
+    if(packedSize == size)
+        payload.swap(packed);
+    else if(!Lzss::decode(packed.data(), packed.size(), payload) || payload.size() != size)
+        payload.clear();
+    return true;
+}
+
+void ESP8266Emulator::writeBytes(const std::uint8_t* data, const std::size_t size)
+{
+    std::uniform_int_distribution<std::uint32_t> jitter(0, this->config.byteJitterUs);
+    const bool overspeed = (this->config.maxBaud != 0 && this->config.baud > this->config.maxBaud);
+
+    // small chunks so the host sees the bytes trickle in at line rate
+    const std::size_t chunkSize = 16;
+    for(std::size_t offset = 0; offset < size; offset += chunkSize)
+    {
+        const std::size_t count = std::min(chunkSize, size - offset);
+
+        std::uint8_t chunk[chunkSize];
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            if(this->config.byteJitterUs != 0)
+                this->txLineFree += std::chrono::microseconds(jitter(this->random));
+            if(this->chance(this->config.txLossRate))
+                continue;
+
+            chunk[kept] = data[offset + i];
+            if(overspeed && this->chance(overspeedErrorRate))
+                chunk[kept] ^= static_cast<std::uint8_t>(1 << (this->random() % 8));
+            kept++;
+        }
+
+        this->pace(this->txLineFree, count);
+
+        std::size_t sent = 0;
+        while(sent < kept)
+        {
+            const ssize_t written = ::write(this->fd, chunk + sent, kept - sent);
+            if(written > 0)
+            {
+                sent += static_cast<std::size_t>(written);
+                continue;
+            }
+            if(written < 0 && errno != EAGAIN && errno != EINTR)
+                return;
+
+            pollfd descriptor = { this->fd, POLLOUT, 0 };
+            ::poll(&descriptor, 1, 10);
+        }
+
+        this->bytesSent += kept;
+    }
+}
+
+//
+// responses, collected per command and written in one go
+//
+
+void ESP8266Emulator::respond(const Response response)
+{
+    const std::uint16_t code = static_cast<std::uint16_t>(response);
+    if(this->linkMode == LinkMode::Pipelined)
+        this->response.push_back(this->seq);
+    this->response.push_back(static_cast<std::uint8_t>(code & 0xFF));
+    this->response.push_back(static_cast<std::uint8_t>(code >> 8));
+}
+
+void ESP8266Emulator::respondData(const void* data, const std::size_t size)
+{
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    std::uint16_t length = static_cast<std::uint16_t>(std::min<std::size_t>(size, 0xFFFF));
+
+    std::vector<std::uint8_t> packed;
+    if(this->compression && length >= ESP8266_PACK_THRESHOLD && Lzss::encode(bytes, length, packed))
+    {
+        bytes = packed.data();
+        length = static_cast<std::uint16_t>(packed.size());
+        this->respond(Response::PackedData);
+    }
+    else
+        this->respond(Response::Data);
+    this->response.push_back(static_cast<std::uint8_t>(length & 0xFF));
+    this->response.push_back(static_cast<std::uint8_t>(length >> 8));
+    this->response.insert(this->response.end(), bytes, bytes + length);
+}
+
+void ESP8266Emulator::respondString(const std::string &value)
+{
+    const std::uint16_t length = static_cast<std::uint16_t>(std::min<std::size_t>(value.size(), 0xFFFF));
+
+    std::vector<std::uint8_t> packed;
+    if(this->compression && length >= ESP8266_PACK_THRESHOLD && Lzss::encode(reinterpret_cast<const std::uint8_t*>(value.data()), length, packed))
+    {
+        this->respond(Response::PackedString);
+        this->response.push_back(static_cast<std::uint8_t>(packed.size() & 0xFF));
+        this->response.push_back(static_cast<std::uint8_t>(packed.size() >> 8));
+        this->response.insert(this->response.end(), packed.begin(), packed.end());
+        return;
+    }
+
+    this->respond(Response::String);
+    this->response.push_back(static_cast<std::uint8_t>(length & 0xFF));
+    this->response.push_back(static_cast<std::uint8_t>(length >> 8));
+    this->response.insert(this->response.end(), value.begin(), value.begin() + length);
+}
+
+void ESP8266Emulator::respond16(const std::uint16_t value)
+{
+    const std::uint8_t bytes[2] = { static_cast<std::uint8_t>(value & 0xFF), static_cast<std::uint8_t>(value >> 8) };
+    this->respondData(bytes, sizeof(bytes));
+}
+
+void ESP8266Emulator::respond32(const std::uint32_t value)
+{
+    const std::uint8_t bytes[4] =
+    {
+        static_cast<std::uint8_t>(value & 0xFF),
+        static_cast<std::uint8_t>((value >> 8) & 0xFF),
+        static_cast<std::uint8_t>((value >> 16) & 0xFF),
+        static_cast<std::uint8_t>(value >> 24),
+    };
+    this->respondData(bytes, sizeof(bytes));
+}
+
+void ESP8266Emulator::flushResponse(void)
+{
+    if(this->response.empty())
+        return;
+
+    if(this->config.responseLatencyUs != 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(this->config.responseLatencyUs));
+
+    if(this->linkMode == LinkMode::Framed)
+    {
+        this->sendFrame(this->seq, this->response.data(), this->response.size());
+        this->response.clear();
+        return;
+    }
+
+    this->writeBytes(this->response.data(), this->response.size());
+    this->response.clear();
+}
+
+//
+// LinkMode::Framed
+//
+
+void ESP8266Emulator::sendFrame(const std::uint8_t seq, const std::uint8_t* payload, const std::size_t size)
+{
+    std::vector<std::uint8_t> frame;
+    frame.reserve(size + 7);
+    frame.push_back(linkSync[0]);
+    frame.push_back(linkSync[1]);
+    frame.push_back(seq);
+    frame.push_back(static_cast<std::uint8_t>(size & 0xFF));
+    frame.push_back(static_cast<std::uint8_t>(size >> 8));
+    frame.insert(frame.end(), payload, payload + size);
+
+    const std::uint16_t crc = Crc16::update(Crc16::initial, frame.data() + 2, frame.size() - 2);
+    frame.push_back(static_cast<std::uint8_t>(crc & 0xFF));
+    frame.push_back(static_cast<std::uint8_t>(crc >> 8));
+
+    // kept to answer the command again if the host lost the reply
+    if(seq != 0)
+        this->replies[seq] = frame;
+
+    this->writeBytes(frame.data(), frame.size());
+}
+
+bool ESP8266Emulator::readFrame(bool &execute)
+{
+    execute = false;
+
+    // hunt for the sync bytes
+    std::uint8_t value = 0;
+    std::size_t matched = 0;
+    while(matched < sizeof(linkSync))
+    {
+        if(!this->read8(value))
+            return false;
+
+        if(value == linkSync[matched])
+            matched++;
+        else
+            matched = (value == linkSync[0]) ? 1 : 0;
+    }
+
+    // the rest of the frame must follow without a gap
+    std::uint8_t header[4];
+    std::vector<std::uint8_t> payload;
+    std::uint8_t trailer[2];
+    bool complete = this->readBytes(header, sizeof(header), ESP8266_LINK_GAP);
+    if(complete)
+    {
+        payload.resize(static_cast<std::size_t>(header[2] | (header[3] << 8)));
+        complete = (payload.empty() || this->readBytes(payload.data(), payload.size(), ESP8266_LINK_GAP))
+            && this->readBytes(trailer, sizeof(trailer), ESP8266_LINK_GAP);
+    }
+    if(!this->running)
+        return false;
+
+    std::uint16_t crc = Crc16::update(Crc16::initial, header, sizeof(header));
+    crc = Crc16::update(crc, payload.data(), payload.size());
+    const bool valid = complete && crc == static_cast<std::uint16_t>(trailer[0] | (trailer[1] << 8));
+
+    // the host gave up on the commands before its oldest one
+    const std::uint8_t seq = header[0];
+    const std::uint8_t oldest = header[1];
+    const std::size_t skipped = (static_cast<std::size_t>(oldest) + 255 - this->expectedSeq) % 255;
+    if(valid && oldest != 0 && skipped != 0 && skipped < 128)
+        this->expectedSeq = oldest;
+
+    if(valid && seq == this->expectedSeq)
+    {
+        // the handlers read the command from the input
+        this->input.insert(this->input.begin() + this->inputOffset, payload.begin(), payload.end());
+        this->frameEnd = this->inputOffset + payload.size();
+        this->seq = seq;
+        this->expectedSeq = (seq == 0xFF) ? 1 : seq + 1;
+        this->resendAsked = false;
+        execute = true;
+        return true;
+    }
+
+    // a command that already ran, its reply was lost
+    const std::size_t behind = (static_cast<std::size_t>(this->expectedSeq) + 255 - seq) % 255;
+    if(valid && seq != 0 && behind != 0 && behind <= 16 && !this->replies[seq].empty())
+    {
+        this->writeBytes(this->replies[seq].data(), this->replies[seq].size());
+        return true;
+    }
+
+    // ask for everything unanswered when a frame is broken, and once when
+    // a frame is missing, the ones already on the way follow it
+    if(!valid || !this->resendAsked)
+    {
+        const std::uint8_t resend[2] =
+        {
+            static_cast<std::uint8_t>(static_cast<std::uint16_t>(Response::Resend) & 0xFF),
+            static_cast<std::uint8_t>(static_cast<std::uint16_t>(Response::Resend) >> 8),
+        };
+        this->sendFrame(0, resend, sizeof(resend));
+        this->resendAsked = true;
+    }
+    return true;
+}
+
+//
+// main loop
+//
+
+void ESP8266Emulator::run(void)
+{
+    this->running = true;
+    this->rxLineFree = Clock::now();
+    this->txLineFree = Clock::now();
+
+    while(this->running)
+    {
+        if(this->linkMode == LinkMode::Framed)
+        {
+            bool execute;
+            if(!this->readFrame(execute))
+                break;
+            if(!execute)
+                continue;
+        }
+        else if(this->linkMode == LinkMode::Pipelined && !this->read8(this->seq))
+            break;
+
+        std::uint16_t command;
+        if(!this->read16(command))
+            break;
+
+        ++this->commandCount;
+        const LinkMode mode = this->linkMode;
+        if(!this->handle(static_cast<Commands>(command)))
+            break;
+
+        // arguments the command did not read belong to its frame
+        if(mode == LinkMode::Framed && this->inputOffset < this->frameEnd)
+            this->inputOffset = this->frameEnd;
+
+        this->flushResponse();
+        this->pollEvents();
+    }
+
+    this->running = false;
+}
+
+bool ESP8266Emulator::handle(const Commands command)
+{
+    std::uint8_t id = 0;
+    std::uint16_t value16 = 0;
+    std::uint32_t value32 = 0;
+    std::string text, text2;
+    std::vector<std::uint8_t> payload;
+
+    switch(command)
+    {
+        case Commands::nop:
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::restart:
+            // acknowledged before coming back in legacy mode
+            this->respond(Response::Ok);
+            this->flushResponse();
+            this->reset();
+            return true;
+
+        case Commands::checkVersion:
+            if(!this->readString(text))
+                return false;
+            this->respond(text == emulatorVersionString ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::getVersion:
+            this->respond16(emulatorVersion);
+            return true;
+
+        case Commands::getVersionString:
+            this->respondString(emulatorVersionString);
+            return true;
+
+        case Commands::setBaudRate:
+            if(!this->read32(value32))
+                return false;
+            // acknowledged at the old rate, then again at the new one
+            this->respond(Response::Ok);
+            this->flushResponse();
+            this->config.baud = value32;
+            this->probing = false;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::eraseConfig:
+            this->respond(Response::Ok);
+            return true;
+
+        //
+        // WiFi
+        //
+
+        case Commands::setWifiMode:
+            if(!this->read16(value16))
+                return false;
+            this->wifiMode = static_cast<WiFiMode>(value16);
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::getWifiMode:
+            this->respond16(static_cast<std::uint16_t>(this->wifiMode));
+            return true;
+
+        case Commands::joinAP:
+        {
+            if(!this->readString(text) || !this->readString(text2))
+                return false;
+
+            const bool known = std::any_of(this->networks.begin(), this->networks.end(), [&](const NetworkInfo &info) { return text == info.ssid; });
+            this->wifiStatus = known ? WifiStatus::Connected : WifiStatus::NoSSIDAvailable;
+            this->ssid = known ? text : "";
+            this->respond(known ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::getStatus:
+            this->respond16(static_cast<std::uint16_t>(this->wifiStatus));
+            return true;
+
+        case Commands::leaveAP:
+            this->wifiStatus = WifiStatus::Disconnected;
+            this->ssid.clear();
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::getSSID:
+            this->respondString(this->ssid);
+            return true;
+
+        case Commands::getRSSI:
+            this->respond32(static_cast<std::uint32_t>(this->wifiStatus == WifiStatus::Connected ? -42 : 0));
+            return true;
+
+        case Commands::getLocalIP:
+            this->respondString("127.0.0.1");
+            return true;
+
+        case Commands::getLocalIPBinary:
+        case Commands::getGatewayIPBinary:
+        {
+            const std::uint8_t loopback[4] = { 127, 0, 0, 1 };
+            this->respondData(loopback, sizeof(loopback));
+            return true;
+        }
+
+        case Commands::getGatewayIP:
+            this->respondString("127.0.0.1");
+            return true;
+
+        case Commands::getSubnetMask:
+            this->respondString("255.0.0.0");
+            return true;
+
+        case Commands::getSubnetMaskBinary:
+        {
+            const std::uint8_t mask[4] = { 255, 0, 0, 0 };
+            this->respondData(mask, sizeof(mask));
+            return true;
+        }
+
+        case Commands::getMac:
+        {
+            char buffer[18];
+            std::snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X", this->mac[0], this->mac[1], this->mac[2], this->mac[3], this->mac[4], this->mac[5]);
+            this->respondString(buffer);
+            return true;
+        }
+
+        case Commands::getMacBinary:
+            this->respondData(this->mac, sizeof(this->mac));
+            return true;
+
+        case Commands::setStationIP:
+            for(int i = 0; i < 5; ++i)
+                if(!this->readString(text))
+                    return false;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::setStationIPBinary:
+        {
+            std::uint8_t addresses[5 * 4];
+            if(!this->readBytes(addresses, sizeof(addresses)))
+                return false;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::scanNetworks:
+        {
+            std::uint8_t async, hidden;
+            if(!this->read8(async) || !this->read8(hidden) || !this->read8(id) || !this->readString(text))
+                return false;
+            this->scanDone = true;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::scanComplete:
+            this->respond16(this->scanDone ? static_cast<std::uint16_t>(this->networks.size()) : static_cast<std::uint16_t>(-1));
+            return true;
+
+        case Commands::getNetworkInfo:
+            if(!this->read16(value16))
+                return false;
+            if(value16 < this->networks.size())
+                this->respondData(&this->networks[value16], sizeof(NetworkInfo));
+            else
+                this->respond(Response::Error);
+            return true;
+
+        //
+        // Wifi SoftAccessPoint
+        //
+
+        case Commands::setSoftAPConfig:
+            if(!this->read16(value16) || !this->readString(text) || !this->readString(text2))
+                return false;
+            this->softAPSsid = text;
+            this->softAPPassphrase = text2;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::getSoftAPConfig:
+            this->respondString(this->softAPSsid);
+            this->respondString(this->softAPPassphrase);
+            return true;
+
+        case Commands::setSoftAPIP:
+            for(int i = 0; i < 3; ++i)
+                if(!this->readString(text))
+                    return false;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::setSoftAPIPBinary:
+        {
+            std::uint8_t addresses[3 * 4];
+            if(!this->readBytes(addresses, sizeof(addresses)))
+                return false;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::getSoftAPIP:
+            this->respondString("192.168.4.1");
+            this->respondString("02:00:00:00:00:FF");
+            return true;
+
+        case Commands::getSoftAPIPBinary:
+        {
+            const std::uint8_t address[4] = { 192, 168, 4, 1 };
+            const std::uint8_t softAPMac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0xFF };
+            this->respondData(address, sizeof(address));
+            this->respondData(softAPMac, sizeof(softAPMac));
+            return true;
+        }
+
+        case Commands::softAPdisconnect:
+            if(!this->read16(value16))
+                return false;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::softAPgetStationNum:
+            this->respond16(0);
+            return true;
+
+        case Commands::getSoftAPClient:
+            if(!this->read16(value16))
+                return false;
+            this->respondString("");
+            this->respondString("");
+            return true;
+
+        case Commands::getSoftAPClientBinary:
+            if(!this->read16(value16))
+                return false;
+            // no station ever joins
+            this->respond(Response::Error);
+            return true;
+
+        //
+        // TCP
+        //
+
+        case Commands::createTCP:
+            if(!this->read8(id) || !this->read16(value16) || !this->readString(text))
+                return false;
+            if(!this->validId(id))
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+            if(this->tcp[id] >= 0)
+                ::close(this->tcp[id]);
+            this->tcp[id] = connectTcp(text, value16, 3000);
+            this->respond(this->tcp[id] >= 0 ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::sendTCP:
+            if(!this->read8(id) || !this->readPayload(payload))
+                return false;
+            this->respond(this->validId(id) && this->tcp[id] >= 0 && sendAll(this->tcp[id], payload.data(), payload.size()) ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::availableTCP:
+            if(!this->read8(id))
+                return false;
+            this->respond(this->validId(id) && pendingBytes(this->tcp[id]) != 0 ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::readTCP:
+        {
+            if(!this->read8(id))
+                return false;
+
+            std::vector<std::uint8_t> buffer(this->config.maxReadSize);
+            ssize_t count = 0;
+            if(this->validId(id) && this->tcp[id] >= 0)
+                count = ::recv(this->tcp[id], buffer.data(), buffer.size(), MSG_DONTWAIT);
+            this->respondData(buffer.data(), count > 0 ? static_cast<std::size_t>(count) : 0);
+            if(this->validId(id))
+                this->tcpReadable[id] = false;
+            return true;
+        }
+
+        case Commands::closeTCP:
+            if(!this->read8(id))
+                return false;
+            if(this->validId(id) && this->tcp[id] >= 0)
+            {
+                ::close(this->tcp[id]);
+                this->tcp[id] = -1;
+            }
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::isConnectedTCP:
+            if(!this->read8(id))
+                return false;
+            this->respond(this->validId(id) && isConnected(this->tcp[id]) ? Response::Ok : Response::Error);
+            return true;
+
+        //
+        // UDP
+        //
+
+        case Commands::createUDP:
+            if(!this->read8(id) || !this->read16(value16) || !this->readString(text))
+                return false;
+            if(!this->validId(id) || !resolve(text, value16, this->udpTarget[id]))
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+            if(this->udp[id] < 0)
+                this->udp[id] = ::socket(AF_INET, SOCK_DGRAM, 0);
+            this->respond(this->udp[id] >= 0 ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::sendUDP:
+        {
+            if(!this->read8(id) || !this->readPayload(payload))
+                return false;
+
+            bool sent = false;
+            if(this->validId(id) && this->udp[id] >= 0)
+                sent = ::sendto(this->udp[id], payload.data(), payload.size(), 0, reinterpret_cast<sockaddr*>(&this->udpTarget[id]), sizeof(sockaddr_in)) >= 0;
+            this->respond(sent ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::listenUDP:
+        {
+            if(!this->read8(id) || !this->read16(value16))
+                return false;
+            if(!this->validId(id))
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+
+            if(this->udp[id] >= 0)
+                ::close(this->udp[id]);
+            this->udp[id] = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+            const int reuse = 1;
+            ::setsockopt(this->udp[id], SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in address;
+            std::memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_ANY);
+            address.sin_port = htons(value16);
+            const bool bound = ::bind(this->udp[id], reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+            this->respond(bound ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::availableUDP:
+            if(!this->read8(id))
+                return false;
+            this->respond(this->validId(id) && pendingBytes(this->udp[id]) != 0 ? Response::Ok : Response::Error);
+            return true;
+
+        case Commands::readUDP:
+        {
+            if(!this->read8(id))
+                return false;
+
+            std::vector<std::uint8_t> buffer(65536);
+            ssize_t count = 0;
+            if(this->validId(id) && this->udp[id] >= 0)
+            {
+                socklen_t length = sizeof(sockaddr_in);
+                count = ::recvfrom(this->udp[id], buffer.data(), buffer.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&this->udpRemote[id]), &length);
+            }
+            const std::size_t size = count > 0 ? std::min<std::size_t>(static_cast<std::size_t>(count), this->config.maxReadSize) : 0;
+            this->respondData(buffer.data(), size);
+            if(this->validId(id))
+                this->udpReadable[id] = false;
+            return true;
+        }
+
+        case Commands::closeUDP:
+            if(!this->read8(id))
+                return false;
+            if(this->validId(id) && this->udp[id] >= 0)
+            {
+                ::close(this->udp[id]);
+                this->udp[id] = -1;
+            }
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::getRemoteInfoUDP:
+        {
+            if(!this->read8(id))
+                return false;
+            if(!this->validId(id))
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+
+            char address[INET_ADDRSTRLEN] = "";
+            ::inet_ntop(AF_INET, &this->udpRemote[id].sin_addr, address, sizeof(address));
+            this->respond16(ntohs(this->udpRemote[id].sin_port));
+            this->respondString(address);
+            return true;
+        }
+
+        //
+        // HTTP
+        //
+
+        case Commands::createHTTP:
+        {
+            std::uint16_t https;
+            if(!this->read16(https) || !this->read16(value16) || !this->readString(text) || !this->readString(text2))
+                return false;
+
+            this->http = HttpState();
+            this->http.created = true;
+            this->http.https = (https != 0);
+            this->http.port = value16;
+            this->http.host = text;
+            this->http.uri = text2;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::sendGetHTTP:
+            this->respond32(static_cast<std::uint32_t>(this->httpRequest("GET", nullptr, 0)));
+            return true;
+
+        case Commands::getStringHTTP:
+            this->respondString(this->http.body.substr(std::min(this->http.offset, this->http.body.size())));
+            this->http.offset = this->http.body.size();
+            return true;
+
+        case Commands::readDataHTTP:
+        {
+            const std::size_t offset = std::min(this->http.offset, this->http.body.size());
+            const std::size_t count = std::min<std::size_t>(this->http.body.size() - offset, this->config.maxReadSize);
+            this->respondData(this->http.body.data() + offset, count);
+            this->http.offset = offset + count;
+            return true;
+        }
+
+        case Commands::readChunkHTTP:
+        {
+            if(!this->read16(value16))
+                return false;
+            const std::size_t offset = std::min(this->http.offset, this->http.body.size());
+            const std::size_t count = std::min<std::size_t>({ this->http.body.size() - offset, value16, this->config.maxReadSize });
+            this->respondData(this->http.body.data() + offset, count);
+            this->http.offset = offset + count;
+            return true;
+        }
+
+        case Commands::getSizeHTTP:
+            this->respond32(static_cast<std::uint32_t>(this->http.contentLength));
+            return true;
+
+        case Commands::closeHTTP:
+            // a body sent halfway is never ended, the server sees the connection drop
+            if(this->http.streaming)
+                this->closeHttpSocket();
+            this->http = HttpState();
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::setReuseHTTP:
+            if(!this->read8(id))
+                return false;
+            this->httpReuse = (id != 0);
+            if(!this->httpReuse)
+                this->closeHttpSocket();
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::setFingerPrintHTTP:
+        {
+            std::uint8_t fingerprint[20];
+            if(!this->readBytes(fingerprint, sizeof(fingerprint)))
+                return false;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::setInSecureHTTP:
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::addHeaderHTTP:
+            if(!this->readString(text) || !this->readString(text2))
+                return false;
+            this->http.requestHeaders.push_back(std::make_pair(text, text2));
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::getResponseHeaderCountHTTP:
+            this->respond32(static_cast<std::uint32_t>(this->http.responseHeaders.size()));
+            return true;
+
+        case Commands::getResponseHeaderHTTP:
+            if(!this->read32(value32))
+                return false;
+            if(value32 < this->http.responseHeaders.size())
+            {
+                this->respondString(this->http.responseHeaders[value32].first);
+                this->respondString(this->http.responseHeaders[value32].second);
+            }
+            else
+            {
+                this->respondString("");
+                this->respondString("");
+            }
+            return true;
+
+        case Commands::sendPostHttp:
+            if(!this->readPayload(payload))
+                return false;
+            this->respond32(static_cast<std::uint32_t>(this->httpRequest("POST", payload.data(), payload.size())));
+            return true;
+
+        case Commands::requestHTTP:
+        {
+            std::string method;
+            if(!this->readHttpRequest(method) || !this->readPayload(payload))
+                return false;
+            const std::int32_t code = this->httpRequest(method.c_str(), payload.empty() ? nullptr : payload.data(), payload.size());
+            this->respondString(this->httpReply(code));
+            return true;
+        }
+
+        case Commands::beginStreamHTTP:
+        {
+            std::string method;
+            if(!this->readHttpRequest(method) || !this->read32(value32))
+                return false;
+
+            // an unknown length goes out with chunked transfer encoding
+            this->http.chunkedBody = (value32 == 0xFFFFFFFF);
+            const std::string head = this->httpHead(method, this->http.chunkedBody ? "Transfer-Encoding: chunked\r\n" : "Content-Length: " + std::to_string(value32) + "\r\n");
+            if(this->httpConnect() < 0 || !sendAll(this->httpSocket, reinterpret_cast<const std::uint8_t*>(head.data()), head.size()))
+            {
+                this->closeHttpSocket();
+                this->respond(Response::Error);
+                return true;
+            }
+            this->http.streaming = true;
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::sendStreamHTTP:
+        {
+            if(!this->readPayload(payload))
+                return false;
+            if(!this->http.streaming || this->httpSocket < 0)
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+
+            if(this->http.chunkedBody && !payload.empty())
+            {
+                char size[16];
+                const int length = std::snprintf(size, sizeof(size), "%zx\r\n", payload.size());
+                payload.insert(payload.begin(), size, size + length);
+                payload.push_back('\r');
+                payload.push_back('\n');
+            }
+            const bool sent = sendAll(this->httpSocket, payload.data(), payload.size());
+            if(!sent)
+            {
+                this->closeHttpSocket();
+                this->http.streaming = false;
+            }
+            this->respond(sent ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::endStreamHTTP:
+        {
+            std::int32_t code = httpErrorNotConnected;
+            if(this->http.streaming && this->httpSocket >= 0)
+            {
+                static const std::uint8_t lastChunk[] = { '0', '\r', '\n', '\r', '\n' };
+                std::string raw;
+                if(this->http.chunkedBody && !sendAll(this->httpSocket, lastChunk, sizeof(lastChunk)))
+                    code = httpErrorSendPayloadFailed;
+                else
+                    code = this->httpReceive(raw);
+                code = (code < 0) ? code : this->httpParse(raw);
+                if(code < 0)
+                    this->closeHttpSocket();
+            }
+            this->http.streaming = false;
+            this->respondString(this->httpReply(code));
+            return true;
+        }
+
+        //
+        // ESP_NOW
+        //
+
+        case Commands::espNowInit:
+        {
+            this->espNowActive = true;
+            if(this->config.espNowPort != 0 && this->espNowSocket < 0)
+            {
+                this->espNowSocket = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+                sockaddr_in address;
+                std::memset(&address, 0, sizeof(address));
+                address.sin_family = AF_INET;
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                address.sin_port = htons(this->config.espNowPort);
+                if(::bind(this->espNowSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+                {
+                    ::close(this->espNowSocket);
+                    this->espNowSocket = -1;
+                }
+            }
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::espNowAddPeer:
+        case Commands::espNowAddPeerBinary:
+        {
+            std::uint8_t peer[6];
+            if(!this->read8(id) || !(command == Commands::espNowAddPeer ? this->readString(text) : this->readBytes(peer, sizeof(peer))))
+                return false;
+            this->respond(this->espNowActive ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::espNowRemovePeer:
+        case Commands::espNowRemovePeerBinary:
+        {
+            std::uint8_t peer[6];
+            if(!(command == Commands::espNowRemovePeer ? this->readString(text) : this->readBytes(peer, sizeof(peer))))
+                return false;
+            this->respond(this->espNowActive ? Response::Ok : Response::Error);
+            return true;
+        }
+
+        case Commands::espNowSend:
+        case Commands::espNowSendBinary:
+        {
+            std::uint8_t peer[6];
+            if(!(command == Commands::espNowSend ? this->readString(text) : this->readBytes(peer, sizeof(peer))) || !this->readPayload(payload))
+                return false;
+            if(!this->espNowActive || payload.size() > 250)
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+
+            if(this->config.espNowPeerPort != 0 && this->espNowSocket >= 0)
+            {
+                std::vector<std::uint8_t> datagram(this->mac, this->mac + 6);
+                datagram.insert(datagram.end(), payload.begin(), payload.end());
+
+                sockaddr_in address;
+                std::memset(&address, 0, sizeof(address));
+                address.sin_family = AF_INET;
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                address.sin_port = htons(this->config.espNowPeerPort);
+                ::sendto(this->espNowSocket, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            }
+            else
+            {
+                EspNowFrame frame;
+                std::memcpy(frame.sender, this->mac, sizeof(frame.sender));
+                frame.data = payload;
+                this->espNowFrames.push_back(frame);
+            }
+            this->respond(Response::Ok);
+            return true;
+        }
+
+        case Commands::espNowReceive:
+        {
+            this->pollEspNow();
+            if(this->espNowFrames.empty())
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+
+            EspNowReceiveInfo info;
+            std::memset(&info, 0, sizeof(info));
+            const EspNowFrame &frame = this->espNowFrames.front();
+            std::memcpy(info.Sender, frame.sender, sizeof(info.Sender));
+            std::memcpy(info.Data, frame.data.data(), frame.data.size());
+            info.Size = frame.data.size();
+            this->espNowFrames.pop_front();
+            this->respondData(&info, sizeof(info));
+            return true;
+        }
+
+        case Commands::espNowDeInit:
+            this->espNowActive = false;
+            this->respond(Response::Ok);
+            return true;
+
+        //
+        // crypto
+        //
+
+        case Commands::sha1:
+        {
+            if(!this->readPayload(payload))
+                return false;
+
+            std::uint8_t hash[20];
+            ::sha1(payload.data(), payload.size(), hash);
+            this->respondData(hash, sizeof(hash));
+            return true;
+        }
+
+        //
+        // link
+        //
+
+        //
+        // sockets
+        //
+
+        case Commands::getSocketStatus:
+        {
+            SocketStatus status;
+            std::memset(&status, 0, sizeof(status));
+            for(std::size_t i = 0; i < 5; ++i)
+            {
+                if(isConnected(this->tcp[i]))
+                    status.tcpConnected |= static_cast<std::uint8_t>(1 << i);
+                if(this->udp[i] >= 0)
+                    status.udpOpen |= static_cast<std::uint8_t>(1 << i);
+                status.tcpAvailable[i] = static_cast<std::uint16_t>(std::min<std::size_t>(pendingBytes(this->tcp[i]), 0xFFFF));
+                status.udpAvailable[i] = static_cast<std::uint16_t>(std::min<std::size_t>(pendingBytes(this->udp[i]), 0xFFFF));
+            }
+            this->respondData(&status, sizeof(status));
+            return true;
+        }
+
+        case Commands::sendChunkTCP:
+            if(!this->read8(id) || !this->readPayload(payload))
+                return false;
+            // sends block until the kernel took everything, the buffer is empty again
+            if(this->validId(id) && this->tcp[id] >= 0 && sendAll(this->tcp[id], payload.data(), payload.size()))
+                this->respond16(this->config.sendBufferSize);
+            else
+                this->respond(Response::Error);
+            return true;
+
+        case Commands::readSomeTCP:
+        {
+            if(!this->read8(id) || !this->read16(value16))
+                return false;
+
+            std::vector<std::uint8_t> buffer(std::min<std::size_t>(value16, this->config.maxReadSize));
+            ssize_t count = 0;
+            if(this->validId(id) && this->tcp[id] >= 0 && !buffer.empty())
+                count = ::recv(this->tcp[id], buffer.data(), buffer.size(), MSG_DONTWAIT);
+            this->respondData(buffer.data(), count > 0 ? static_cast<std::size_t>(count) : 0);
+            if(this->validId(id))
+                this->tcpReadable[id] = false;
+            return true;
+        }
+
+        //
+        // events
+        //
+
+        case Commands::setEventMask:
+            if(!this->read16(value16))
+                return false;
+            // the legacy framing can not tell events from replies
+            if(this->linkMode == LinkMode::Legacy && value16 != 0)
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+            this->eventMask = value16;
+            this->respond(Response::Ok);
+            return true;
+
+        case Commands::setLinkMode:
+            if(!this->read8(id))
+                return false;
+            if(id > static_cast<std::uint8_t>(LinkMode::Framed))
+            {
+                this->respond(Response::Error);
+                return true;
+            }
+            // acknowledged in the old mode
+            this->respond(Response::Ok);
+            this->flushResponse();
+            this->linkMode = static_cast<LinkMode>(id);
+            this->expectedSeq = 1;
+            this->resendAsked = false;
+            return true;
+
+        case Commands::echo:
+            if(!this->readPayload(payload))
+                return false;
+            this->respondData(payload.data(), payload.size());
+            return true;
+
+        case Commands::probeBaudRate:
+            if(!this->read32(value32) || !this->read16(value16))
+                return false;
+            // acknowledged at the old rate, which comes back unless kept in time
+            this->respond(Response::Ok);
+            this->flushResponse();
+            if(!this->probing)
+                this->probeFallback = this->config.baud;
+            this->probing = true;
+            this->probeDeadline = Clock::now() + std::chrono::milliseconds(value16);
+            this->config.baud = value32;
+            return true;
+
+        case Commands::setCompression:
+            if(!this->read8(id))
+                return false;
+            // acknowledged as it was
+            this->respond(Response::Ok);
+            this->flushResponse();
+            this->compression = (id != 0);
+            return true;
+    }
+
+    this->respond(Response::Error);
+    return true;
+}
+
+void ESP8266Emulator::sendEvent(const EventType type, const std::uint8_t id, const std::size_t value)
+{
+    if((this->eventMask & (1u << static_cast<unsigned>(type))) == 0)
+        return;
+
+    const std::uint16_t code = static_cast<std::uint16_t>(Response::Event);
+    const std::uint16_t clamped = static_cast<std::uint16_t>(std::min<std::size_t>(value, 0xFFFF));
+    const std::uint8_t payload[8] =
+    {
+        static_cast<std::uint8_t>(code & 0xFF),
+        static_cast<std::uint8_t>(code >> 8),
+        4,
+        0,
+        static_cast<std::uint8_t>(type),
+        id,
+        static_cast<std::uint8_t>(clamped & 0xFF),
+        static_cast<std::uint8_t>(clamped >> 8),
+    };
+
+    if(this->linkMode == LinkMode::Framed)
+    {
+        this->sendFrame(0, payload, sizeof(payload));
+        return;
+    }
+
+    const std::uint8_t seq = 0;
+    this->writeBytes(&seq, 1);
+    this->writeBytes(payload, sizeof(payload));
+}
+
+void ESP8266Emulator::pollEvents(void)
+{
+    if(this->eventMask == 0 || this->linkMode == LinkMode::Legacy)
+        return;
+
+    for(std::uint8_t id = 0; id < 5; ++id)
+    {
+        // a new socket starts with nothing reported
+        if(this->tcpWatched[id] != this->tcp[id])
+        {
+            this->tcpWatched[id] = this->tcp[id];
+            this->tcpReadable[id] = false;
+            this->tcpClosed[id] = false;
+        }
+        if(this->udpWatched[id] != this->udp[id])
+        {
+            this->udpWatched[id] = this->udp[id];
+            this->udpReadable[id] = false;
+        }
+
+        if(this->tcp[id] >= 0 && !this->tcpClosed[id])
+        {
+            const std::size_t pending = pendingBytes(this->tcp[id]);
+            if(pending != 0 && !this->tcpReadable[id])
+            {
+                this->tcpReadable[id] = true;
+                this->sendEvent(EventType::TcpReadable, id, pending);
+            }
+
+            std::uint8_t peek;
+            if(pending == 0 && ::recv(this->tcp[id], &peek, 1, MSG_PEEK | MSG_DONTWAIT) == 0)
+            {
+                this->tcpClosed[id] = true;
+                this->sendEvent(EventType::TcpClosed, id, 0);
+            }
+        }
+
+        if(this->udp[id] >= 0 && !this->udpReadable[id])
+        {
+            const std::size_t pending = pendingBytes(this->udp[id]);
+            if(pending != 0)
+            {
+                this->udpReadable[id] = true;
+                this->sendEvent(EventType::UdpReadable, id, pending);
+            }
+        }
+    }
+
+    this->pollEspNow();
+    this->espNowReported = std::min(this->espNowReported, this->espNowFrames.size());
+    while(this->espNowReported < this->espNowFrames.size())
+    {
+        this->sendEvent(EventType::EspNowReceived, 0, this->espNowFrames[this->espNowReported].data.size());
+        this->espNowReported++;
+    }
+
+    if(this->reportedStatus != this->wifiStatus)
+    {
+        this->reportedStatus = this->wifiStatus;
+        this->sendEvent(EventType::WifiStatusChanged, 0, static_cast<std::size_t>(this->wifiStatus));
+    }
+}
+
+void ESP8266Emulator::pollEspNow(void)
+{
+    if(this->espNowSocket < 0)
+        return;
+
+    std::uint8_t datagram[6 + 250];
+    while(true)
+    {
+        const ssize_t count = ::recv(this->espNowSocket, datagram, sizeof(datagram), MSG_DONTWAIT);
+        if(count < 6)
+            return;
+
+        EspNowFrame frame;
+        std::memcpy(frame.sender, datagram, sizeof(frame.sender));
+        frame.data.assign(datagram + 6, datagram + count);
+        this->espNowFrames.push_back(frame);
+    }
+}
+
+//
+// HTTP client, plain HTTP only: TLS is not emulated
+//
+
+void ESP8266Emulator::closeHttpSocket(void)
+{
+    if(this->httpSocket >= 0)
+        ::close(this->httpSocket);
+    this->httpSocket = -1;
+}
+
+bool ESP8266Emulator::readHttpRequest(std::string &method)
+{
+    std::uint8_t https, count;
+    std::uint16_t port;
+    std::string host, uri, name, value;
+    if(!this->read8(https) || !this->read16(port) || !this->readString(host) || !this->readString(uri) ||
+       !this->readString(method) || !this->read8(count))
+        return false;
+
+    this->http = HttpState();
+    this->http.created = true;
+    this->http.https = (https != 0);
+    this->http.port = port;
+    this->http.host = host;
+    this->http.uri = uri;
+    for(std::uint8_t i = 0; i < count; ++i)
+    {
+        if(!this->readString(name) || !this->readString(value))
+            return false;
+        this->http.requestHeaders.push_back(std::make_pair(name, value));
+    }
+
+    if(!this->read8(count))
+        return false;
+    for(std::uint8_t i = 0; i < count; ++i)
+    {
+        if(!this->readString(name))
+            return false;
+        this->http.collectHeaders.push_back(toLower(name));
+    }
+    return true;
+}
+
+std::string ESP8266Emulator::httpHead(const std::string &method, const std::string &bodyHeader) const
+{
+    std::string head = method + " " + this->http.uri + " HTTP/1.1\r\n";
+    head += "Host: " + this->http.host + "\r\n";
+    head += "User-Agent: ESP8266HTTPClient\r\n";
+    head += this->httpReuse ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for(const auto &header : this->http.requestHeaders)
+        head += header.first + ": " + header.second + "\r\n";
+    head += bodyHeader;
+    head += "\r\n";
+    return head;
+}
+
+std::string ESP8266Emulator::httpReply(const std::int32_t code) const
+{
+    // code, Content-Length and header count lines, then a name and a value line per header
+    std::string headers;
+    std::size_t found = 0;
+    for(const auto &name : this->http.collectHeaders)
+    {
+        for(const auto &header : this->http.responseHeaders)
+        {
+            if(toLower(header.first) != name)
+                continue;
+            headers += header.first + "\n" + header.second + "\n";
+            found++;
+        }
+    }
+    return std::to_string(code) + "\n" + std::to_string(this->http.contentLength) + "\n" + std::to_string(found) + "\n" + headers;
+}
+
+std::int32_t ESP8266Emulator::httpConnect(void)
+{
+    HttpState &http = this->http;
+    http.responseHeaders.clear();
+    http.body.clear();
+    http.offset = 0;
+    http.contentLength = -1;
+
+    if(!http.created)
+        return httpErrorNotConnected;
+    if(http.https)
+        return httpErrorConnectionRefused;
+
+    // a kept connection only serves the server it was opened to
+    if(this->httpSocket >= 0 && (this->httpSocketHost != http.host || this->httpSocketPort != http.port))
+        this->closeHttpSocket();
+    if(this->httpSocket >= 0)
+        return 0;
+
+    this->httpSocket = connectTcp(http.host, http.port, 5000);
+    if(this->httpSocket < 0)
+        return httpErrorConnectionRefused;
+
+    this->httpSocketHost = http.host;
+    this->httpSocketPort = http.port;
+    this->httpConnectCount++;
+    if(this->config.connectLatencyUs != 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(this->config.connectLatencyUs));
+    return 0;
+}
+
+std::int32_t ESP8266Emulator::httpReceive(std::string &raw)
+{
+    raw.clear();
+    bool untilClose = false;
+    while(true)
+    {
+        const std::size_t length = httpResponseLength(raw, untilClose);
+        if(length != std::string::npos)
+        {
+            raw.resize(length);
+            break;
+        }
+
+        pollfd descriptor = { this->httpSocket, POLLIN, 0 };
+        if(::poll(&descriptor, 1, 5000) != 1)
+            return httpErrorReadTimeout;
+
+        char buffer[4096];
+        const ssize_t count = ::recv(this->httpSocket, buffer, sizeof(buffer), 0);
+        if(count <= 0)
+        {
+            if(untilClose)
+                break;
+            if(!raw.empty() && raw.find("\r\n\r\n") == std::string::npos)
+                return httpErrorNoHttpServer;
+            return httpErrorConnectionLost;
+        }
+        raw.append(buffer, static_cast<std::size_t>(count));
+    }
+
+    // keep the connection only when both sides agree to
+    const std::string headers = toLower(raw.substr(0, raw.find("\r\n\r\n") + 4));
+    const bool keepAlive = (headers.compare(0, 8, "http/1.1") == 0)
+        ? headers.find("\r\nconnection: close\r\n") == std::string::npos
+        : headers.find("\r\nconnection: keep-alive\r\n") != std::string::npos;
+    if(!this->httpReuse || untilClose || !keepAlive)
+        this->closeHttpSocket();
+
+    return 0;
+}
+
+std::int32_t ESP8266Emulator::httpExchange(const std::string &request, const std::uint8_t* body, const std::size_t size, std::string &raw)
+{
+    raw.clear();
+    const std::int32_t result = this->httpConnect();
+    if(result < 0)
+        return result;
+
+    if(!sendAll(this->httpSocket, reinterpret_cast<const std::uint8_t*>(request.data()), request.size()) || (size != 0 && !sendAll(this->httpSocket, body, size)))
+        return httpErrorSendHeaderFailed;
+
+    return this->httpReceive(raw);
+}
+
+std::int32_t ESP8266Emulator::httpRequest(const char* method, const std::uint8_t* body, const std::size_t size)
+{
+    const std::string request = this->httpHead(method, body != nullptr ? "Content-Length: " + std::to_string(size) + "\r\n" : "");
+
+    // the server may have closed a kept connection meanwhile, then once more on a new one
+    const bool reused = (this->httpSocket >= 0);
+    std::string raw;
+    std::int32_t result = this->httpExchange(request, body, size, raw);
+    if(result < 0 && reused && raw.empty())
+    {
+        this->closeHttpSocket();
+        result = this->httpExchange(request, body, size, raw);
+    }
+    if(result < 0)
+    {
+        this->closeHttpSocket();
+        return result;
+    }
+
+    return this->httpParse(raw);
+}
+
+std::int32_t ESP8266Emulator::httpParse(const std::string &raw)
+{
+    HttpState &http = this->http;
+    const std::size_t headerEnd = raw.find("\r\n\r\n");
+    if(raw.compare(0, 5, "HTTP/") != 0 || headerEnd == std::string::npos)
+        return httpErrorNoHttpServer;
+
+    const std::size_t space = raw.find(' ');
+    const std::int32_t code = std::atoi(raw.c_str() + space + 1);
+
+    bool chunked = false;
+    std::size_t line = raw.find("\r\n") + 2;
+    while(line < headerEnd)
+    {
+        const std::size_t end = raw.find("\r\n", line);
+        const std::size_t colon = raw.find(':', line);
+        if(colon != std::string::npos && colon < end)
+        {
+            std::string name = raw.substr(line, colon - line);
+            std::string value = raw.substr(colon + 1, end - colon - 1);
+            value.erase(0, value.find_first_not_of(' '));
+
+            const std::string lower = toLower(name);
+            if(lower == "content-length")
+                http.contentLength = std::atoi(value.c_str());
+            else if(lower == "transfer-encoding" && toLower(value) == "chunked")
+                chunked = true;
+
+            http.responseHeaders.push_back(std::make_pair(name, value));
+        }
+        line = end + 2;
+    }
+
+    if(!chunked)
+    {
+        http.body = raw.substr(headerEnd + 4);
+        return code;
+    }
+
+    std::size_t position = headerEnd + 4;
+    while(position < raw.size())
+    {
+        const std::size_t end = raw.find("\r\n", position);
+        if(end == std::string::npos)
+            break;
+
+        const std::size_t length = std::strtoul(raw.c_str() + position, nullptr, 16);
+        if(length == 0)
+            break;
+
+        http.body.append(raw, end + 2, length);
+        position = end + 2 + length + 2;
+    }
+
+    return code;
+}
+
+#endif
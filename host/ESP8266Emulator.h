@@ -0,0 +1,239 @@
+#pragma once
+
+#ifdef ESP8266_POSIX
+
+#include "../ESP8266.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <netinet/in.h>
+
+/// @brief
+/// Link and behaviour settings of the emulator.
+///
+struct ESP8266EmulatorConfig
+{
+    /// Simulated UART speed in both directions, 0 for no limit.
+    std::uint32_t baud = 230400;
+
+    /// Delay before every response, models the coprocessor's processing time.
+    std::uint32_t responseLatencyUs = 0;
+
+    /// Random extra delay of up to this much per byte sent to the host.
+    std::uint32_t byteJitterUs = 0;
+
+    /// Probability of dropping a byte sent to the host.
+    double txLossRate = 0.0;
+
+    /// Probability of dropping a byte received from the host.
+    double rxLossRate = 0.0;
+
+    /// Seed of the jitter and loss generator, runs are reproducible.
+    std::uint32_t seed = 1;
+
+    /// Largest payload returned by one readTCP, readUDP or readDataHTTP.
+    std::uint16_t maxReadSize = 1024;
+
+    /// Delay of every new HTTP connection, models the TCP and TLS handshakes.
+    std::uint32_t connectLatencyUs = 0;
+
+    /// Room in the TCP send buffer, the credit reported after every sendChunkTCP.
+    std::uint16_t sendBufferSize = 4096;
+
+    /// Loopback UDP port receiving ESP-NOW frames, 0 delivers sent frames locally.
+    std::uint16_t espNowPort = 0;
+
+    /// Loopback UDP port ESP-NOW frames are sent to, the espNowPort of another emulator.
+    std::uint16_t espNowPeerPort = 0;
+
+    /// Highest rate the line carries cleanly, 0 for no limit. Above it
+    /// bytes sent to the host are garbled now and then.
+    std::uint32_t maxBaud = 0;
+};
+
+/// @brief
+/// Host stand-in for the ESP8266 firmware.
+///
+/// Speaks the Commands protocol of ESP8266.cpp on a file descriptor and
+/// bridges TCP, UDP and HTTP to real sockets, so the driver can be run and
+/// measured without hardware.
+///
+class ESP8266Emulator
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct HttpState
+    {
+        bool created = false;
+        bool https = false;
+        std::uint16_t port = 80;
+        std::string host;
+        std::string uri;
+        std::vector<std::pair<std::string, std::string>> requestHeaders;
+        std::vector<std::pair<std::string, std::string>> responseHeaders;
+        std::vector<std::string> collectHeaders;
+        bool streaming = false;
+        bool chunkedBody = false;
+        std::int32_t contentLength = -1;
+        std::string body;
+        std::size_t offset = 0;
+    };
+
+    struct EspNowFrame
+    {
+        std::uint8_t sender[6];
+        std::vector<std::uint8_t> data;
+    };
+
+    int fd;
+    ESP8266EmulatorConfig config;
+    std::atomic<bool> running;
+    std::thread thread;
+    std::mt19937 random;
+
+    std::vector<std::uint8_t> input;
+    std::size_t inputOffset;
+    Clock::time_point rxLineFree;
+    Clock::time_point txLineFree;
+    std::vector<std::uint8_t> response;
+    LinkMode linkMode;
+    bool compression;
+    std::uint8_t seq;
+
+    // LinkMode::Framed
+    std::uint8_t expectedSeq;
+    bool resendAsked;
+    std::size_t frameEnd;
+    std::vector<std::uint8_t> replies[256];
+
+    // a probed rate goes back to probeFallback unless setBaudRate keeps it in time
+    bool probing;
+    std::uint32_t probeFallback;
+    Clock::time_point probeDeadline;
+
+    std::atomic<std::uint64_t> bytesReceived;
+    std::atomic<std::uint64_t> bytesSent;
+    std::atomic<std::uint64_t> commandCount;
+
+    // WiFi
+    WiFiMode wifiMode;
+    WifiStatus wifiStatus;
+    std::string ssid;
+    std::vector<NetworkInfo> networks;
+    bool scanDone;
+    std::string softAPSsid;
+    std::string softAPPassphrase;
+
+    // sockets
+    int tcp[5];
+    int udp[5];
+    sockaddr_in udpTarget[5];
+    sockaddr_in udpRemote[5];
+
+    HttpState http;
+    int httpSocket;
+    std::string httpSocketHost;
+    std::uint16_t httpSocketPort;
+    bool httpReuse;
+    std::atomic<std::uint64_t> httpConnectCount;
+
+    // ESP-NOW
+    bool espNowActive;
+    int espNowSocket;
+    std::uint8_t mac[6];
+    std::deque<EspNowFrame> espNowFrames;
+
+    // events, each one is reported once until the host reads
+    std::uint16_t eventMask;
+    int tcpWatched[5];
+    bool tcpReadable[5];
+    bool tcpClosed[5];
+    int udpWatched[5];
+    bool udpReadable[5];
+    std::size_t espNowReported;
+    WifiStatus reportedStatus;
+
+private:
+    bool chance(const double rate);
+    void pollProbe(void);
+    void pace(Clock::time_point &lineFree, const std::size_t bytes);
+    bool fill(const int timeoutMs = 0);
+    bool readBytes(std::uint8_t* buffer, const std::size_t size, const int timeoutMs = 0);
+    bool read8(std::uint8_t &value);
+    bool read16(std::uint16_t &value);
+    bool read32(std::uint32_t &value);
+    bool readString(std::string &value);
+    bool readPayload(std::vector<std::uint8_t> &payload);
+    void writeBytes(const std::uint8_t* data, const std::size_t size);
+
+    void respond(const Response response);
+    void respondData(const void* data, const std::size_t size);
+    void respondString(const std::string &value);
+    void respond16(const std::uint16_t value);
+    void respond32(const std::uint32_t value);
+    void flushResponse(void);
+    bool readFrame(bool &execute);
+    void sendFrame(const std::uint8_t seq, const std::uint8_t* payload, const std::size_t size);
+
+    bool handle(const Commands command);
+    void reset(void);
+    void closeSockets(void);
+    bool validId(const std::uint8_t id) const;
+    void pollEspNow(void);
+    void pollEvents(void);
+    void sendEvent(const EventType type, const std::uint8_t id, const std::size_t value);
+
+    bool readHttpRequest(std::string &method);
+    std::string httpHead(const std::string &method, const std::string &bodyHeader) const;
+    std::string httpReply(const std::int32_t code) const;
+    std::int32_t httpConnect(void);
+    std::int32_t httpReceive(std::string &raw);
+    std::int32_t httpExchange(const std::string &request, const std::uint8_t* body, const std::size_t size, std::string &raw);
+    std::int32_t httpRequest(const char* method, const std::uint8_t* body, const std::size_t size);
+    std::int32_t httpParse(const std::string &raw);
+    void closeHttpSocket(void);
+
+public:
+    explicit ESP8266Emulator(const int fd, const ESP8266EmulatorConfig &config = ESP8266EmulatorConfig());
+    ~ESP8266Emulator();
+
+    ESP8266Emulator(const ESP8266Emulator&) = delete;
+    ESP8266Emulator& operator=(const ESP8266Emulator&) = delete;
+
+    /// @brief
+    /// Serve commands on a background thread.
+    ///
+    void start(void);
+
+    /// @brief
+    /// Stop the background thread started by start().
+    ///
+    void stop(void);
+
+    /// @brief
+    /// Serve commands until stop() is called or the descriptor is closed.
+    ///
+    void run(void);
+
+    /// @brief
+    /// Add an access point to the scan results, joinAP only succeeds for these.
+    ///
+    void addNetwork(const NetworkInfo &info);
+
+    std::uint64_t getBytesReceived(void) const;
+    std::uint64_t getBytesSent(void) const;
+    std::uint64_t getCommandCount(void) const;
+
+    /// @brief
+    /// Get the number of HTTP connections opened, reused ones are counted once.
+    ///
+    std::uint64_t getHttpConnectCount(void) const;
+};
+
+#endif
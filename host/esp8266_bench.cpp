@@ -0,0 +1,237 @@
+///
+/// @file esp8266_bench.cpp
+/// @brief Round trip latency and payload throughput of the hot commands.
+///
+/// Runs ESP8266 against ESP8266Emulator over a socketpair, the emulator
+/// bridging to echo and HTTP servers on the loopback interface, and
+/// reports operations per second and latency percentiles per command, as
+/// a table or as JSON to compare between versions.
+///
+/// Built by host/Makefile: make -C host esp8266_bench
+/// esp8266_bench_stats is the same with ESP8266_STATS, and also prints the
+/// per command counters of every run.
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include "TcpStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+/// @brief
+/// Send and read back until every byte returned, readTCP and readUDP hand
+/// out what arrived so far.
+///
+static bool roundTrip(const std::function<bool(void)> &send, const std::function<std::uint16_t(std::uint8_t*, std::uint16_t)> &read, std::uint8_t* buffer, const std::uint16_t size)
+{
+    if(!send())
+        return false;
+
+    std::uint16_t received = 0;
+    while(received < size)
+    {
+        const std::uint16_t count = read(buffer + received, static_cast<std::uint16_t>(size - received));
+        if(count == 0)
+            return false;
+        received += count;
+    }
+    return true;
+}
+
+/// @brief
+/// Write through a TcpStream and read the echo back through it.
+///
+static bool streamTrip(ESP8266 &esp, TcpStream &stream, const std::uint8_t* payload, std::uint8_t* buffer, const std::size_t size)
+{
+    if(stream.write(payload, size) != size || !stream.flush())
+        return false;
+
+    std::size_t received = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(received < size && std::chrono::steady_clock::now() < deadline)
+    {
+        esp.poll();
+        stream.update();
+        received += stream.read(buffer + received, size - received);
+    }
+    return received == size && std::memcmp(payload, buffer, size) == 0;
+}
+
+static void run(ESP8266 &esp, const LoopbackServers &servers, const std::uint32_t baud, const std::size_t iterations, const std::size_t bodySize, std::vector<BenchResult> &results)
+{
+    std::vector<std::uint8_t> payload(1024);
+    std::vector<std::uint8_t> buffer(payload.size());
+    for(std::size_t i = 0; i < payload.size(); i++)
+        payload[i] = static_cast<std::uint8_t>(i * 13);
+
+    results.push_back(measure("isPresent", baud, 0, iterations, [&esp]() { return esp.isPresent(); }));
+    results.push_back(measure("getStatus", baud, 0, iterations, [&esp]() { esp.getStatus(); return true; }));
+
+    if(esp.createTCP(0, "127.0.0.1", servers.getTcpPort()))
+    {
+        for(const std::uint16_t size : { 16, 256, 1024 })
+        {
+            results.push_back(measure("sendTCP+readTCP", baud, 2 * size, iterations, [&]()
+            {
+                return roundTrip([&]() { return esp.sendTCP(0, payload.data(), size); },
+                    [&](std::uint8_t* data, std::uint16_t count) { return esp.readTCP(0, data, count); }, buffer.data(), size);
+            }));
+        }
+
+        {
+            TcpStream stream(esp, 0);
+            for(const std::uint16_t size : { 16, 1024 })
+            {
+                results.push_back(measure("TcpStream", baud, 2 * size, iterations, [&]()
+                {
+                    return streamTrip(esp, stream, payload.data(), buffer.data(), size);
+                }));
+            }
+        }
+        esp.closeTCP(0);
+    }
+
+    if(esp.createUDP(0, "127.0.0.1", servers.getUdpPort()))
+    {
+        for(const std::uint16_t size : { 16, 256, 1024 })
+        {
+            results.push_back(measure("sendUDP+readUDP", baud, 2 * size, iterations, [&]()
+            {
+                return roundTrip([&]() { return esp.sendUDP(0, payload.data(), size); },
+                    [&](std::uint8_t* data, std::uint16_t count) { return esp.readUDP(0, data, count); }, buffer.data(), size);
+            }));
+        }
+        esp.closeUDP(0);
+    }
+
+    // the response is fetched again whenever it has been read
+    std::uint32_t left = 0;
+    esp.setReuseHTTP(true);
+    results.push_back(measure("readDataHTTP", baud, 1024, iterations, [&]()
+    {
+        if(left == 0)
+        {
+            esp.closeHTTP();
+            if(!esp.createHTTP("127.0.0.1", servers.getHttpPort(), "/bench") || esp.sendGetHTTP() != 200)
+                return false;
+            left = static_cast<std::uint32_t>(bodySize);
+        }
+        const std::uint32_t count = esp.readDataHTTP(buffer.data(), static_cast<std::uint16_t>(std::min<std::uint32_t>(left, 1024)));
+        left -= std::min(left, count);
+        return count != 0;
+    }));
+    esp.closeHTTP();
+    esp.setReuseHTTP(false);
+
+    if(esp.espNowInit())
+    {
+        const std::string mac = esp.getMac();
+        esp.espNowAddPeer(mac);
+        results.push_back(measure("espNowSend", baud, 250, iterations, [&]() { return esp.espNowSend(mac, payload.data(), 250); }));
+        esp.espNowDeInit();
+    }
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --baud N[,N...]  simulated baud rates, 0 for no limit (default 230400)\n"
+        "  --link-mode N    0 legacy, 1 pipelined, 2 framed (default 0)\n"
+        "  --iterations N   timed operations per benchmark (default 200)\n"
+        "  --body N         HTTP response body size (default 16384)\n"
+        "  --json           print the results as JSON\n",
+        name);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::uint32_t> bauds;
+    int linkMode = 0;
+    std::size_t iterations = 200;
+    std::size_t bodySize = 16384;
+    bool json = false;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "link-mode", required_argument, nullptr, 'l' },
+        { "iterations", required_argument, nullptr, 'n' },
+        { "body", required_argument, nullptr, 's' },
+        { "json", no_argument, nullptr, 'j' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b':
+                for(const char* rate = optarg; rate != nullptr; rate = std::strchr(rate, ','), rate = rate ? rate + 1 : nullptr)
+                    bauds.push_back(std::strtoul(rate, nullptr, 10));
+                break;
+            case 'l': linkMode = std::min(2, std::atoi(optarg)); break;
+            case 'n': iterations = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 's': bodySize = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 'j': json = true; break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+    if(bauds.empty())
+        bauds.push_back(230400);
+
+    LoopbackServers servers(bodySize);
+    if(!servers.isReady())
+    {
+        std::perror("servers");
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    std::vector<std::string> stats;
+    for(const std::uint32_t baud : bauds)
+    {
+        ESP8266EmulatorConfig config;
+        config.baud = baud;
+        EmulatorLink link(config);
+        if(!link.isReady())
+        {
+            std::perror("socketpair");
+            return 1;
+        }
+
+        ESP8266 esp(link.getTransport(), link.getClock());
+        if(esp.setLinkMode(static_cast<LinkMode>(linkMode)))
+            run(esp, servers, baud, iterations, bodySize, results);
+        else
+            std::fprintf(stderr, "%u baud: no link\n", static_cast<unsigned>(baud));
+
+#ifdef ESP8266_STATS
+        stats.push_back(std::to_string(baud) + " baud:");
+        esp.getStats().dump([&stats](const char* line) { stats.push_back(line); });
+#endif
+    }
+
+    if(json)
+        printJson(results, linkMode);
+    else
+        printTable(results);
+
+    // on stderr with --json, so stdout stays parseable
+    for(const std::string &line : stats)
+        std::fprintf(json ? stderr : stdout, "%s\n", line.c_str());
+
+    return countFailures(results) == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,167 @@
+///
+/// @file esp8266_compression_bench.cpp
+/// @brief Measures TCP echo throughput with and without link compression.
+///
+/// Runs ESP8266 against ESP8266Emulator over a socketpair, the emulator
+/// talking to a small echo server on the loopback interface. Every payload
+/// goes out with sendTCP() and comes back with readSomeTCP(), once as JSON
+/// like text and once as random bytes, which do not compress and are sent
+/// as they are.
+///
+/// Built by host/Makefile: make -C host esp8266_compression_bench
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <random>
+#include <string>
+#include <vector>
+
+/// @brief
+/// Records like a game server would send, scores and player names.
+///
+static std::vector<std::uint8_t> makeText(const std::size_t size)
+{
+    static const char* names[] = { "alice", "bob", "carol", "dave", "eve", "mallory" };
+    std::mt19937 random(7);
+    std::string text = "[";
+    for(std::size_t i = 0; text.size() < size; i++)
+    {
+        char record[128];
+        std::snprintf(record, sizeof(record), "{\"id\":%zu,\"name\":\"%s\",\"score\":%u,\"level\":%u,\"online\":%s},",
+            i, names[random() % 6], static_cast<unsigned>(random() % 100000), static_cast<unsigned>(random() % 50),
+            (random() & 1) ? "true" : "false");
+        text += record;
+    }
+    return std::vector<std::uint8_t>(text.begin(), text.begin() + size);
+}
+
+static std::vector<std::uint8_t> makeRandom(const std::size_t size)
+{
+    std::mt19937 random(11);
+    std::vector<std::uint8_t> data(size);
+    for(auto &value : data)
+        value = static_cast<std::uint8_t>(random());
+    return data;
+}
+
+/// @brief
+/// Echo the data chunk by chunk, every chunk is one operation, failed when
+/// it does not come back intact.
+///
+static BenchResult run(ESP8266 &esp, ESP8266Emulator &emulator, const std::string &name, const std::vector<std::uint8_t> &data,
+    const std::size_t chunkSize, const std::uint32_t baud, std::uint64_t &lineBytes)
+{
+    std::vector<std::uint8_t> echo(chunkSize);
+    const std::uint64_t before = emulator.getBytesReceived() + emulator.getBytesSent();
+
+    std::size_t offset = 0;
+    const std::size_t chunks = (data.size() + chunkSize - 1) / chunkSize;
+    const BenchResult result = measure(name, baud, chunkSize, chunks, [&]()
+    {
+        const std::uint16_t size = static_cast<std::uint16_t>(std::min(chunkSize, data.size() - offset));
+        const std::uint8_t* chunk = data.data() + offset;
+        offset += size;
+        if(!esp.sendTCP(0, chunk, size))
+            return false;
+
+        std::size_t received = 0;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(received < size && std::chrono::steady_clock::now() < deadline)
+            received += esp.readSomeTCP(0, echo.data() + received, static_cast<std::uint16_t>(size - received));
+
+        return received == size && std::memcmp(echo.data(), chunk, size) == 0;
+    }, 0);
+
+    lineBytes = emulator.getBytesReceived() + emulator.getBytesSent() - before;
+    return result;
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --baud N        simulated baud rate, 0 for no limit (default 230400)\n"
+        "  --link-mode N   0 legacy, 1 pipelined, 2 framed (default 0)\n"
+        "  --size N        bytes echoed per run (default 32768)\n"
+        "  --chunk N       bytes per sendTCP (default 1024)\n",
+        name);
+}
+
+int main(int argc, char** argv)
+{
+    ESP8266EmulatorConfig config;
+    int linkMode = 0;
+    std::size_t size = 32768;
+    std::size_t chunkSize = 1024;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "link-mode", required_argument, nullptr, 'l' },
+        { "size", required_argument, nullptr, 's' },
+        { "chunk", required_argument, nullptr, 'c' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b': config.baud = std::strtoul(optarg, nullptr, 10); break;
+            case 'l': linkMode = std::min(2, std::atoi(optarg)); break;
+            case 's': size = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 'c': chunkSize = std::min<std::size_t>(std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)), config.maxReadSize); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    LoopbackServers servers;
+    EmulatorLink link(config);
+    if(!servers.isReady() || !link.isReady())
+    {
+        std::perror("setup");
+        return 1;
+    }
+
+    ESP8266 esp(link.getTransport(), link.getClock());
+    if(!esp.setLinkMode(static_cast<LinkMode>(linkMode)) || !esp.createTCP(0, "127.0.0.1", servers.getTcpPort()))
+    {
+        std::fprintf(stderr, "setup: no connection\n");
+        return 1;
+    }
+
+    std::printf("%zu bytes in chunks of %zu, %u baud, link mode %d\n", size, chunkSize, static_cast<unsigned>(config.baud), linkMode);
+    const std::vector<std::uint8_t> payloads[2] = { makeText(size), makeRandom(size) };
+    const char* names[2] = { "text", "random" };
+    std::vector<BenchResult> results;
+    std::uint64_t lineBytes[4];
+    for(int payload = 0; payload < 2; payload++)
+    {
+        for(int compression = 0; compression < 2; compression++)
+        {
+            esp.setCompression(compression != 0);
+            const std::string name = std::string(names[payload]) + (compression ? " lzss" : " plain");
+            results.push_back(run(esp, link.getEmulator(), name, payloads[payload], chunkSize, config.baud, lineBytes[payload * 2 + compression]));
+        }
+    }
+
+    printTable(results);
+    for(std::size_t i = 0; i < results.size(); i++)
+        std::printf("%-12s %8llu line bytes\n", results[i].name.c_str(), static_cast<unsigned long long>(lineBytes[i]));
+
+    esp.setCompression(false);
+    esp.closeTCP(0);
+    return countFailures(results) == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,111 @@
+///
+/// @file esp8266_emulator.cpp
+/// @brief Runs ESP8266Emulator on a pty, so any program can open it like a serial port.
+///
+/// Built by host/Makefile: make -C host esp8266_emulator
+///
+
+#ifdef ESP8266_POSIX
+
+#include "ESP8266Emulator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <getopt.h>
+#include <termios.h>
+#include <unistd.h>
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --baud N          simulated baud rate, 0 for no limit (default 230400)\n"
+        "  --latency-us N    delay before every response\n"
+        "  --jitter-us N     random extra delay of up to N per byte sent\n"
+        "  --tx-loss P       probability of dropping a byte sent to the host\n"
+        "  --rx-loss P       probability of dropping a byte received from the host\n"
+        "  --seed N          seed of the jitter and loss generator\n"
+        "  --connect-latency-us N  delay of every new HTTP connection\n"
+        "  --max-read N      largest payload of one read command (default 1024)\n"
+        "  --send-buffer N   TCP send credit reported to the host (default 4096)\n"
+        "  --espnow-port N   loopback UDP port receiving ESP-NOW frames\n"
+        "  --espnow-peer N   loopback UDP port ESP-NOW frames are sent to\n"
+        "  --max-baud N      highest rate carried cleanly, bytes are garbled above it\n",
+        name);
+}
+
+int main(int argc, char** argv)
+{
+    ESP8266EmulatorConfig config;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "latency-us", required_argument, nullptr, 'l' },
+        { "jitter-us", required_argument, nullptr, 'j' },
+        { "tx-loss", required_argument, nullptr, 't' },
+        { "rx-loss", required_argument, nullptr, 'r' },
+        { "seed", required_argument, nullptr, 's' },
+        { "connect-latency-us", required_argument, nullptr, 'c' },
+        { "max-read", required_argument, nullptr, 'm' },
+        { "send-buffer", required_argument, nullptr, 'u' },
+        { "espnow-port", required_argument, nullptr, 'e' },
+        { "espnow-peer", required_argument, nullptr, 'p' },
+        { "max-baud", required_argument, nullptr, 'x' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b': config.baud = std::strtoul(optarg, nullptr, 10); break;
+            case 'l': config.responseLatencyUs = std::strtoul(optarg, nullptr, 10); break;
+            case 'j': config.byteJitterUs = std::strtoul(optarg, nullptr, 10); break;
+            case 't': config.txLossRate = std::strtod(optarg, nullptr); break;
+            case 'r': config.rxLossRate = std::strtod(optarg, nullptr); break;
+            case 's': config.seed = std::strtoul(optarg, nullptr, 10); break;
+            case 'c': config.connectLatencyUs = std::strtoul(optarg, nullptr, 10); break;
+            case 'm': config.maxReadSize = static_cast<std::uint16_t>(std::strtoul(optarg, nullptr, 10)); break;
+            case 'u': config.sendBufferSize = static_cast<std::uint16_t>(std::strtoul(optarg, nullptr, 10)); break;
+            case 'e': config.espNowPort = static_cast<std::uint16_t>(std::strtoul(optarg, nullptr, 10)); break;
+            case 'p': config.espNowPeerPort = static_cast<std::uint16_t>(std::strtoul(optarg, nullptr, 10)); break;
+            case 'x': config.maxBaud = std::strtoul(optarg, nullptr, 10); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0)
+    {
+        std::perror("posix_openpt");
+        return 1;
+    }
+
+    // keep the slave open in raw mode, otherwise the line discipline echoes
+    // and reads on the master fail while no client is connected
+    const char* path = ::ptsname(master);
+    const int slave = ::open(path, O_RDWR | O_NOCTTY);
+    termios settings;
+    if(slave < 0 || ::tcgetattr(slave, &settings) != 0)
+    {
+        std::perror(path);
+        return 1;
+    }
+    ::cfmakeraw(&settings);
+    ::tcsetattr(slave, TCSANOW, &settings);
+
+    std::printf("%s\n", path);
+    std::fflush(stdout);
+
+    ESP8266Emulator emulator(master, config);
+    emulator.run();
+
+    ::close(slave);
+    ::close(master);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,151 @@
+///
+/// @file esp8266_http_bench.cpp
+/// @brief Measures HTTP requests per second with and without connection reuse.
+///
+/// Runs ESP8266 against ESP8266Emulator over a socketpair, the emulator
+/// fetching from a small keep-alive HTTP server on the loopback interface.
+/// New connections are delayed to model the TCP and TLS handshakes.
+/// A second server answers with an empty body, which must end the
+/// download as well. Both servers send an ETag, and the same resource is
+/// then fetched through HttpCache, served from the cache after the first
+/// 304.
+///
+/// Built by host/Makefile: make -C host esp8266_http_bench
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include "HttpCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+/// @brief
+/// Fetch a different resource every time, only the host is shared, and
+/// count the connections the emulator opened.
+///
+static BenchResult run(const std::string &name, ESP8266 &esp, ESP8266Emulator &emulator, const std::uint16_t port, const bool reuse,
+    const std::size_t requests, const std::uint32_t baud, const std::size_t bodySize, std::uint64_t &connections)
+{
+    esp.setReuseHTTP(reuse);
+    const std::uint64_t opened = emulator.getHttpConnectCount();
+
+    std::size_t index = 0;
+    const BenchResult result = measure(name, baud, bodySize, requests, [&]()
+    {
+        const std::string uri = "/item/" + std::to_string(index++);
+        std::size_t received = 0;
+        const bool ok = esp.createHTTP("127.0.0.1", port, uri) && esp.sendGetHTTP() == 200 &&
+            esp.downloadHTTP([&received](const std::uint8_t*, std::uint16_t size) { received += size; return true; });
+        esp.closeHTTP();
+        return ok && received == bodySize;
+    }, 0);
+
+    connections = emulator.getHttpConnectCount() - opened;
+    esp.setReuseHTTP(false);
+    return result;
+}
+
+/// @brief
+/// Fetch the same resource through an HttpCache, every body must match.
+///
+static BenchResult runCache(const std::string &name, ESP8266 &esp, const std::uint16_t port, const std::size_t requests,
+    const std::uint32_t baud, const std::size_t bodySize, std::uint32_t &hits)
+{
+    HttpCache cache(esp, 4 * bodySize + 1024);
+    const BenchResult result = measure(name, baud, bodySize, requests, [&]()
+    {
+        std::string body;
+        const bool ok = cache.get("127.0.0.1", port, "/cached", body) == 200;
+        esp.closeHTTP();
+        return ok && body.size() == bodySize;
+    }, 0);
+
+    hits = cache.getHits();
+    return result;
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --baud N                simulated baud rate, 0 for no limit (default 230400)\n"
+        "  --connect-latency-ms N  delay of every new connection (default 250)\n"
+        "  --requests N            requests per run (default 20)\n"
+        "  --body N                response body size (default 512)\n",
+        name);
+}
+
+int main(int argc, char** argv)
+{
+    ESP8266EmulatorConfig config;
+    config.connectLatencyUs = 250000;
+    std::size_t requests = 20;
+    std::size_t bodySize = 512;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "connect-latency-ms", required_argument, nullptr, 'c' },
+        { "requests", required_argument, nullptr, 'n' },
+        { "body", required_argument, nullptr, 's' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b': config.baud = std::strtoul(optarg, nullptr, 10); break;
+            case 'c': config.connectLatencyUs = std::strtoul(optarg, nullptr, 10) * 1000; break;
+            case 'n': requests = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 's': bodySize = std::strtoul(optarg, nullptr, 10); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    LoopbackServers servers(bodySize, "\"body\"");
+    LoopbackServers empty(0, "\"empty\"");
+    EmulatorLink link(config);
+    if(!servers.isReady() || !empty.isReady() || !link.isReady())
+    {
+        std::perror("setup");
+        return 1;
+    }
+    ESP8266 esp(link.getTransport(), link.getClock());
+
+    std::printf("%zu requests of %zu bytes, %u baud, %u ms per new connection\n",
+        requests, bodySize, static_cast<unsigned>(config.baud), static_cast<unsigned>(config.connectLatencyUs / 1000));
+    std::vector<BenchResult> results;
+    std::uint64_t connections[4];
+    for(int reuse = 0; reuse < 2; reuse++)
+    {
+        results.push_back(run(reuse ? "reuse" : "close", esp, link.getEmulator(), servers.getHttpPort(), reuse != 0,
+            requests, config.baud, bodySize, connections[reuse]));
+    }
+    for(int reuse = 0; reuse < 2; reuse++)
+    {
+        results.push_back(run(reuse ? "reuse empty" : "close empty", esp, link.getEmulator(), empty.getHttpPort(), reuse != 0,
+            requests, config.baud, 0, connections[2 + reuse]));
+    }
+
+    std::uint32_t hits[2];
+    results.push_back(runCache("cache", esp, servers.getHttpPort(), requests, config.baud, bodySize, hits[0]));
+    results.push_back(runCache("cache empty", esp, empty.getHttpPort(), requests, config.baud, 0, hits[1]));
+
+    printTable(results);
+    std::printf("connections: %llu closing, %llu reusing, empty body %llu closing, %llu reusing\n",
+        static_cast<unsigned long long>(connections[0]), static_cast<unsigned long long>(connections[1]),
+        static_cast<unsigned long long>(connections[2]), static_cast<unsigned long long>(connections[3]));
+    std::printf("cache hits: %u of %zu, empty body %u of %zu\n",
+        static_cast<unsigned>(hits[0]), requests, static_cast<unsigned>(hits[1]), requests);
+    return countFailures(results) == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,253 @@
+///
+/// @file esp8266_string_bench.cpp
+/// @brief Compares the std::string and the caller's buffer string replies.
+///
+/// Records the string getters once against ESP8266Emulator, then replays
+/// the trace through ESP8266ReplayTransport with each kind of reply, so
+/// both run the same bytes without any link in the way. Every heap
+/// allocation is counted, and the time of a call is given in nanoseconds
+/// and in TSC cycles on x86.
+///
+/// Built by host/Makefile: make -C host esp8266_string_bench
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include "ESP8266Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <new>
+#include <string>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// @brief
+/// Heap use while counting, the replays run on a single thread.
+///
+struct HeapCounters
+{
+    bool counting;
+    std::size_t allocations;
+    std::size_t bytes;
+    std::size_t live;
+    std::size_t peak;
+};
+
+static HeapCounters heap;
+
+static void* allocate(const std::size_t size)
+{
+    // the size goes in front, so the frees count as well
+    void* block = std::malloc(size + sizeof(std::max_align_t));
+    if(block == nullptr)
+        throw std::bad_alloc();
+
+    *static_cast<std::size_t*>(block) = size;
+    if(heap.counting)
+    {
+        heap.allocations++;
+        heap.bytes += size;
+        heap.live += size;
+        heap.peak = std::max(heap.peak, heap.live);
+    }
+    return static_cast<std::uint8_t*>(block) + sizeof(std::max_align_t);
+}
+
+static void release(void* pointer)
+{
+    if(pointer == nullptr)
+        return;
+
+    void* block = static_cast<std::uint8_t*>(pointer) - sizeof(std::max_align_t);
+    if(heap.counting)
+        heap.live -= std::min(heap.live, *static_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { release(pointer); }
+
+static std::uint64_t cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static const std::size_t callsPerRound = 7;
+
+/// @brief
+/// The string getters, with std::string replies.
+///
+static std::size_t readStrings(ESP8266 &esp)
+{
+    std::size_t total = 0;
+    total += esp.getVersionString().size();
+    total += esp.getSSID().size();
+    total += esp.getLocalIP().size();
+    total += esp.getGatewayIP().size();
+    total += esp.getSubnetMask().size();
+    total += esp.getMac().size();
+
+    std::string ip, mac;
+    esp.getSoftAPClient(0, ip, mac);
+    total += ip.size() + mac.size();
+    return total;
+}
+
+/// @brief
+/// The same getters, into InlineString buffers.
+///
+static std::size_t readInline(ESP8266 &esp)
+{
+    InlineString<32> text;
+    InlineString<17> mac;
+    std::size_t total = 0;
+
+    esp.getVersionString(text);
+    total += text.size();
+    esp.getSSID(text);
+    total += text.size();
+    esp.getLocalIP(text);
+    total += text.size();
+    esp.getGatewayIP(text);
+    total += text.size();
+    esp.getSubnetMask(text);
+    total += text.size();
+    esp.getMac(mac);
+    total += mac.size();
+
+    esp.getSoftAPClient(0, text, mac);
+    total += text.size() + mac.size();
+    return total;
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --rounds N      getter rounds per run (default 100)\n"
+        "  --iterations N  replays of each kind (default 200)\n",
+        name);
+}
+
+/// @brief
+/// Replay the trace with one kind of reply and print its costs.
+///
+static bool measure(const char* name, ESP8266ReplayTransport &transport, std::size_t (*workload)(ESP8266&), const std::size_t rounds, const std::size_t iterations, const std::size_t expected)
+{
+    heap = HeapCounters();
+    bool valid = true;
+    std::chrono::steady_clock::duration elapsed{};
+    std::uint64_t ticks = 0;
+
+    for(std::size_t i = 0; i < iterations; i++)
+    {
+        transport.rewind();
+        ESP8266 esp(transport, transport);
+
+        std::size_t total = 0;
+        heap.counting = true;
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t first = cycles();
+        for(std::size_t round = 0; round < rounds; round++)
+            total += workload(esp);
+        ticks += cycles() - first;
+        elapsed += std::chrono::steady_clock::now() - start;
+        heap.counting = false;
+
+        valid = valid && total == expected && transport.getMismatches() == 0 && transport.isDone();
+    }
+
+    const double calls = static_cast<double>(rounds * iterations * callsPerRound);
+    std::printf("%-12s %8.1f ns/call %8.0f cycles/call %6.2f allocs/call %7.1f bytes/call %5zu peak bytes%s\n", name,
+        std::chrono::duration<double, std::nano>(elapsed).count() / calls, ticks / calls,
+        heap.allocations / calls, heap.bytes / calls, heap.peak, valid ? "" : "  MISMATCH");
+    return valid;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t rounds = 100;
+    std::size_t iterations = 200;
+
+    static const option options[] =
+    {
+        { "rounds", required_argument, nullptr, 'r' },
+        { "iterations", required_argument, nullptr, 'i' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'r': rounds = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 'i': iterations = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    // record the getters once
+    std::FILE* file = std::tmpfile();
+    if(file == nullptr)
+    {
+        std::perror("esp8266_string_bench");
+        return 1;
+    }
+
+    ESP8266EmulatorConfig config;
+    config.baud = 0;
+    std::size_t expected = 0;
+    {
+        EmulatorLink link(config);
+        if(!link.isReady())
+        {
+            std::perror("esp8266_string_bench");
+            return 1;
+        }
+
+        ESP8266TraceTransport transport(link.getTransport(), link.getClock(), file);
+        ESP8266 esp(transport, link.getClock());
+        for(std::size_t round = 0; round < rounds; round++)
+            expected += readStrings(esp);
+    }
+
+    std::rewind(file);
+    ESP8266ReplayTransport transport(file);
+    std::fclose(file);
+    if(!transport.isValid())
+    {
+        std::fprintf(stderr, "esp8266_string_bench: the trace is not valid\n");
+        return 1;
+    }
+
+    std::printf("%zu rounds of %zu string getters, %zu replays each\n", rounds, callsPerRound, iterations);
+    bool valid = measure("std::string", transport, readStrings, rounds, iterations, expected);
+    valid = measure("InlineString", transport, readInline, rounds, iterations, expected) && valid;
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    std::printf("heap afterwards: %zu free chunks, %zu free bytes\n", info.ordblks, info.fordblks);
+#endif
+
+    return valid ? 0 : 1;
+}
+
+#endif
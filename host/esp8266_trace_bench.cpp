@@ -0,0 +1,202 @@
+///
+/// @file esp8266_trace_bench.cpp
+/// @brief Records a fixed workload into a trace, and replays it to time the parsing paths.
+///
+/// "record" runs the workload against ESP8266Emulator over a socketpair
+/// through ESP8266TraceTransport. "replay" runs the same workload against
+/// ESP8266ReplayTransport, as fast as possible, and checks that every run
+/// writes the recorded bytes and gets the same results.
+///
+/// Built by host/Makefile: make -C host esp8266_trace_bench
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include "ESP8266Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <string>
+
+/// @brief
+/// The commands of a typical session, the digest covers every reply.
+///
+static std::uint16_t workload(ESP8266 &esp, const LinkMode mode, const std::size_t rounds)
+{
+    std::uint16_t digest = Crc16::initial;
+    if(!esp.setLinkMode(mode))
+        return 0;
+
+    std::uint8_t pattern[1024];
+    for(std::size_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = static_cast<std::uint8_t>(i * 7 + (i >> 8));
+
+    for(std::size_t round = 0; round < rounds; round++)
+    {
+        digest = Crc16::update(digest, esp.isPresent() ? 1 : 0);
+
+        const std::string version = esp.getVersionString();
+        digest = Crc16::update(digest, reinterpret_cast<const std::uint8_t*>(version.data()), version.size());
+
+        static const std::uint16_t sizes[3] = { 16, 256, 1024 };
+        for(const std::uint16_t size : sizes)
+        {
+            std::uint8_t reply[sizeof(pattern)];
+            ESP8266Request request;
+            esp.echoAsync(request, pattern, size, reply);
+            if(esp.wait(request))
+                digest = Crc16::update(digest, reply, request.getSize());
+        }
+
+        std::uint8_t hash[20];
+        if(esp.sha1(pattern, 512, hash))
+            digest = Crc16::update(digest, hash, sizeof(hash));
+
+        SocketStatus status;
+        if(esp.getSocketStatus(status))
+            digest = Crc16::update(digest, status.tcpConnected);
+    }
+
+    esp.setLinkMode(LinkMode::Legacy);
+    return digest;
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s record|replay FILE [options]\n"
+        "  --baud N        simulated baud rate when recording, 0 for no limit (default 230400)\n"
+        "  --link-mode N   0 legacy, 1 pipelined, 2 framed (default 0)\n"
+        "  --rounds N      workload rounds (default 20)\n"
+        "  --iterations N  replays of the trace (default 100)\n",
+        name);
+}
+
+static int record(const char* path, const ESP8266EmulatorConfig &config, const LinkMode mode, const std::size_t rounds)
+{
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+    {
+        std::perror(path);
+        return 1;
+    }
+
+    std::uint16_t digest;
+    {
+        EmulatorLink link(config);
+        if(!link.isReady())
+        {
+            std::perror("socketpair");
+            std::fclose(file);
+            return 1;
+        }
+
+        ESP8266TraceTransport transport(link.getTransport(), link.getClock(), file);
+        ESP8266 esp(transport, link.getClock());
+        digest = workload(esp, mode, rounds);
+    }
+
+    const long size = std::ftell(file);
+    std::fclose(file);
+
+    std::printf("recorded %ld bytes, digest %04x\n", size, static_cast<unsigned>(digest));
+    return 0;
+}
+
+static int replay(const char* path, const LinkMode mode, const std::size_t rounds, const std::size_t iterations)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+    {
+        std::perror(path);
+        return 1;
+    }
+    ESP8266ReplayTransport transport(file);
+    std::fclose(file);
+    if(!transport.isValid())
+    {
+        std::fprintf(stderr, "%s: not a trace\n", path);
+        return 1;
+    }
+
+    std::uint16_t first = 0;
+    std::size_t failures = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < iterations; i++)
+    {
+        transport.rewind();
+        std::uint16_t digest;
+        {
+            ESP8266 esp(transport, transport);
+            digest = workload(esp, mode, rounds);
+        }
+
+        if(i == 0)
+            first = digest;
+        if(digest != first || transport.getMismatches() != 0 || transport.getDivergences() != 0 || !transport.isDone())
+        {
+            if(failures++ == 0)
+                std::printf("run %zu: digest %04x, %u mismatches, %u divergences, %s\n", i, static_cast<unsigned>(digest),
+                    static_cast<unsigned>(transport.getMismatches()), static_cast<unsigned>(transport.getDivergences()),
+                    transport.isDone() ? "done" : "records left");
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double bytes = static_cast<double>(transport.getRxSize()) * iterations;
+    std::printf("%zu replays, digest %04x, %.0f received bytes/s, %.1f us per run, %zu failed\n",
+        iterations, static_cast<unsigned>(first), bytes / elapsed.count(), elapsed.count() * 1e6 / iterations, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    ESP8266EmulatorConfig config;
+    int linkMode = 0;
+    std::size_t rounds = 20;
+    std::size_t iterations = 100;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "link-mode", required_argument, nullptr, 'l' },
+        { "rounds", required_argument, nullptr, 'r' },
+        { "iterations", required_argument, nullptr, 'i' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b': config.baud = std::strtoul(optarg, nullptr, 10); break;
+            case 'l': linkMode = std::min(2, std::atoi(optarg)); break;
+            case 'r': rounds = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 'i': iterations = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    if(argc - optind != 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const LinkMode mode = static_cast<LinkMode>(linkMode);
+    if(std::strcmp(argv[optind], "record") == 0)
+        return record(argv[optind + 1], config, mode, rounds);
+    if(std::strcmp(argv[optind], "replay") == 0)
+        return replay(argv[optind + 1], mode, rounds, iterations);
+
+    usage(argv[0]);
+    return 1;
+}
+
+#endif
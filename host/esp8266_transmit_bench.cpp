@@ -0,0 +1,288 @@
+///
+/// @file esp8266_transmit_bench.cpp
+/// @brief Compares the per-byte transmit path with writeBulk().
+///
+/// Sends the same payloads through a loop of one byte write() calls and
+/// through one writeBulk() call. The link is a model of
+/// ESP8266MbedTransport: a transmit ring of the same size and a line thread
+/// playing the TX interrupt, taking one byte per 8N1 byte time. The old
+/// putc() loop is the per-byte loop with only the 16 byte UART FIFO.
+///
+/// Reports the throughput up to the last byte on the line, and the time
+/// the caller spent blocked in the transport, which the game could have
+/// spent rendering.
+///
+/// Built by host/Makefile: make -C host esp8266_transmit_bench
+///
+
+#ifdef ESP8266_POSIX
+
+#include "BenchSupport.h"
+#include "Crc16.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <getopt.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief
+/// ESP8266MbedTransport with the UART replaced by a paced line thread.
+///
+/// Bytes written before a bulk payload are sent before it, the ones
+/// written after it wait, as in ESP8266MbedTransport::onTxInterrupt().
+/// Nothing is received.
+///
+class UartModelTransport : public ESP8266Transport
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+	std::uint32_t baud;
+	std::size_t txBufferSize;
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<std::uint8_t> txBuffer;
+	const std::uint8_t* bulkData;
+	std::size_t bulkSize;
+	std::size_t bulkLead;
+	std::function<void(void)> bulkCallback;
+	std::uint16_t lineCrc;
+	bool running;
+	std::thread line;
+
+private:
+    bool isIdle(void) const
+    {
+        return this->bulkSize == 0 && this->txBuffer.empty();
+    }
+
+    // one byte per byte time, late wake ups catch up so the rate holds
+    void run(void)
+    {
+        const auto byteTime = std::chrono::nanoseconds(10000000000ull / this->baud);
+        Clock::time_point lineFree = Clock::now();
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while(this->running)
+        {
+            if(this->isIdle())
+            {
+                this->changed.wait(lock);
+                lineFree = std::max(lineFree, Clock::now());
+                continue;
+            }
+
+            lock.unlock();
+            std::this_thread::sleep_until(lineFree + byteTime);
+            lock.lock();
+
+            const Clock::time_point now = Clock::now();
+            while(lineFree + byteTime <= now && !this->isIdle())
+            {
+                std::uint8_t value;
+                if(this->bulkSize != 0 && this->bulkLead == 0)
+                {
+                    value = *this->bulkData++;
+                    if(--this->bulkSize == 0 && this->bulkCallback)
+                        this->bulkCallback();
+                }
+                else
+                {
+                    value = this->txBuffer.front();
+                    this->txBuffer.pop_front();
+                    if(this->bulkSize != 0)
+                        this->bulkLead--;
+                }
+
+                this->lineCrc = Crc16::update(this->lineCrc, &value, 1);
+                lineFree += byteTime;
+            }
+            this->changed.notify_all();
+        }
+    }
+
+public:
+    /// @param txBufferSize - the bytes write() can queue before it blocks.
+    UartModelTransport(const std::uint32_t baud, const std::size_t txBufferSize)
+    : baud(baud), txBufferSize(txBufferSize), bulkData(nullptr), bulkSize(0), bulkLead(0), lineCrc(Crc16::initial), running(true)
+    {
+        this->line = std::thread([this]() { this->run(); });
+    }
+
+    ~UartModelTransport()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->running = false;
+        }
+        this->changed.notify_all();
+        this->line.join();
+    }
+
+    UartModelTransport(const UartModelTransport&) = delete;
+    UartModelTransport& operator=(const UartModelTransport&) = delete;
+
+    bool setBaudRate(const std::uint32_t baud) override { return baud == this->baud; }
+    std::uint32_t getBaudRate(void) const override { return this->baud; }
+    std::size_t available(void) override { return 0; }
+    std::size_t read(std::uint8_t* buffer, const std::size_t size) override { (void)buffer; (void)size; return 0; }
+    void flushRx(void) override {}
+
+    void write(const std::uint8_t* data, const std::size_t size) override
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        for(std::size_t i = 0; i < size; i++)
+        {
+            this->changed.wait(lock, [this]() { return this->txBuffer.size() < this->txBufferSize; });
+            this->txBuffer.push_back(data[i]);
+            this->changed.notify_all();
+        }
+    }
+
+    void writeBulk(const std::uint8_t* data, const std::size_t size, const std::function<void(void)> &callback) override
+    {
+        if(size == 0)
+        {
+            if(callback)
+                callback();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->changed.wait(lock, [this]() { return this->bulkSize == 0; });
+        this->bulkLead = this->txBuffer.size();
+        this->bulkData = data;
+        this->bulkSize = size;
+        this->bulkCallback = callback;
+        this->changed.notify_all();
+    }
+
+    bool isTxIdle(void) override
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->isIdle();
+    }
+
+    void flushTx(void) override
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->changed.wait(lock, [this]() { return this->isIdle(); });
+    }
+
+    /// @brief
+    /// Get the CRC of the bytes sent since the last call, and start over.
+    ///
+    std::uint16_t takeLineCrc(void)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        const std::uint16_t crc = this->lineCrc;
+        this->lineCrc = Crc16::initial;
+        return crc;
+    }
+};
+
+/// @brief
+/// Send the payload once per iteration and wait for the line to drain.
+/// The line must carry exactly the payload.
+///
+/// @param blocked - the mean time spent in the transport calls, in microseconds.
+///
+static BenchResult run(const std::string &name, UartModelTransport &transport, const bool bulk,
+    const std::vector<std::uint8_t> &payload, const std::size_t iterations, double &blocked)
+{
+    const std::uint16_t expected = Crc16::update(Crc16::initial, payload.data(), payload.size());
+    std::chrono::duration<double, std::micro> total(0);
+    std::size_t calls = 0;
+
+    const BenchResult result = measure(name, transport.getBaudRate(), payload.size(), iterations, [&]()
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        if(bulk)
+            transport.writeBulk(payload.data(), payload.size(), nullptr);
+        else
+        {
+            for(const std::uint8_t &value : payload)
+                transport.write(&value, 1);
+        }
+        total += std::chrono::steady_clock::now() - begin;
+        calls++;
+
+        transport.flushTx();
+        return transport.takeLineCrc() == expected;
+    });
+
+    blocked = total.count() / calls;
+    return result;
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --baud N        line baud rate (default 230400)\n"
+        "  --iterations N  sends per payload size (default 20)\n",
+        name);
+}
+
+int main(int argc, char** argv)
+{
+    std::uint32_t baud = 230400;
+    std::size_t iterations = 20;
+
+    static const option options[] =
+    {
+        { "baud", required_argument, nullptr, 'b' },
+        { "iterations", required_argument, nullptr, 'n' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    int option;
+    while((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch(option)
+        {
+            case 'b': baud = std::max<std::uint32_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            case 'n': iterations = std::max<std::size_t>(1, std::strtoul(optarg, nullptr, 10)); break;
+            default: usage(argv[0]); return option == 'h' ? 0 : 1;
+        }
+    }
+
+    // the LPC11U68 UART FIFO, and the transmit ring of ESP8266MbedTransport
+    UartModelTransport fifo(baud, 16);
+    UartModelTransport ring(baud, 128);
+    std::vector<BenchResult> results;
+    std::vector<double> blocked;
+    static const std::size_t sizes[] = { 16, 64, 256, 1024 };
+    for(const std::size_t size : sizes)
+    {
+        std::vector<std::uint8_t> payload(size);
+        for(std::size_t i = 0; i < size; i++)
+            payload[i] = static_cast<std::uint8_t>(i * 7 + (i >> 8));
+
+        double mean = 0;
+        results.push_back(run("putc loop", fifo, false, payload, iterations, mean));
+        blocked.push_back(mean);
+        results.push_back(run("write per byte", ring, false, payload, iterations, mean));
+        blocked.push_back(mean);
+        results.push_back(run("writeBulk", ring, true, payload, iterations, mean));
+        blocked.push_back(mean);
+    }
+
+    printTable(results);
+    std::printf("\n%-16s %7s %12s %10s\n", "operation", "payload", "blocked us", "blocked %");
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        const double wire = 1e6 / results[i].operationsPerSecond;
+        std::printf("%-16s %7zu %12.1f %10.1f\n", results[i].name.c_str(), results[i].payload, blocked[i], 100.0 * blocked[i] / wire);
+    }
+    return countFailures(results) == 0 ? 0 : 1;
+}
+
+#endif